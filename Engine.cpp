@@ -1,18 +1,95 @@
 #include "Engine.hpp"
+#include "v_cooker.hpp"
 
 #include <stdexcept>
 #include <array>
+#include <iostream>
 #include<cassert>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <filesystem>
+#include <numeric>
 
 namespace vwdw {
 
+// object space bounds -> world space, the box keeps its center/extent form so rotations stay tight
+static void transformBounds(const glm::mat4& m, const VModel::Bounds& bounds, glm::vec3& center, float& radius, glm::vec3& boxMin, glm::vec3& boxMax)
+{
+	glm::vec4 c = m * glm::vec4{ bounds.center, 1.0f };
+	center = glm::vec3{ c.x, c.y, c.z };
+
+	float scaleX = glm::length(glm::vec3{ m[0][0], m[0][1], m[0][2] });
+	float scaleY = glm::length(glm::vec3{ m[1][0], m[1][1], m[1][2] });
+	float scaleZ = glm::length(glm::vec3{ m[2][0], m[2][1], m[2][2] });
+	float maxScale = scaleX > scaleY ? scaleX : scaleY;
+	maxScale = maxScale > scaleZ ? maxScale : scaleZ;
+	radius = bounds.radius * maxScale;
+
+	// the sphere is centered on the box, so both share the transformed center
+	glm::vec3 localExtent = (bounds.max - bounds.min) * 0.5f;
+	glm::vec3 extent{ 0.0f };
+	for (int row = 0; row < 3; row++)
+	{
+		extent[row] = std::fabs(m[0][row]) * localExtent.x + std::fabs(m[1][row]) * localExtent.y + std::fabs(m[2][row]) * localExtent.z;
+	}
+	boxMin = center - extent;
+	boxMax = center + extent;
+}
+
 
-Engine::Engine()
+Engine::Engine(const EngineOptions& options) : options{ options }
 {
+	if (this->options.dynamicRendering && !vDevice.supportsDynamicRendering())
+	{
+		std::cout << "dynamic rendering not supported, using render passes" << std::endl;
+		this->options.dynamicRendering = false;
+	}
+	culler.setJobSystem(&jobSystem);
+	if (this->options.memoryBudgetMiB > 0)
+	{
+		vDevice.getMemoryBudget().limitBudget(static_cast<VkDeviceSize>(this->options.memoryBudgetMiB) << 20);
+	}
+	cookAssets();
+	if (this->options.runtimeShaders || this->options.hotReload)
+	{
+		shaderCompiler = std::make_unique<VShaderCompiler>(SHADER_CACHE_DIR);
+		vDevice.setShaderCompiler(shaderCompiler.get());
+	}
+	if (this->options.hotReload)
+	{
+		shaderWatcher = std::make_unique<VShaderWatcher>(*shaderCompiler, SHADER_SOURCE_DIR);
+	}
+	uniformRing = std::make_unique<VUniformRing>(vDevice, UNIFORM_RING_FRAME_SIZE, std::vector<VkDeviceSize>{ sizeof(FrameUniforms), sizeof(ObjectUniforms) });
+	if (vDevice.supportsDescriptorIndexing())
+	{
+		bindless = std::make_unique<VBindlessTable>(vDevice);
+	}
+	loadTextures();
 	loadModels();
 	createPipelineLayout();
+	// particles are simulated from the frame time, a replay leaves them out to stay deterministic
+	if (this->options.particleCount > 0 && this->options.replayPath.empty())
+	{
+		createParticles();
+	}
 	recreateSwapChain();
 	createCommandBuffers();
+	if (!this->options.captureDir.empty())
+	{
+		if (vSwapChain->supportsReadback() && VFrameCapture::isCapturable(vSwapChain->getSwapChainImageFormat()))
+		{
+			frameCapture = std::make_unique<VFrameCapture>(vDevice, this->options.captureDir, this->options.captureRaw ? CaptureFormat::Raw : CaptureFormat::Png);
+		}
+		else
+		{
+			std::cout << "the swapchain can't be read back, capture is off" << std::endl;
+		}
+	}
+	if (!this->options.drawCapturePath.empty() && this->options.replayPath.empty())
+	{
+		drawCapture = std::make_unique<VDrawCaptureWriter>(this->options.drawCapturePath, static_cast<uint32_t>(models.size()), static_cast<uint32_t>(textures.size()));
+	}
 }
 
 Engine::~Engine()
@@ -21,22 +98,115 @@ Engine::~Engine()
 }
 
 void Engine::run() {
+	if (!options.replayPath.empty())
+	{
+		runReplay();
+		return;
+	}
+	lastFrameTime = std::chrono::steady_clock::now();
+	if (options.pipelined)
+	{
+		simulation.start();
+	}
+	else
+	{
+		simulation.reset(lastFrameTime);
+	}
+	uint32_t frame = 0;
 	while (!vWindow.shouldClose()) {
 		glfwPollEvents();
+		VAllocationCounters before = readAllocationCounters();
 		drawFrame();
+		if (options.allocationCheckFrames > 0 && !checkAllocations(frame++, readAllocationCounters() - before))
+		{
+			break;
+		}
 	}
+	simulation.stop();
 
 	vkDeviceWaitIdle(vDevice.device());
+
+	std::cout << "simulation: " << simulation.stepCount() << " steps, " << simulation.snapshotsConsumed() << " snapshots rendered"
+		<< (options.pipelined ? " (pipelined)" : "") << std::endl;
+	// the first build counts as one of each
+	std::cout << "swapchain: " << swapChainRebuilds << " builds, " << vSwapChain->getDepthAllocationCount() << " depth allocations" << std::endl;
+	if (shaderCompiler)
+	{
+		std::cout << "shaders: " << shaderCompiler->compileCount() << " compiled, " << shaderCompiler->cacheHits() << " from the cache" << std::endl;
+	}
+	if (drawCapture)
+	{
+		drawCapture->close();
+		std::cout << "draw capture: " << drawCapture->frameCount() << " frames written to " << options.drawCapturePath << std::endl;
+	}
+	if (frameCapture)
+	{
+		// the encoders still working on the last frames are finished first
+		frameCapture->finish();
+		std::cout << "capture: " << frameCapture->writtenCount() << " frames written to " << options.captureDir << ", "
+			<< frameCapture->droppedCount() << " dropped, " << frameCapture->failedCount() << " failed" << std::endl;
+	}
+	const VMemoryBudget& budget = vDevice.getMemoryBudget();
+	for (size_t heap = 0; heap < budget.getHeaps().size(); heap++)
+	{
+		const auto& h = budget.getHeaps()[heap];
+		std::cout << "memory heap " << heap << (h.deviceLocal ? " (device local): " : ": ") << (h.usage >> 20) << " of " << (h.budget >> 20) << " MiB budget"
+			<< (budget.usesMemoryBudgetExtension() ? "" : " (estimated)") << ", " << h.evictions << " evictions (" << (h.evictedBytes >> 20) << " MiB)" << std::endl;
+	}
+	std::cout << "frame arena: " << frameArena.highWater() << " of " << FRAME_ARENA_SIZE << " bytes at peak, "
+		<< frameArena.overflowCount() << " allocations overflowed to the heap" << std::endl;
+
+	const auto& totals = renderQueue.getTotals();
+	std::cout << "render queue: " << totals.draws << " draws, "
+		<< totals.pipelineBinds << " pipeline binds (" << totals.pipelineBindsSkipped << " skipped), "
+		<< totals.vertexBinds << " vertex buffer binds (" << totals.vertexBindsSkipped << " skipped), "
+		<< totals.descriptorBinds << " descriptor set binds (" << totals.descriptorBindsSkipped << " skipped)" << std::endl;
+}
+
+bool Engine::checkAllocations(uint32_t frame, const VAllocationCounters& frameAllocations)
+{
+	if (frame < ALLOCATION_CHECK_WARMUP_FRAMES)
+	{
+		return true;
+	}
+	// printed between frames, so the output's own allocations aren't counted against either
+	if (frameAllocations.heapAllocations > 0 || frameAllocations.vulkanObjects > 0)
+	{
+		allocatingFrames++;
+		std::cout << "frame " << frame << ": " << frameAllocations.heapAllocations << " heap allocations ("
+			<< frameAllocations.heapBytes << " bytes), " << frameAllocations.vulkanObjects << " vulkan objects created" << std::endl;
+	}
+
+	uint32_t checked = frame + 1 - ALLOCATION_CHECK_WARMUP_FRAMES;
+	if (checked < options.allocationCheckFrames)
+	{
+		return true;
+	}
+	std::cout << "allocation check: " << allocatingFrames << " of " << checked << " frames allocated after "
+		<< ALLOCATION_CHECK_WARMUP_FRAMES << " warm-up frames" << (allocatingFrames == 0 ? ", passed" : ", FAILED") << std::endl;
+	return false;
 }
 
 void Engine::createPipelineLayout()
 {
+	VkPushConstantRange pushConstantRange{};
+	pushConstantRange.stageFlags = VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT;
+	pushConstantRange.offset = 0;
+	pushConstantRange.size = sizeof(VObjectPushConstants);
+
+	// one layout shared by every material: set 0 is the uniform ring, set 1 the bindless table
+	std::vector<VkDescriptorSetLayout> setLayouts{ uniformRing->getDescriptorSetLayout() };
+	if (bindless)
+	{
+		setLayouts.push_back(bindless->getDescriptorSetLayout());
+	}
+
 	VkPipelineLayoutCreateInfo pipelineLayoutInfo{};
-	pipelineLayoutInfo.pSetLayouts = nullptr;
+	pipelineLayoutInfo.pSetLayouts = setLayouts.data();
 	pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
-	pipelineLayoutInfo.pPushConstantRanges = nullptr;
-	pipelineLayoutInfo.setLayoutCount = 0;
-	pipelineLayoutInfo.pushConstantRangeCount = 0;
+	pipelineLayoutInfo.pPushConstantRanges = &pushConstantRange;
+	pipelineLayoutInfo.setLayoutCount = static_cast<uint32_t>(setLayouts.size());
+	pipelineLayoutInfo.pushConstantRangeCount = 1;
 
 	if (vkCreatePipelineLayout(vDevice.device(), &pipelineLayoutInfo, nullptr, &pipelineLayout) != VK_SUCCESS)
 	{
@@ -48,15 +218,131 @@ void Engine::createPipeline()
 	assert(vSwapChain != nullptr && "cannot create pipeline before swapchain");
 	assert(pipelineLayout != nullptr && "cannot create pipeline before pipeline layout");
 	PipelineConfigInfo pipelineConfig{};
-	VwdwPipeline::defaultConfig(pipelineConfig);
+	if (options.depthPrepass)
+	{
+		VwdwPipeline::depthEqualConfig(pipelineConfig);
+	}
+	else
+	{
+		VwdwPipeline::defaultConfig(pipelineConfig);
+	}
 	pipelineConfig.renderPass = vSwapChain->getRenderPass();
+	pipelineConfig.colorFormat = vSwapChain->getSwapChainImageFormat();
+	pipelineConfig.depthFormat = vSwapChain->findDepthFormat();
 	pipelineConfig.pipelineLayout = pipelineLayout;
-	vPipeline = std::make_unique<VwdwPipeline>(
-		vDevice,
-		pipelineConfig,
-		"Shaders/simple_shader.vert.spv",
-		"Shaders/simple_shader.frag.spv"
-	);
+	if (options.cullBackFaces)
+	{
+		pipelineConfig.rasterizationInfo.cullMode = VK_CULL_MODE_BACK_BIT;
+	}
+
+	// the render pass may have changed, nothing built against the old one can be reused. with dynamic
+	// rendering the variants only depend on formats, a format change just misses the cache
+	if (!pipelines)
+	{
+		// the bindless variant reads set 1, which only exists in the layout when the table does
+		const char* fragShader = bindless ? "simple_shader_bindless.frag" : "simple_shader.frag";
+		pipelines = std::make_unique<VPipelineVariants>(vDevice, pipelinePool, shaderPath("simple_shader.vert"), shaderPath(fragShader));
+	}
+	if (!options.dynamicRendering)
+	{
+		pipelines->clear();
+	}
+	VSpecializationConstants constants{};
+	constants.set(SPEC_APPLY_TINT, true);
+	mainVariant = pipelines->getVariant(pipelineConfig, constants);
+
+	if (options.depthPrepass)
+	{
+		PipelineConfigInfo prepassConfig{};
+		VwdwPipeline::depthPrepassConfig(prepassConfig);
+		prepassConfig.renderPass = vSwapChain->getRenderPass();
+		prepassConfig.colorFormat = pipelineConfig.colorFormat;
+		prepassConfig.depthFormat = pipelineConfig.depthFormat;
+		prepassConfig.pipelineLayout = pipelineLayout;
+		prepassConfig.rasterizationInfo.cullMode = pipelineConfig.rasterizationInfo.cullMode;
+		if (!depthPrepassPipelines)
+		{
+			depthPrepassPipelines = std::make_unique<VPipelineVariants>(vDevice, pipelinePool, shaderPath("depth_only.vert"), "");
+		}
+		if (!options.dynamicRendering)
+		{
+			depthPrepassPipelines->clear();
+		}
+		depthPrepassVariant = depthPrepassPipelines->getVariant(prepassConfig);
+	}
+
+	if (particles)
+	{
+		particles->createRenderPipeline(pipelineConfig);
+	}
+}
+
+std::string Engine::shaderPath(const std::string& name) const
+{
+	if (shaderCompiler)
+	{
+		return std::string(SHADER_SOURCE_DIR) + "/" + name;
+	}
+	return std::string(COOKED_SHADER_DIR) + "/" + name + ".spv";
+}
+
+void Engine::applyShaderReloads()
+{
+	// the acquire waited on this slot's fence, nothing older than MAX_FRAMES_IN_FLIGHT frames is still recorded anywhere
+	retiredPipelines.erase(std::remove_if(retiredPipelines.begin(), retiredPipelines.end(),
+		[this](const auto& retired)
+		{
+			if (framesDrawn - retired.first < VSwapChain::MAX_FRAMES_IN_FLIGHT)
+			{
+				return false;
+			}
+			pipelinePool.release(retired.second);
+			return true;
+		}), retiredPipelines.end());
+
+	std::vector<VPipelineHandle> replaced;
+	for (const auto& reload : shaderWatcher->takeReloads())
+	{
+		if (!reload.compiled)
+		{
+			// the pipelines keep the last version that compiled
+			std::cerr << reload.error << std::endl;
+			continue;
+		}
+		size_t before = replaced.size();
+		for (VPipelineVariants* variants : { pipelines.get(), depthPrepassPipelines.get() })
+		{
+			if (variants != nullptr && variants->usesShader(reload.path))
+			{
+				variants->rebuild(replaced);
+			}
+		}
+		// the particle pipelines aren't rebuilt, they pick changes up on the next start
+		std::cout << "reloaded " << reload.path << ", " << replaced.size() - before << " pipelines rebuilt" << std::endl;
+	}
+	// the render queue picks the new pipelines up when it's built this frame
+	for (VPipelineHandle pipeline : replaced)
+	{
+		retiredPipelines.emplace_back(framesDrawn, pipeline);
+	}
+}
+
+void Engine::createParticles()
+{
+	particles = std::make_unique<VParticleSystem>(vDevice, options.particleCount,
+		shaderCompiler ? SHADER_SOURCE_DIR : COOKED_SHADER_DIR, shaderCompiler ? "" : ".spv", *uniformRing, VSwapChain::MAX_FRAMES_IN_FLIGHT);
+	std::cout << "particles: " << options.particleCount << (vDevice.hasDedicatedComputeQueue() ? ", async compute queue" : ", graphics queue") << std::endl;
+
+	// a fountain in clip space, -y is up. the rate keeps the pool about full at steady state
+	VParticleEmitter fountain{};
+	fountain.position = { 0.0f, 0.6f, 0.5f };
+	fountain.radius = 0.02f;
+	fountain.velocity = { 0.0f, -1.4f, 0.0f };
+	fountain.spread = 0.35f;
+	fountain.color = { 1.0f, 0.55f, 0.15f, 0.8f };
+	fountain.lifetime = 2.0f;
+	fountain.rate = static_cast<float>(options.particleCount) / fountain.lifetime;
+	particles->addEmitter(fountain);
 }
 
 void Engine::createCommandBuffers()
@@ -84,9 +370,12 @@ void Engine::recreateSwapChain()
 	}
 
 	vkDeviceWaitIdle(vDevice.device());
+	VkRenderPass previousRenderPass = vSwapChain != nullptr ? vSwapChain->getRenderPass() : VK_NULL_HANDLE;
+	VkFormat previousFormat = vSwapChain != nullptr ? vSwapChain->getSwapChainImageFormat() : VK_FORMAT_UNDEFINED;
 	if (vSwapChain == nullptr)
 	{
-		vSwapChain = std::make_unique<VSwapChain>(vDevice, extent);
+		// a replay times the frames, vsync would only measure the display
+		vSwapChain = std::make_unique<VSwapChain>(vDevice, extent, options.dynamicRendering, !options.replayPath.empty());
 	}
 	else
 	{
@@ -98,8 +387,79 @@ void Engine::recreateSwapChain()
 		}
 	}
 
-	//if renderpass is compatible, you can reues the pipelien
-	createPipeline();
+	swapChainRebuilds++;
+	swapChainOutOfDate = false;
+	resizeCoalescer.recreated();
+
+	// the swapchain hands its render pass on while the formats stay the same, and with it every pipeline
+	if (vSwapChain->getRenderPass() != previousRenderPass || vSwapChain->getSwapChainImageFormat() != previousFormat)
+	{
+		createPipeline();
+	}
+	if (options.dynamicRendering)
+	{
+		buildFrameGraph();
+	}
+}
+
+void Engine::buildFrameGraph()
+{
+	if (!frameGraph)
+	{
+		frameGraph = std::make_unique<VFrameGraph>(&vDevice);
+	}
+	frameGraph->reset();
+
+	// both come from the swapchain, their images are swapped in every frame
+	VkExtent2D extent = vSwapChain->getSwapChainExtent();
+	backbufferResource = frameGraph->importImage("backbuffer", { extent.width, extent.height, vSwapChain->getSwapChainImageFormat() },
+		VK_IMAGE_LAYOUT_UNDEFINED, VFrameGraph::Access::Present);
+	VkExtent2D depthExtent = vSwapChain->getDepthExtent();
+	depthResource = frameGraph->importImage("depth", { depthExtent.width, depthExtent.height, vSwapChain->findDepthFormat() },
+		VK_IMAGE_LAYOUT_UNDEFINED, VFrameGraph::Access::DepthAttachment);
+
+	frameGraph->addPass("main", [this](VFrameGraph::PassBuilder& pass) {
+		pass.write(backbufferResource, VFrameGraph::Access::ColorAttachment);
+		pass.write(depthResource, VFrameGraph::Access::DepthAttachment);
+	}, [this](VkCommandBuffer commandBuffer, const VFrameGraph& graph) {
+		recordMainPass(commandBuffer, graph);
+	});
+	frameGraph->compile();
+}
+
+void Engine::recordMainPass(VkCommandBuffer commandBuffer, const VFrameGraph& graph)
+{
+	VkRenderingAttachmentInfoKHR colorAttachment{};
+	colorAttachment.sType = VK_STRUCTURE_TYPE_RENDERING_ATTACHMENT_INFO_KHR;
+	colorAttachment.imageView = graph.getImageView(backbufferResource);
+	colorAttachment.imageLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+	colorAttachment.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
+	colorAttachment.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
+	colorAttachment.clearValue.color = { 0.01f, 0.01f, 0.01f, 1.0f };
+
+	VkRenderingAttachmentInfoKHR depthAttachment{};
+	depthAttachment.sType = VK_STRUCTURE_TYPE_RENDERING_ATTACHMENT_INFO_KHR;
+	depthAttachment.imageView = graph.getImageView(depthResource);
+	depthAttachment.imageLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+	depthAttachment.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
+	depthAttachment.storeOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+	depthAttachment.clearValue.depthStencil = { 1.0f, 0 };
+
+	VkRenderingInfoKHR renderingInfo{};
+	renderingInfo.sType = VK_STRUCTURE_TYPE_RENDERING_INFO_KHR;
+	renderingInfo.renderArea = { { 0, 0 }, vSwapChain->getSwapChainExtent() };
+	renderingInfo.layerCount = 1;
+	renderingInfo.colorAttachmentCount = 1;
+	renderingInfo.pColorAttachments = &colorAttachment;
+	renderingInfo.pDepthAttachment = &depthAttachment;
+
+	vDevice.cmdBeginRendering(commandBuffer, &renderingInfo);
+	renderQueue.record(commandBuffer, drawBindings);
+	if (particles)
+	{
+		particles->draw(commandBuffer, drawBindings.frameUniformOffset);
+	}
+	vDevice.cmdEndRendering(commandBuffer);
 }
 
 void Engine::recordCommandBuffer(int imageIndex)
@@ -112,21 +472,6 @@ void Engine::recordCommandBuffer(int imageIndex)
 		throw std::runtime_error("failed to begin recording command buffer");
 	}
 
-	VkRenderPassBeginInfo renderPassInfo{};
-	renderPassInfo.renderPass = vSwapChain->getRenderPass();
-	renderPassInfo.framebuffer = vSwapChain->getFrameBuffer(imageIndex);
-	renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
-
-	renderPassInfo.renderArea.extent = vSwapChain->getSwapChainExtent();
-	renderPassInfo.renderArea.offset = { 0, 0 };
-
-	std::array<VkClearValue, 2> clearValues{};
-	clearValues[0].color = { 0.01f, 0.01f, 0.01f, 1.0f };
-	clearValues[1].depthStencil = { 1.0f, 0 };
-
-	renderPassInfo.pClearValues = clearValues.data();
-	renderPassInfo.clearValueCount = static_cast<uint32_t>(clearValues.size());
-
 	VkViewport viewport{};
 	viewport.y = 0.0f;
 	viewport.x = 0.0f;
@@ -138,15 +483,44 @@ void Engine::recordCommandBuffer(int imageIndex)
 	vkCmdSetViewport(commandBuffers[imageIndex], 0, 1, &viewport);
 	vkCmdSetScissor(commandBuffers[imageIndex], 0, 1, &scissor);
 
-	vkCmdBeginRenderPass(commandBuffers[imageIndex], &renderPassInfo, VK_SUBPASS_CONTENTS_INLINE);
+	if (options.dynamicRendering)
+	{
+		frameGraph->setImportedImage(backbufferResource, vSwapChain->getImage(imageIndex), vSwapChain->getImageView(imageIndex));
+		frameGraph->setImportedImage(depthResource, vSwapChain->getDepthImage(), vSwapChain->getDepthImageView());
+		frameGraph->execute(commandBuffers[imageIndex]);
+	}
+	else
+	{
+		VkRenderPassBeginInfo renderPassInfo{};
+		renderPassInfo.renderPass = vSwapChain->getRenderPass();
+		renderPassInfo.framebuffer = vSwapChain->getFrameBuffer(imageIndex);
+		renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
+
+		renderPassInfo.renderArea.extent = vSwapChain->getSwapChainExtent();
+		renderPassInfo.renderArea.offset = { 0, 0 };
 
-	vPipeline->bind(commandBuffers[imageIndex]);
+		std::array<VkClearValue, 2> clearValues{};
+		clearValues[0].color = { 0.01f, 0.01f, 0.01f, 1.0f };
+		clearValues[1].depthStencil = { 1.0f, 0 };
 
-	vModel->bind(commandBuffers[imageIndex]);
+		renderPassInfo.pClearValues = clearValues.data();
+		renderPassInfo.clearValueCount = static_cast<uint32_t>(clearValues.size());
 
-	vModel->draw(commandBuffers[imageIndex]);
+		vkCmdBeginRenderPass(commandBuffers[imageIndex], &renderPassInfo, VK_SUBPASS_CONTENTS_INLINE);
+		renderQueue.record(commandBuffers[imageIndex], drawBindings);
+		if (particles)
+		{
+			particles->draw(commandBuffers[imageIndex], drawBindings.frameUniformOffset);
+		}
+		vkCmdEndRenderPass(commandBuffers[imageIndex]);
+	}
 
-	vkCmdEndRenderPass(commandBuffers[imageIndex]);
+	if (frameCapture)
+	{
+		// both paths leave the image ready to present
+		frameCapture->record(commandBuffers[imageIndex], vSwapChain->getImage(imageIndex), VK_IMAGE_LAYOUT_PRESENT_SRC_KHR,
+			vSwapChain->getSwapChainImageFormat(), vSwapChain->getSwapChainExtent(), framesDrawn);
+	}
 
 	if (vkEndCommandBuffer(commandBuffers[imageIndex]) != VK_SUCCESS)
 	{
@@ -156,12 +530,33 @@ void Engine::recordCommandBuffer(int imageIndex)
 
 void Engine::drawFrame()
 {
+	// every size event since the last frame folds into one request, and there's never more than one
+	// rebuild per frame
+	auto frameStart = std::chrono::steady_clock::now();
+	if (vWindow.wasWindowResized())
+	{
+		vWindow.resetWindowResizedFlag();
+		resizeCoalescer.request(frameStart);
+	}
+	bool rebuilt = false;
+	if (resizeCoalescer.shouldRecreate(frameStart, swapChainOutOfDate))
+	{
+		recreateSwapChain();
+		rebuilt = true;
+	}
+
 	uint32_t imageIndex;
 	auto result = vSwapChain->acquireNextImage(&imageIndex);
+	if (result == VK_ERROR_OUT_OF_DATE_KHR && !rebuilt)
+	{
+		// rebuilding now and trying again beats dropping the frame
+		recreateSwapChain();
+		result = vSwapChain->acquireNextImage(&imageIndex);
+	}
 
 	if(result == VK_ERROR_OUT_OF_DATE_KHR)
 	{
-		recreateSwapChain();
+		swapChainOutOfDate = true;
 		return;
 	}
 	if (result != VK_SUCCESS && result != VK_SUBOPTIMAL_KHR)
@@ -169,16 +564,71 @@ void Engine::drawFrame()
 		throw std::runtime_error("failed to aquire swapchain image");
 	}
 
+	// the acquire waited on this frame slot's fence, so its part of the ring and its arena are free to overwrite
+	uniformRing->beginFrame(vSwapChain->getCurrentFrame());
+	frameArena.beginFrame(vSwapChain->getCurrentFrame());
+	if (shaderWatcher)
+	{
+		applyShaderReloads();
+	}
+	FrameUniforms frameUniforms{};
+	frameUniforms.viewProjection = replayFrame ? replayFrame->viewProjection : viewProjection;
+	drawBindings.pipelines = &pipelinePool;
+	drawBindings.meshes = &meshPool;
+	drawBindings.pipelineLayout = pipelineLayout;
+	drawBindings.uniformSet = uniformRing->getDescriptorSet();
+	drawBindings.frameUniformOffset = uniformRing->push(frameUniforms);
+	if (bindless)
+	{
+		bindless->beginFrame();
+		drawBindings.bindlessSet = bindless->getDescriptorSet();
+	}
+	// nothing this frame uses is recorded yet: make room if memory is getting tight, then pick up
+	// finished streams and start on what the last frame found evicted
+	vDevice.getMemoryBudget().beginFrame(framesDrawn);
+	streamTextures();
+	if (frameCapture)
+	{
+		frameCapture->beginFrame(framesDrawn);
+	}
+
+	auto now = std::chrono::steady_clock::now();
+	float dt = std::chrono::duration<float>(now - lastFrameTime).count();
+	lastFrameTime = now;
+	if (particles)
+	{
+		// overlaps with the previous frame's graphics, only this frame's particle draw waits for it
+		vSwapChain->addWaitSemaphore(particles->simulate(vSwapChain->getCurrentFrame(), dt), VParticleSystem::CONSUMER_STAGES);
+	}
+
+	if (replayFrame)
+	{
+		buildReplayQueue(*replayFrame);
+	}
+	else
+	{
+		applySimulation();
+		updateScene();
+		culler.cull(VFrustum::fromViewProjection(viewProjection));
+		buildRenderQueue();
+	}
+	uniformRing->flush();
 	recordCommandBuffer(imageIndex);
 
-	result = vSwapChain->submitCommandBuffers(&commandBuffers[imageIndex], &imageIndex);
+	result = vSwapChain->submitCommandBuffers(&commandBuffers[imageIndex], &imageIndex, frameArena.resource());
+	framesDrawn++;
 
-	if(result == VK_ERROR_OUT_OF_DATE_KHR || result == VK_SUBOPTIMAL_KHR || vWindow.wasWindowResized())
+	if(result == VK_ERROR_OUT_OF_DATE_KHR)
 	{
-		vWindow.resetWindowResizedFlag();
-		recreateSwapChain();
+		swapChainOutOfDate = true;
 		return;
 	}
+	// still presentable, rebuilt once things settle. only the first one starts the clock, or a
+	// swapchain that stays suboptimal would never settle
+	if (result == VK_SUBOPTIMAL_KHR && !resizeCoalescer.isPending())
+	{
+		resizeCoalescer.request(frameStart);
+	}
 
 	if (result != VK_SUCCESS)
 	{
@@ -187,10 +637,325 @@ void Engine::drawFrame()
 
 }
 
+void Engine::cookAssets()
+{
+	// incremental, only sources whose content hash changed since the last run get recooked
+	for (const auto& dirs : { std::make_pair(ASSET_SOURCE_DIR, COOKED_DIR), std::make_pair(SHADER_SOURCE_DIR, COOKED_SHADER_DIR) })
+	{
+		CookStats stats = vwdw::cookAssets(dirs.first, dirs.second, &jobSystem);
+		for (const auto& error : stats.errors)
+		{
+			std::cerr << error << std::endl;
+		}
+		std::cout << dirs.first << ": cooked " << stats.cooked << ", up to date " << stats.upToDate << ", failed " << stats.failed << std::endl;
+	}
+}
+
+// cooked files with the given extension, sorted so ids are stable between runs
+static std::vector<std::string> findCooked(const std::string& dir, const std::string& extension)
+{
+	std::vector<std::string> paths;
+	std::error_code error;
+	for (const auto& entry : std::filesystem::recursive_directory_iterator(dir, error))
+	{
+		if (entry.is_regular_file() && entry.path().extension() == extension)
+		{
+			paths.push_back(entry.path().string());
+		}
+	}
+	std::sort(paths.begin(), paths.end());
+	return paths;
+}
+
 void Engine::loadModels()
 {
-	std::vector<VModel::Vertex> verts{ {{0.0f,-0.5f}, {0.0f,0.0f,1.0f}}, {{0.5f,0.5f}, {1.0f,0.0f,0.0f}}, {{-0.5f, 0.5f}, {0.0f,1.0f,0.0f}} };
-	vModel = std::make_unique<VModel>(vDevice, verts);
+	for (const auto& path : findCooked(COOKED_DIR, ".vmesh"))
+	{
+		std::vector<VModel::Vertex> verts;
+		std::vector<uint32_t> indices;
+		VModel::readCooked(path, verts, indices);
+		models.push_back(meshPool.emplace(vDevice, verts, indices));
+	}
+	if (models.empty())
+	{
+		throw std::runtime_error(std::string("no cooked meshes in ") + COOKED_DIR);
+	}
+
+	VScene::NodeId node = addObject(0, glm::mat4{ 1.0f }, textures.empty() ? NO_TEXTURE : 0);
+
+	// a slow spin about the view axis, driven by the simulation
+	VBody body{};
+	body.spin = 0.5f;
+	simulation.addBody(body);
+	bodyNodes.push_back(node);
+}
+
+void Engine::loadTextures()
+{
+	// everything cooked goes up as one batch, the staging for it isn't worth keeping
+	textureLoader = std::make_unique<VTextureLoader>(vDevice, bindless.get(), &jobSystem);
+	texturePaths = findCooked(COOKED_DIR, ".vtex");
+	textureLoader->loadCookedBatch(texturePaths, texturePool, textures);
+	textureLoader->releaseStaging();
+	for (uint32_t texture = 0; texture < textures.size(); texture++)
+	{
+		makeTextureStreamable(texture);
+	}
+}
+
+void Engine::makeTextureStreamable(uint32_t texture)
+{
+	// releasing the handle destroys the texture, which frees its memory and gives the bindless slot back
+	vDevice.getMemoryBudget().markStreamable(texturePool[textures[texture]].getMemory(), [this, texture]()
+		{
+			texturePool.release(textures[texture]);
+		});
+}
+
+void Engine::streamTextures()
+{
+	// never waits: the files are read on a worker, the upload is picked up once its fence signalled
+	if (textureLoader->pollCookedStream(texturePool, streamedTextures))
+	{
+		for (size_t i = 0; i < streamedTextures.size(); i++)
+		{
+			textures[streamingTextures[i]] = streamedTextures[i];
+			makeTextureStreamable(streamingTextures[i]);
+		}
+		streamingTextures.clear();
+	}
+	if (texturesToStream.empty() || textureLoader->streaming())
+	{
+		return;
+	}
+
+	// assigning over the scratch strings reuses their storage
+	streamingTextures.assign(texturesToStream.begin(), texturesToStream.end());
+	texturesToStream.clear();
+	streamPaths.resize(streamingTextures.size());
+	for (size_t i = 0; i < streamingTextures.size(); i++)
+	{
+		streamPaths[i] = texturePaths[streamingTextures[i]];
+	}
+	textureLoader->startCookedStream(streamPaths);
+}
+
+VScene::NodeId Engine::addObject(uint32_t mesh, const glm::mat4& transform, uint32_t texture)
+{
+	VScene::NodeId node = scene.createNode(VScene::NO_NODE, transform, mesh);
+	const auto& bounds = meshPool[models[mesh]].getBounds();
+
+	if (nodeObjects.size() <= node)
+	{
+		nodeObjects.resize(node + 1, VScene::NO_NODE);
+	}
+	nodeObjects[node] = culler.addObject(bounds.center, bounds.radius, bounds.min, bounds.max);
+	objectNodes.push_back(node);
+	objectUniforms.push_back(ObjectUniforms{});
+	objectTextures.push_back(texture);
+	return node;
+}
+
+void Engine::applySimulation()
+{
+	// pipelined, the simulation thread keeps publishing on its own and this only reads
+	auto now = std::chrono::steady_clock::now();
+	if (!options.pipelined)
+	{
+		simulation.advance(now);
+	}
+	simulation.interpolate(now, bodyTransforms);
+	for (size_t body = 0; body < bodyTransforms.size(); body++)
+	{
+		scene.setLocalTransform(bodyNodes[body], bodyTransforms[body]);
+	}
+}
+
+void Engine::updateScene()
+{
+	// only nodes whose world transform actually changed get their cull bounds refreshed
+	for (VScene::NodeId node : scene.update())
+	{
+		if (node >= nodeObjects.size() || nodeObjects[node] == VScene::NO_NODE)
+		{
+			continue;
+		}
+
+		glm::vec3 center, boxMin, boxMax;
+		float radius;
+		transformBounds(scene.getWorldTransform(node), meshPool[models[scene.getMesh(node)]].getBounds(), center, radius, boxMin, boxMax);
+		culler.updateObject(nodeObjects[node], center, radius, boxMin, boxMax);
+	}
+}
+
+VBindlessTable::Handle Engine::residentTexture(uint32_t texture)
+{
+	if (texture == NO_TEXTURE)
+	{
+		return VBindlessTable::INVALID_HANDLE;
+	}
+	// an evicted texture draws without one until it has been streamed back in
+	if (const VTexture* resident = texturePool.get(textures[texture]))
+	{
+		vDevice.getMemoryBudget().touch(resident->getMemory(), framesDrawn);
+		return resident->getBindlessHandle();
+	}
+	if (std::find(texturesToStream.begin(), texturesToStream.end(), texture) == texturesToStream.end() &&
+		std::find(streamingTextures.begin(), streamingTextures.end(), texture) == streamingTextures.end())
+	{
+		texturesToStream.push_back(texture);
+	}
+	return VBindlessTable::INVALID_HANDLE;
+}
+
+uint32_t Engine::pushObjectUniforms(const ObjectUniforms& uniforms)
+{
+	// a slot taken by other values is simply overwritten, the worst case is a block per draw as before
+	SharedUniformBlock& block = sharedUniformBlocks[hashBytes(&uniforms, sizeof(uniforms)) % SHARED_UNIFORM_SLOTS];
+	if (block.frame == framesDrawn + 1 && std::memcmp(&block.value, &uniforms, sizeof(uniforms)) == 0)
+	{
+		return block.offset;
+	}
+	block.value = uniforms;
+	block.offset = uniformRing->push(uniforms);
+	block.frame = framesDrawn + 1;
+	return block.offset;
+}
+
+void Engine::buildRenderQueue()
+{
+	renderQueue.clear();
+	if (drawCapture)
+	{
+		capturedFrame.viewProjection = viewProjection;
+		capturedFrame.draws.clear();
+	}
+	for (uint32_t object : culler.visibleObjects())
+	{
+		VScene::NodeId node = objectNodes[object];
+		uint32_t mesh = scene.getMesh(node);
+
+		// front to back inside a state bucket, using the clip space depth of the bounds center
+		glm::vec4 clip = viewProjection * scene.getWorldTransform(node) * glm::vec4{ meshPool[models[mesh]].getBounds().center, 1.0f };
+		float depth = clip.w != 0.0f ? clip.z / clip.w : 0.0f;
+
+		VDrawItem item{};
+		item.pipeline = pipelines->getPipeline(mainVariant);
+		item.mesh = models[mesh];
+		item.transform = &scene.getWorldTransform(node);
+		item.uniformOffset = pushObjectUniforms(objectUniforms[object]);
+		item.texture = residentTexture(objectTextures[object]);
+		item.object = object;
+		renderQueue.push(VRenderQueue::makeKey(VRenderQueue::PASS_OPAQUE, mainVariant, 0, mesh, depth), item);
+		if (drawCapture)
+		{
+			capturedFrame.draws.push_back(CapturedDraw{ scene.getWorldTransform(node), objectUniforms[object].tint, mesh, mainVariant, objectTextures[object], depth });
+		}
+
+		if (depthPrepassPipelines)
+		{
+			// same block and transform, the pre-pass draw only swaps the pipeline
+			VDrawItem prepassItem = item;
+			prepassItem.pipeline = depthPrepassPipelines->getPipeline(depthPrepassVariant);
+			renderQueue.push(VRenderQueue::makeKey(VRenderQueue::PASS_DEPTH_PREPASS, depthPrepassVariant, 0, mesh, depth), prepassItem);
+		}
+	}
+	renderQueue.sort();
+	if (drawCapture)
+	{
+		drawCapture->write(capturedFrame);
+	}
+}
+
+void Engine::buildReplayQueue(const CapturedFrame& frame)
+{
+	// the captured opaque draws, with the pre-pass derived from them the way buildRenderQueue does, so
+	// a capture replays with or without --depth-prepass
+	renderQueue.clear();
+	for (uint32_t i = 0; i < frame.draws.size(); i++)
+	{
+		const CapturedDraw& draw = frame.draws[i];
+		VDrawItem item{};
+		item.pipeline = pipelines->getPipeline(draw.variant);
+		item.mesh = models[draw.mesh];
+		item.transform = &draw.transform;
+		item.uniformOffset = pushObjectUniforms(ObjectUniforms{ draw.tint });
+		item.texture = residentTexture(draw.texture);
+		item.object = i;
+		renderQueue.push(VRenderQueue::makeKey(VRenderQueue::PASS_OPAQUE, draw.variant, 0, draw.mesh, draw.depth), item);
+
+		if (depthPrepassPipelines)
+		{
+			VDrawItem prepassItem = item;
+			prepassItem.pipeline = depthPrepassPipelines->getPipeline(depthPrepassVariant);
+			renderQueue.push(VRenderQueue::makeKey(VRenderQueue::PASS_DEPTH_PREPASS, depthPrepassVariant, 0, draw.mesh, draw.depth), prepassItem);
+		}
+	}
+	renderQueue.sort();
+}
+
+void Engine::runReplay()
+{
+	VDrawCapture capture = VDrawCapture::load(options.replayPath);
+	if (capture.frames.empty())
+	{
+		throw std::runtime_error("no frames in draw capture " + options.replayPath);
+	}
+	// ids are only meaningful against the same cooked assets and pipelines, check every one up front
+	// instead of indexing out of bounds halfway through
+	for (const CapturedFrame& frame : capture.frames)
+	{
+		for (const CapturedDraw& draw : frame.draws)
+		{
+			if (draw.mesh >= models.size() || draw.variant >= pipelines->variantCount() || (draw.texture != NO_TEXTURE && draw.texture >= textures.size()))
+			{
+				throw std::runtime_error("draw capture " + options.replayPath + " was taken with other assets (" + std::to_string(capture.meshCount) + " meshes, "
+					+ std::to_string(capture.textureCount) + " textures) than cooked here (" + std::to_string(models.size()) + ", " + std::to_string(textures.size()) + ")");
+			}
+		}
+	}
+
+	// cpu time per frame, which includes the acquire's fence wait and so whatever the gpu is behind by
+	std::vector<double> frameTimes;
+	frameTimes.reserve(capture.frames.size() * options.replayIterations);
+	std::vector<double> iterationTimes;
+	size_t draws = 0;
+	for (const CapturedFrame& frame : capture.frames)
+	{
+		draws += frame.draws.size();
+	}
+
+	for (uint32_t iteration = 0; iteration < options.replayIterations && !vWindow.shouldClose(); iteration++)
+	{
+		auto iterationStart = std::chrono::steady_clock::now();
+		for (const CapturedFrame& frame : capture.frames)
+		{
+			glfwPollEvents();
+			replayFrame = &frame;
+			auto frameStart = std::chrono::steady_clock::now();
+			drawFrame();
+			frameTimes.push_back(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - frameStart).count());
+		}
+		// every iteration ends with the gpu done, so none of them pays for the last one's frames
+		vkDeviceWaitIdle(vDevice.device());
+		iterationTimes.push_back(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - iterationStart).count());
+		std::cout << "replay iteration " << iteration << ": " << iterationTimes.back() << " ms" << std::endl;
+	}
+	replayFrame = nullptr;
+	if (iterationTimes.empty())
+	{
+		return;
+	}
+
+	std::sort(frameTimes.begin(), frameTimes.end());
+	std::vector<double> sortedIterations = iterationTimes;
+	std::sort(sortedIterations.begin(), sortedIterations.end());
+	std::cout << "replay: " << capture.frames.size() << " frames, " << static_cast<double>(draws) / capture.frames.size() << " draws per frame, "
+		<< iterationTimes.size() << " iterations (the first one warms up)" << std::endl;
+	std::cout << "replay iteration: mean " << std::accumulate(iterationTimes.begin(), iterationTimes.end(), 0.0) / iterationTimes.size()
+		<< " ms, median " << sortedIterations[sortedIterations.size() / 2] << " ms" << std::endl;
+	std::cout << "replay frame: min " << frameTimes.front() << " ms, median " << frameTimes[frameTimes.size() / 2]
+		<< " ms, p95 " << frameTimes[frameTimes.size() * 95 / 100] << " ms, max " << frameTimes.back() << " ms" << std::endl;
 }
 
 void Engine::freeCommandBuffers()
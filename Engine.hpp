@@ -5,42 +5,228 @@
 #include "VDevice.hpp"
 #include "v_swap_chain.hpp"
 #include "model.hpp"
+#include "v_culling.hpp"
+#include "v_scene.hpp"
+#include "v_render_queue.hpp"
+#include "v_uniform_ring.hpp"
+#include "v_bindless.hpp"
+#include "v_texture.hpp"
+#include "v_specialization.hpp"
+#include "v_frame_graph.hpp"
+#include "v_particles.hpp"
+#include "v_jobs.hpp"
+#include "v_simulation.hpp"
+#include "v_frame_arena.hpp"
+#include "v_resize.hpp"
+#include "v_shader_compiler.hpp"
+#include "v_shader_watcher.hpp"
+#include "v_frame_capture.hpp"
+#include "v_draw_capture.hpp"
+
+#include <array>
+#include <chrono>
 
 #include <memory>
+#include <string>
+#include <utility>
 #include <vector>
 
 namespace vwdw {
 
+// set 0 binding 0 in simple_shader, written once per frame
+struct FrameUniforms {
+	glm::mat4 viewProjection{ 1.0f };
+};
+
+// set 0 binding 1, one block per draw
+struct ObjectUniforms {
+	glm::vec4 tint{ 1.0f };
+};
+
+struct EngineOptions {
+	// lay depth down with a position only pass first, then shade with an EQUAL depth test
+	bool depthPrepass = false;
+	bool cullBackFaces = false;
+	// begin rendering on the swapchain views (VK_KHR_dynamic_rendering) instead of a VkRenderPass,
+	// ignored when the device doesn't support it
+	bool dynamicRendering = false;
+	// gpu particle capacity, 0 leaves the particle system out
+	uint32_t particleCount = 0;
+	// simulate on a thread of its own, the render loop only interpolates the newest snapshot
+	bool pipelined = false;
+	// after a warm-up, fail if any of this many frames allocates from the heap or creates a vulkan object
+	uint32_t allocationCheckFrames = 0;
+	// caps every device local heap's budget at this many MiB, 0 for the driver's (or estimated) budget.
+	// small values force the texture eviction and streaming paths
+	uint32_t memoryBudgetMiB = 0;
+	// compile the glsl in Shaders at startup (through the on-disk cache) instead of loading cooked spir-v
+	bool runtimeShaders = false;
+	// runtimeShaders, and rebuild the pipelines using a shader whenever its source is saved
+	bool hotReload = false;
+	// copy every frame out to this directory (png per frame, or one raw rgba stream with captureRaw),
+	// empty for no capture. frames the encoders can't keep up with are dropped rather than waited for
+	std::string captureDir;
+	bool captureRaw = false;
+	// write every frame's draw list to this file, empty for none
+	std::string drawCapturePath;
+	// instead of running the scene, draw the frames of this draw capture replayIterations times in a
+	// hidden window and report how long they took
+	std::string replayPath;
+	uint32_t replayIterations = 10;
+};
+
 class Engine {
 
 	public:
 		static constexpr int WIDTH = 800;
 		static constexpr int HEIGHT = 600;
+		// per frame in flight, every visible draw takes one aligned ObjectUniforms block
+		static constexpr VkDeviceSize UNIFORM_RING_FRAME_SIZE = 4 * 1024 * 1024;
+		// per frame in flight, for containers that only live while a frame is built
+		static constexpr size_t FRAME_ARENA_SIZE = 256 * 1024;
+		// the runtime only ever reads the cooked copies
+		static constexpr const char* ASSET_SOURCE_DIR = "Assets";
+		static constexpr const char* SHADER_SOURCE_DIR = "Shaders";
+		static constexpr const char* COOKED_DIR = "Cooked";
+		static constexpr const char* COOKED_SHADER_DIR = "Cooked/Shaders";
+		static constexpr const char* SHADER_CACHE_DIR = "Cooked/ShaderCache";
+		// constant_id values in simple_shader.frag
+		static constexpr uint32_t SPEC_APPLY_TINT = 0;
+		static constexpr double SIMULATION_HZ = 60.0;
+		// long enough for every frame slot, ring and triple buffer slot to have been through a frame
+		static constexpr uint32_t ALLOCATION_CHECK_WARMUP_FRAMES = 60;
+		static constexpr uint32_t NO_TEXTURE = UINT32_MAX;
+		// remembered ObjectUniforms blocks per frame, a direct mapped cache keyed on the contents
+		static constexpr uint32_t SHARED_UNIFORM_SLOTS = 64;
 
-		Engine();
+		explicit Engine(const EngineOptions& options = {});
 		~Engine();
 
 		Engine(const Engine&) = delete;
 		Engine& operator=(const Engine&) = delete;
 
 		void run();
+		// false when options.allocationCheckFrames caught a frame that allocated
+		bool allocationCheckPassed() const { return allocatingFrames == 0; }
 	private:
 		void createPipelineLayout();
+		void cookAssets();
 		void loadModels();
+		void loadTextures();
 		void createPipeline();
 		void createCommandBuffers();
 		void drawFrame();
+		void applySimulation();
+		void updateScene();
+		void buildRenderQueue();
+		void runReplay();
+		void buildReplayQueue(const CapturedFrame& frame);
+		// the bindless handle of textures[texture], or none when it's NO_TEXTURE or evicted (and then queued to stream back in)
+		VBindlessTable::Handle residentTexture(uint32_t texture);
+		// draws with the same values this frame get the same block, so the queue can skip rebinding set 0 between them
+		uint32_t pushObjectUniforms(const ObjectUniforms& uniforms);
+		VScene::NodeId addObject(uint32_t mesh, const glm::mat4& transform, uint32_t texture = NO_TEXTURE);
+		// the budget may evict textures[texture] when memory runs short, it's reloaded once it's drawn again
+		void makeTextureStreamable(uint32_t texture);
+		void streamTextures();
 		void freeCommandBuffers();
+		void buildFrameGraph();
+		void recordMainPass(VkCommandBuffer commandBuffer, const VFrameGraph& graph);
+		void createParticles();
+		// the cooked module, or the glsl source when shaders are compiled at run time
+		std::string shaderPath(const std::string& name) const;
+		void applyShaderReloads();
+		bool checkAllocations(uint32_t frame, const VAllocationCounters& frameAllocations);
 
 
-		VWindow vWindow{ WIDTH, HEIGHT, "Vulkan_test" };
+		EngineOptions options;
+		// one worker per core, the main thread is worker 0 and helps out while it waits
+		VJobSystem jobSystem;
+		VWindow vWindow{ WIDTH, HEIGHT, "Vulkan_test", options.replayPath.empty() };
 		VDevice vDevice{ vWindow };
+		// only with options.runtimeShaders, the watcher only with options.hotReload
+		std::unique_ptr<VShaderCompiler> shaderCompiler;
+		std::unique_ptr<VShaderWatcher> shaderWatcher;
 		std::unique_ptr<VSwapChain> vSwapChain;
+		// only with options.captureDir
+		std::unique_ptr<VFrameCapture> frameCapture;
+		// only with options.drawCapturePath, the frame is refilled by every buildRenderQueue
+		std::unique_ptr<VDrawCaptureWriter> drawCapture;
+		CapturedFrame capturedFrame;
+		// set while a replay draws, drawFrame takes the draws from it instead of the scene
+		const CapturedFrame* replayFrame = nullptr;
 		//VwdwPipeline pipeline{vDevice, VwdwPipeline::defaultConfig(WIDTH, HEIGHT), "Shaders/simple_shader.vert.spv",  "Shaders/simple_shader.frag.spv" };
-		std::unique_ptr<VwdwPipeline> vPipeline;
+		// every graphics pipeline the variants below build, declared first so it outlives them
+		VHandlePool<VwdwPipeline> pipelinePool;
+		// simple_shader variants, rebuilt with the swapchain
+		std::unique_ptr<VPipelineVariants> pipelines;
+		// only created with options.depthPrepass
+		std::unique_ptr<VPipelineVariants> depthPrepassPipelines;
+		uint32_t mainVariant = 0;
+		uint32_t depthPrepassVariant = 0;
+		// replaced by a hot reload while frames in flight may still use them, destroyed after MAX_FRAMES_IN_FLIGHT more frames
+		std::vector<std::pair<uint64_t, VPipelineHandle>> retiredPipelines;
+		uint64_t framesDrawn = 0;
+		// dynamic rendering only, the graph does the swapchain / depth layout transitions a render pass would
+		std::unique_ptr<VFrameGraph> frameGraph;
+		VFrameGraph::ResourceId backbufferResource = VFrameGraph::INVALID_RESOURCE;
+		VFrameGraph::ResourceId depthResource = VFrameGraph::INVALID_RESOURCE;
+		std::unique_ptr<VUniformRing> uniformRing;
+		VFrameArena frameArena{ FRAME_ARENA_SIZE, VSwapChain::MAX_FRAMES_IN_FLIGHT };
+		// only with options.particleCount, simulated on the async compute queue
+		std::unique_ptr<VParticleSystem> particles;
+		std::chrono::steady_clock::time_point lastFrameTime;
+		// null when the device can't do descriptor indexing
+		std::unique_ptr<VBindlessTable> bindless;
+		// declared after the table so their handles are released before it goes away
+		VHandlePool<VTexture> texturePool;
+		// kept from startup so streaming reuses its command buffer, fence and staging
+		std::unique_ptr<VTextureLoader> textureLoader;
+		// in cooked file order. an evicted texture's handle goes stale until it's streamed back in
+		std::vector<VImageHandle> textures;
+		std::vector<std::string> texturePaths;
+		// evicted textures a visible object wanted, the next batch streamTextures starts
+		std::vector<uint32_t> texturesToStream;
+		// the batch in flight, they draw without a texture until its upload fence signals
+		std::vector<uint32_t> streamingTextures;
+		// streamTextures' scratch, reused so a streaming frame doesn't allocate them. streamPaths also
+		// has to stay put while its batch is being read
+		std::vector<std::string> streamPaths;
+		std::vector<VImageHandle> streamedTextures;
 		VkPipelineLayout pipelineLayout;
 		std::vector<VkCommandBuffer> commandBuffers;
-		std::unique_ptr<VModel> vModel;
+		VHandlePool<VModel> meshPool;
+		// mesh id (what the scene and the sort keys use) -> mesh
+		std::vector<VMeshHandle> models;
+		VScene scene;
+		VSimulation simulation{ SIMULATION_HZ };
+		// simulation body id -> scene node, and the interpolated transforms written to them every frame
+		std::vector<VScene::NodeId> bodyNodes;
+		std::vector<glm::mat4> bodyTransforms;
+		VFrustumCuller culler;
+		// culler object id -> scene node and back
+		std::vector<VScene::NodeId> objectNodes;
+		std::vector<uint32_t> nodeObjects;
+		// by culler object id
+		std::vector<ObjectUniforms> objectUniforms;
+		struct SharedUniformBlock {
+			ObjectUniforms value;
+			uint32_t offset = 0;
+			// framesDrawn + 1 when it was pushed, 0 for never
+			uint64_t frame = 0;
+		};
+		std::array<SharedUniformBlock, SHARED_UNIFORM_SLOTS> sharedUniformBlocks{};
+		// index into textures or NO_TEXTURE
+		std::vector<uint32_t> objectTextures;
+		VRenderQueue renderQueue;
+		VDrawBindings drawBindings;
+		// the test triangle is authored in clip space, so the camera is identity for now
+		glm::mat4 viewProjection{ 1.0f };
+		uint32_t allocatingFrames = 0;
+		VResizeCoalescer resizeCoalescer;
+		// the last acquire or present said the swapchain can't be used anymore
+		bool swapChainOutOfDate = false;
+		uint32_t swapChainRebuilds = 0;
 		void recreateSwapChain();
 		void recordCommandBuffer(int imageIndex);
 };
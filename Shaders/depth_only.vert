@@ -0,0 +1,20 @@
+#version 450
+
+// depth pre-pass, position only. has to match simple_shader.vert's position math exactly
+// (both declare gl_Position invariant) or the main pass's EQUAL test drops pixels
+
+layout(location = 0) in vec3 position;
+
+layout(set = 0, binding = 0) uniform FrameUbo {
+  mat4 viewProjection;
+} frame;
+
+layout(push_constant) uniform Push {
+  mat4 model;
+} push;
+
+invariant gl_Position;
+
+void main() {
+  gl_Position = frame.viewProjection * push.model * vec4(position, 1.0);
+}
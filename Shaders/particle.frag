@@ -0,0 +1,15 @@
+#version 450
+
+layout(location = 0) in vec4 color;
+layout(location = 1) in vec2 corner;
+
+layout(location = 0) out vec4 outColor;
+
+void main() {
+  // round soft edged sprite, blended additively
+  float d = dot(corner, corner);
+  if (d > 1.0) {
+    discard;
+  }
+  outColor = vec4(color.rgb, color.a * (1.0 - d));
+}
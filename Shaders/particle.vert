@@ -0,0 +1,52 @@
+#version 450
+
+// one camera facing quad per instance, read straight out of the simulation's storage buffers.
+// drawn indirectly with the instance count particle_indirect wrote
+
+struct Particle {
+  vec4 positionLife;     // xyz position, w seconds left
+  vec4 velocityLifetime; // xyz velocity, w total lifetime
+  vec4 color;
+};
+
+layout(std430, set = 0, binding = 0) readonly buffer Particles { Particle particles[]; };
+layout(std430, set = 0, binding = 1) readonly buffer AliveLists { uint alive[]; };
+
+layout(set = 1, binding = 0) uniform FrameUbo {
+  mat4 viewProjection;
+} frame;
+
+layout(push_constant) uniform Push {
+  vec4 positionRadius;
+  vec4 velocitySpread;
+  vec4 color;
+  vec4 gravityDt;
+  float lifetime;
+  float size;
+  uint emitCount;
+  uint seed;
+  uint srcList; // the list simulated into this frame
+  uint capacity;
+} push;
+
+layout(location = 0) out vec4 outColor;
+layout(location = 1) out vec2 outCorner;
+
+const vec2 CORNERS[6] = vec2[](
+  vec2(-1.0, -1.0), vec2(1.0, -1.0), vec2(1.0, 1.0),
+  vec2(-1.0, -1.0), vec2(1.0, 1.0), vec2(-1.0, 1.0));
+
+void main() {
+  uint base = push.srcList * push.capacity;
+  Particle p = particles[base + alive[base + gl_InstanceIndex]];
+  vec2 corner = CORNERS[gl_VertexIndex];
+
+  // offset in clip space so the quad always faces the camera, it still shrinks with distance
+  vec4 clip = frame.viewProjection * vec4(p.positionLife.xyz, 1.0);
+  clip.xy += corner * push.size;
+  gl_Position = clip;
+
+  float fade = clamp(p.positionLife.w / p.velocityLifetime.w, 0.0, 1.0);
+  outColor = vec4(p.color.rgb, p.color.a * fade);
+  outCorner = corner;
+}
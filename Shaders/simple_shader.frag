@@ -3,6 +3,16 @@
 layout (location = 0) in vec3 color;
 layout (location = 0) out vec4 outColor;
 
+// specialization constants, set per pipeline variant (Engine.hpp has the ids)
+layout(constant_id = 0) const bool APPLY_TINT = true;
+
+layout(set = 0, binding = 1) uniform ObjectUbo {
+  vec4 tint;
+} object;
+
 void main() {
   outColor = vec4(color, 1.0);
-}
\ No newline at end of file
+  if (APPLY_TINT) {
+    outColor *= object.tint;
+  }
+}
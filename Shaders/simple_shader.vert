@@ -1,11 +1,24 @@
 #version 450
 
-layout(location = 0) in vec2 position;
+layout(location = 0) in vec3 position;
 layout(location = 1) in vec3 color;
 
 layout(location = 0) out vec3 outColor;
+// the meshes carry no uvs, textures are projected onto the model's xy plane
+layout(location = 1) out vec2 outUv;
+
+layout(set = 0, binding = 0) uniform FrameUbo {
+  mat4 viewProjection;
+} frame;
+
+layout(push_constant) uniform Push {
+  mat4 model;
+} push;
+
+invariant gl_Position;
 
 void main() {
-  gl_Position = vec4(position, 0.0, 1.0);
+  gl_Position = frame.viewProjection * push.model * vec4(position, 1.0);
   outColor = color;
-}
\ No newline at end of file
+  outUv = position.xy * 0.5 + 0.5;
+}
@@ -0,0 +1,37 @@
+#version 450
+#extension GL_EXT_nonuniform_qualifier : require
+
+// simple_shader.frag plus the object's texture from the bindless table (v_bindless.hpp has the layout)
+
+layout (location = 0) in vec3 color;
+layout (location = 1) in vec2 uv;
+layout (location = 0) out vec4 outColor;
+
+// specialization constants, set per pipeline variant (Engine.hpp has the ids)
+layout(constant_id = 0) const bool APPLY_TINT = true;
+
+layout(set = 0, binding = 1) uniform ObjectUbo {
+  vec4 tint;
+} object;
+
+layout(set = 1, binding = 0) uniform sampler2D textures[];
+
+// has to match VObjectPushConstants
+layout(push_constant) uniform Push {
+  mat4 model;
+  uint textureHandle;
+  uint materialBuffer;
+} push;
+
+const uint INVALID_HANDLE = 0xFFFFFFFFu;
+
+void main() {
+  outColor = vec4(color, 1.0);
+  // the handle is per draw but draws aren't guaranteed to be one per subgroup, hence nonuniformEXT
+  if (push.textureHandle != INVALID_HANDLE) {
+    outColor *= texture(textures[nonuniformEXT(push.textureHandle)], uv);
+  }
+  if (APPLY_TINT) {
+    outColor *= object.tint;
+  }
+}
@@ -2,8 +2,12 @@
 // The following lines have been changed (in the CPP) by Jordan henstrom: Function starting at 71
 
 #include "VDevice.hpp"
+#include "v_frame_arena.hpp"
+#include "v_swap_chain.hpp"
 
+#include <algorithm>
 #include <cstring>
+#include <fstream>
 #include <iostream>
 #include <set>
 #include <unordered_set>
@@ -55,9 +59,15 @@ VDevice::VDevice(VWindow &window) : window{window} {
   pickPhysicalDevice();
   createLogicalDevice();
   createCommandPool();
+  createPipelineCache();
 }
 
 VDevice::~VDevice() {
+  savePipelineCache();
+  vkDestroyPipelineCache(device_, pipelineCache, nullptr);
+  if (computeCommandPool != commandPool) {
+    vkDestroyCommandPool(device_, computeCommandPool, nullptr);
+  }
   vkDestroyCommandPool(device_, commandPool, nullptr);
   vkDestroyDevice(device_, nullptr);
 
@@ -83,7 +93,15 @@ void VDevice::createInstance() {
   appInfo.pEngineName = "No Engine";
   appInfo.pApplicationName = "LittleVulkanEngine App";
   appInfo.engineVersion = VK_MAKE_VERSION(1, 0, 0);
-  appInfo.apiVersion = VK_API_VERSION_1_0;
+  // a 1.0 loader rejects anything newer, and doesn't have vkEnumerateInstanceVersion either
+  instanceApiVersion = VK_API_VERSION_1_0;
+  auto enumerateInstanceVersion = reinterpret_cast<PFN_vkEnumerateInstanceVersion>(
+      vkGetInstanceProcAddr(nullptr, "vkEnumerateInstanceVersion"));
+  if (enumerateInstanceVersion != nullptr) {
+    enumerateInstanceVersion(&instanceApiVersion);
+  }
+  instanceApiVersion = std::min(instanceApiVersion, static_cast<uint32_t>(VK_API_VERSION_1_2));
+  appInfo.apiVersion = instanceApiVersion;
   appInfo.sType = VK_STRUCTURE_TYPE_APPLICATION_INFO;
   createInfo.pApplicationInfo = &appInfo;
 
@@ -132,6 +150,7 @@ void VDevice::pickPhysicalDevice() {
   }
 
   vkGetPhysicalDeviceProperties(physicalDevice, &properties);
+  apiVersion = std::min(instanceApiVersion, properties.apiVersion);
   std::cout << "physical device: " << properties.deviceName << std::endl;
 }
 
@@ -139,7 +158,7 @@ void VDevice::createLogicalDevice() {
   QueueFamilyIndices indices = findQueueFamilies(physicalDevice);
 
   std::vector<VkDeviceQueueCreateInfo> queueCreateInfos;
-  std::set<uint32_t> uniqueQueueFamilies = {indices.graphicsFamily, indices.presentFamily};
+  std::set<uint32_t> uniqueQueueFamilies = {indices.graphicsFamily, indices.presentFamily, indices.computeFamily};
 
   float queuePriority = 1.0f;
   for (uint32_t queueFamily : uniqueQueueFamilies) {
@@ -151,18 +170,105 @@ void VDevice::createLogicalDevice() {
     queueCreateInfos.push_back(queueCreateInfo);
   }
 
-  VkPhysicalDeviceFeatures deviceFeatures = {};
-  deviceFeatures.samplerAnisotropy = VK_TRUE;
+  std::vector<const char *> enabledExtensions = deviceExtensions;
+
+  // descriptor indexing is core in 1.2, older devices need the EXT which depends on maintenance3
+  // everything below that is queried through Features2 / Properties2 needs 1.1 on both sides
+  bool features2 = apiVersion >= VK_API_VERSION_1_1;
+  bool coreIndexing = apiVersion >= VK_API_VERSION_1_2;
+  bool extIndexing = features2 && isDeviceExtensionSupported(physicalDevice, VK_EXT_DESCRIPTOR_INDEXING_EXTENSION_NAME) &&
+                     isDeviceExtensionSupported(physicalDevice, VK_KHR_MAINTENANCE3_EXTENSION_NAME);
+  if (coreIndexing || extIndexing) {
+    VkPhysicalDeviceDescriptorIndexingFeatures supportedIndexing{};
+    supportedIndexing.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_FEATURES;
+    VkPhysicalDeviceFeatures2 supportedFeatures{};
+    supportedFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+    supportedFeatures.pNext = &supportedIndexing;
+    vkGetPhysicalDeviceFeatures2(physicalDevice, &supportedFeatures);
+
+    descriptorIndexingEnabled = supportedIndexing.runtimeDescriptorArray &&
+                                supportedIndexing.descriptorBindingPartiallyBound &&
+                                supportedIndexing.descriptorBindingSampledImageUpdateAfterBind &&
+                                supportedIndexing.descriptorBindingStorageBufferUpdateAfterBind &&
+                                supportedIndexing.shaderSampledImageArrayNonUniformIndexing;
+  }
+
+  VkPhysicalDeviceDescriptorIndexingFeatures indexingFeatures{};
+  indexingFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_FEATURES;
+  if (descriptorIndexingEnabled) {
+    indexingFeatures.runtimeDescriptorArray = VK_TRUE;
+    indexingFeatures.descriptorBindingPartiallyBound = VK_TRUE;
+    indexingFeatures.descriptorBindingSampledImageUpdateAfterBind = VK_TRUE;
+    indexingFeatures.descriptorBindingStorageBufferUpdateAfterBind = VK_TRUE;
+    indexingFeatures.shaderSampledImageArrayNonUniformIndexing = VK_TRUE;
+    if (!coreIndexing) {
+      enabledExtensions.push_back(VK_KHR_MAINTENANCE3_EXTENSION_NAME);
+      enabledExtensions.push_back(VK_EXT_DESCRIPTOR_INDEXING_EXTENSION_NAME);
+    }
+
+    descriptorIndexingProperties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_PROPERTIES;
+    VkPhysicalDeviceProperties2 properties2{};
+    properties2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2;
+    properties2.pNext = &descriptorIndexingProperties;
+    vkGetPhysicalDeviceProperties2(physicalDevice, &properties2);
+    descriptorIndexingProperties.pNext = nullptr;
+  }
+
+  // render straight into image views without render pass / framebuffer objects. the KHR extension
+  // needs depth_stencil_resolve, which is core from 1.2
+  VkPhysicalDeviceDynamicRenderingFeaturesKHR dynamicRenderingFeatures{};
+  dynamicRenderingFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DYNAMIC_RENDERING_FEATURES_KHR;
+  if (apiVersion >= VK_API_VERSION_1_2 &&
+      isDeviceExtensionSupported(physicalDevice, VK_KHR_DYNAMIC_RENDERING_EXTENSION_NAME)) {
+    VkPhysicalDeviceFeatures2 supportedFeatures{};
+    supportedFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+    supportedFeatures.pNext = &dynamicRenderingFeatures;
+    vkGetPhysicalDeviceFeatures2(physicalDevice, &supportedFeatures);
+    dynamicRenderingEnabled = dynamicRenderingFeatures.dynamicRendering == VK_TRUE;
+    dynamicRenderingFeatures.pNext = nullptr;
+  }
+  if (dynamicRenderingEnabled) {
+    enabledExtensions.push_back(VK_KHR_DYNAMIC_RENDERING_EXTENSION_NAME);
+  }
+
+  // per heap budget and usage as the driver sees them, read through vkGetPhysicalDeviceMemoryProperties2
+  memoryBudgetEnabled = features2 &&
+                        isDeviceExtensionSupported(physicalDevice, VK_EXT_MEMORY_BUDGET_EXTENSION_NAME);
+  if (memoryBudgetEnabled) {
+    enabledExtensions.push_back(VK_EXT_MEMORY_BUDGET_EXTENSION_NAME);
+  }
+
+  VkPhysicalDeviceFeatures2 deviceFeatures{};
+  deviceFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+  deviceFeatures.features.samplerAnisotropy = VK_TRUE;
+  // cooked textures are bc compressed
+  VkPhysicalDeviceFeatures supported;
+  vkGetPhysicalDeviceFeatures(physicalDevice, &supported);
+  deviceFeatures.features.textureCompressionBC = supported.textureCompressionBC;
+  void **featureChain = &deviceFeatures.pNext;
+  if (descriptorIndexingEnabled) {
+    *featureChain = &indexingFeatures;
+    featureChain = &indexingFeatures.pNext;
+  }
+  if (dynamicRenderingEnabled) {
+    *featureChain = &dynamicRenderingFeatures;
+    featureChain = &dynamicRenderingFeatures.pNext;
+  }
 
   VkDeviceCreateInfo createInfo = {};
   createInfo.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
+  // a 1.0 device only takes the plain struct, and nothing was chained onto it above
+  if (features2) {
+    createInfo.pNext = &deviceFeatures;
+  } else {
+    createInfo.pEnabledFeatures = &deviceFeatures.features;
+  }
 
   createInfo.queueCreateInfoCount = static_cast<uint32_t>(queueCreateInfos.size());
   createInfo.pQueueCreateInfos = queueCreateInfos.data();
 
-  createInfo.ppEnabledExtensionNames = deviceExtensions.data();
-  createInfo.pEnabledFeatures = &deviceFeatures;
-  createInfo.enabledExtensionCount = static_cast<uint32_t>(deviceExtensions.size());
+  createInfo.ppEnabledExtensionNames = enabledExtensions.data();
+  createInfo.enabledExtensionCount = static_cast<uint32_t>(enabledExtensions.size());
 
   if (enableValidationLayers) {
     createInfo.enabledLayerCount = static_cast<uint32_t>(validationLayers.size());
@@ -177,6 +283,17 @@ void VDevice::createLogicalDevice() {
 
   vkGetDeviceQueue(device_, indices.graphicsFamily, 0, &graphicsQueue_);
   vkGetDeviceQueue(device_, indices.presentFamily, 0, &presentQueue_);
+  vkGetDeviceQueue(device_, indices.computeFamily, 0, &computeQueue_);
+  graphicsFamilyIndex = indices.graphicsFamily;
+  computeFamilyIndex = indices.computeFamily;
+  dedicatedComputeQueue = indices.dedicatedCompute;
+
+  memoryBudget.init(physicalDevice, memoryBudgetEnabled, VSwapChain::MAX_FRAMES_IN_FLIGHT);
+
+  if (dynamicRenderingEnabled) {
+    cmdBeginRendering = reinterpret_cast<PFN_vkCmdBeginRenderingKHR>(vkGetDeviceProcAddr(device_, "vkCmdBeginRenderingKHR"));
+    cmdEndRendering = reinterpret_cast<PFN_vkCmdEndRenderingKHR>(vkGetDeviceProcAddr(device_, "vkCmdEndRenderingKHR"));
+  }
 }
 
 void VDevice::createCommandPool() {
@@ -191,6 +308,58 @@ void VDevice::createCommandPool() {
   if (vkCreateCommandPool(device_, &poolInfo, nullptr, &commandPool) != VK_SUCCESS) {
     throw std::runtime_error("failed to create command pool!");
   }
+
+  if (!queueFamilyIndices.dedicatedCompute) {
+    computeCommandPool = commandPool;
+    return;
+  }
+  poolInfo.queueFamilyIndex = queueFamilyIndices.computeFamily;
+  if (vkCreateCommandPool(device_, &poolInfo, nullptr, &computeCommandPool) != VK_SUCCESS) {
+    throw std::runtime_error("failed to create compute command pool!");
+  }
+}
+
+void VDevice::createPipelineCache() {
+  // a cache written by another driver or gpu is useless, the header says which one made it
+  std::vector<char> data;
+  std::ifstream file(pipelineCachePath, std::ios::ate | std::ios::binary);
+  if (file.is_open()) {
+    data.resize(static_cast<size_t>(file.tellg()));
+    file.seekg(0);
+    file.read(data.data(), data.size());
+  }
+
+  constexpr size_t HEADER_SIZE = 16 + VK_UUID_SIZE;
+  bool valid = data.size() >= HEADER_SIZE;
+  if (valid) {
+    uint32_t header[4];
+    std::memcpy(header, data.data(), sizeof(header));
+    valid = header[0] >= HEADER_SIZE && header[1] == VK_PIPELINE_CACHE_HEADER_VERSION_ONE &&
+            header[2] == properties.vendorID && header[3] == properties.deviceID &&
+            std::memcmp(data.data() + 16, properties.pipelineCacheUUID, VK_UUID_SIZE) == 0;
+  }
+
+  VkPipelineCacheCreateInfo cacheInfo = {};
+  cacheInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+  cacheInfo.initialDataSize = valid ? data.size() : 0;
+  cacheInfo.pInitialData = valid ? data.data() : nullptr;
+
+  if (vkCreatePipelineCache(device_, &cacheInfo, nullptr, &pipelineCache) != VK_SUCCESS) {
+    throw std::runtime_error("failed to create pipeline cache!");
+  }
+}
+
+void VDevice::savePipelineCache() {
+  size_t size = 0;
+  if (vkGetPipelineCacheData(device_, pipelineCache, &size, nullptr) != VK_SUCCESS || size == 0) {
+    return;
+  }
+  std::vector<char> data(size);
+  if (vkGetPipelineCacheData(device_, pipelineCache, &size, data.data()) != VK_SUCCESS) {
+    return;
+  }
+  std::ofstream file(pipelineCachePath, std::ios::binary | std::ios::trunc);
+  file.write(data.data(), size);
 }
 
 void VDevice::createSurface() { window.createWindowSurface(instance, &surface_); }
@@ -202,7 +371,8 @@ bool VDevice::isDeviceSuitable(VkPhysicalDevice device) {
 
   bool swapChainAdequate = false;
   if (extensionsSupported) {
-    SwapChainSupportDetails swapChainSupport = querySwapChainSupport(device);
+    VScratchArena<1024> scratch;
+    SwapChainSupportDetails swapChainSupport = querySwapChainSupport(device, &scratch);
     swapChainAdequate = !swapChainSupport.formats.empty() && !swapChainSupport.presentModes.empty();
   }
 
@@ -317,6 +487,25 @@ bool VDevice::checkDeviceExtensionSupport(VkPhysicalDevice device) {
   return requiredExtensions.empty();
 }
 
+bool VDevice::isDeviceExtensionSupported(VkPhysicalDevice device, const char *extensionName) {
+  uint32_t extensionCount;
+  vkEnumerateDeviceExtensionProperties(device, nullptr, &extensionCount, nullptr);
+
+  std::vector<VkExtensionProperties> availableExtensions(extensionCount);
+  vkEnumerateDeviceExtensionProperties(
+      device,
+      nullptr,
+      &extensionCount,
+      availableExtensions.data());
+
+  for (const auto &extension : availableExtensions) {
+    if (strcmp(extension.extensionName, extensionName) == 0) {
+      return true;
+    }
+  }
+  return false;
+}
+
 QueueFamilyIndices VDevice::findQueueFamilies(VkPhysicalDevice device) {
   QueueFamilyIndices indices;
 
@@ -328,28 +517,44 @@ QueueFamilyIndices VDevice::findQueueFamilies(VkPhysicalDevice device) {
 
   int i = 0;
   for (const auto &queueFamily : queueFamilies) {
-    if (queueFamily.queueCount > 0 && queueFamily.queueFlags & VK_QUEUE_GRAPHICS_BIT) {
-      indices.graphicsFamily = i;
-      indices.graphicsFamilyHasValue = true;
+    if (!indices.isComplete()) {
+      if (queueFamily.queueCount > 0 && queueFamily.queueFlags & VK_QUEUE_GRAPHICS_BIT) {
+        indices.graphicsFamily = i;
+        indices.graphicsFamilyHasValue = true;
+      }
+      VkBool32 presentSupport = false;
+      vkGetPhysicalDeviceSurfaceSupportKHR(device, i, surface_, &presentSupport);
+      if (queueFamily.queueCount > 0 && presentSupport) {
+        indices.presentFamily = i;
+        indices.presentFamilyHasValue = true;
+      }
     }
-    VkBool32 presentSupport = false;
-    vkGetPhysicalDeviceSurfaceSupportKHR(device, i, surface_, &presentSupport);
-    if (queueFamily.queueCount > 0 && presentSupport) {
-      indices.presentFamily = i;
-      indices.presentFamilyHasValue = true;
+    // compute without graphics runs next to the graphics queue instead of time slicing with it
+    if (!indices.dedicatedCompute && queueFamily.queueCount > 0 &&
+        (queueFamily.queueFlags & VK_QUEUE_COMPUTE_BIT) && !(queueFamily.queueFlags & VK_QUEUE_GRAPHICS_BIT)) {
+      indices.computeFamily = i;
+      indices.computeFamilyHasValue = true;
+      indices.dedicatedCompute = true;
     }
-    if (indices.isComplete()) {
+    if (indices.isComplete() && indices.dedicatedCompute) {
       break;
     }
 
     i++;
   }
 
+  // graphics families always support compute
+  if (!indices.dedicatedCompute && indices.graphicsFamilyHasValue) {
+    indices.computeFamily = indices.graphicsFamily;
+    indices.computeFamilyHasValue = true;
+  }
+
   return indices;
 }
 
-SwapChainSupportDetails VDevice::querySwapChainSupport(VkPhysicalDevice device) {
-  SwapChainSupportDetails details;
+SwapChainSupportDetails VDevice::querySwapChainSupport(
+    VkPhysicalDevice device, std::pmr::memory_resource *memory) {
+  SwapChainSupportDetails details{memory};
   vkGetPhysicalDeviceSurfaceCapabilitiesKHR(device, surface_, &details.capabilities);
 
   uint32_t formatCount;
@@ -403,17 +608,32 @@ uint32_t VDevice::findMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags prop
   throw std::runtime_error("failed to find suitable memory type!");
 }
 
+VkMemoryPropertyFlags VDevice::getMemoryTypeFlags(uint32_t memoryTypeIndex) {
+  VkPhysicalDeviceMemoryProperties memProperties;
+  vkGetPhysicalDeviceMemoryProperties(physicalDevice, &memProperties);
+  return memProperties.memoryTypes[memoryTypeIndex].propertyFlags;
+}
+
 void VDevice::createBuffer(
     VkDeviceSize size,
     VkBufferUsageFlags usage,
     VkMemoryPropertyFlags properties,
     VkBuffer &buffer,
-    VkDeviceMemory &bufferMemory) {
+    VkDeviceMemory &bufferMemory,
+    uint32_t *memoryTypeIndex,
+    bool sharedWithCompute) {
   VkBufferCreateInfo bufferInfo{};
   bufferInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
   bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
   bufferInfo.size = size;
   bufferInfo.usage = usage;
+  // used on both queues without ownership transfers
+  uint32_t queueFamilies[] = {graphicsFamilyIndex, computeFamilyIndex};
+  if (sharedWithCompute && dedicatedComputeQueue) {
+    bufferInfo.sharingMode = VK_SHARING_MODE_CONCURRENT;
+    bufferInfo.queueFamilyIndexCount = 2;
+    bufferInfo.pQueueFamilyIndices = queueFamilies;
+  }
 
   if (vkCreateBuffer(device_, &bufferInfo, nullptr, &buffer) != VK_SUCCESS) {
     throw std::runtime_error("failed to create vertex buffer!");
@@ -427,9 +647,12 @@ void VDevice::createBuffer(
   allocInfo.allocationSize = memRequirements.size;
   allocInfo.memoryTypeIndex = findMemoryType(memRequirements.memoryTypeBits, properties);
 
-  if (vkAllocateMemory(device_, &allocInfo, nullptr, &bufferMemory) != VK_SUCCESS) {
+  if (allocateMemory(allocInfo, bufferMemory) != VK_SUCCESS) {
     throw std::runtime_error("failed to allocate vertex buffer memory!");
   }
+  if (memoryTypeIndex != nullptr) {
+    *memoryTypeIndex = allocInfo.memoryTypeIndex;
+  }
 
   vkBindBufferMemory(device_, buffer, bufferMemory, 0);
 }
@@ -522,7 +745,7 @@ void VDevice::createImageWithInfo(
   allocInfo.allocationSize = memRequirements.size;
   allocInfo.memoryTypeIndex = findMemoryType(memRequirements.memoryTypeBits, properties);
 
-  if (vkAllocateMemory(device_, &allocInfo, nullptr, &imageMemory) != VK_SUCCESS) {
+  if (allocateMemory(allocInfo, imageMemory) != VK_SUCCESS) {
     throw std::runtime_error("failed to allocate image memory!");
   }
 
@@ -531,4 +754,24 @@ void VDevice::createImageWithInfo(
   }
 }
 
-} 
\ No newline at end of file
+VkResult VDevice::allocateMemory(const VkMemoryAllocateInfo &allocInfo, VkDeviceMemory &memory) {
+  memoryBudget.makeRoom(allocInfo.memoryTypeIndex, allocInfo.allocationSize);
+  VkResult result = vkAllocateMemory(device_, &allocInfo, nullptr, &memory);
+  if (result == VK_ERROR_OUT_OF_DEVICE_MEMORY && memoryBudget.evictAll(allocInfo.memoryTypeIndex)) {
+    result = vkAllocateMemory(device_, &allocInfo, nullptr, &memory);
+  }
+  if (result == VK_SUCCESS) {
+    memoryBudget.allocated(memory, allocInfo.memoryTypeIndex, allocInfo.allocationSize);
+  }
+  return result;
+}
+
+void VDevice::freeMemory(VkDeviceMemory memory) {
+  if (memory == VK_NULL_HANDLE) {
+    return;
+  }
+  memoryBudget.freed(memory);
+  vkFreeMemory(device_, memory, nullptr);
+}
+
+}
\ No newline at end of file
@@ -4,23 +4,36 @@
 #pragma once
 
 #include "VWindow.hpp"
+#include "v_alloc_counters.hpp"
+#include "v_memory_budget.hpp"
 
+#include <memory_resource>
 #include <string>
 #include <vector>
 
 namespace vwdw {
 
+class VShaderCompiler;
+
+// only ever needed while a swapchain is being created, the lists can live in a scratch arena
 struct SwapChainSupportDetails {
+  explicit SwapChainSupportDetails(std::pmr::memory_resource *memory = std::pmr::get_default_resource())
+      : formats{memory}, presentModes{memory} {}
+
   VkSurfaceCapabilitiesKHR capabilities;
-  std::vector<VkSurfaceFormatKHR> formats;
-  std::vector<VkPresentModeKHR> presentModes;
+  std::pmr::vector<VkSurfaceFormatKHR> formats;
+  std::pmr::vector<VkPresentModeKHR> presentModes;
 };
 
 struct QueueFamilyIndices {
   uint32_t graphicsFamily;
   uint32_t presentFamily;
+  // a compute only family when the device has one (async compute), otherwise the graphics family
+  uint32_t computeFamily;
   bool graphicsFamilyHasValue = false;
   bool presentFamilyHasValue = false;
+  bool computeFamilyHasValue = false;
+  bool dedicatedCompute = false;
   bool isComplete() { return graphicsFamilyHasValue && presentFamilyHasValue; }
 };
 
@@ -41,13 +54,28 @@ class VDevice {
   VDevice &operator=(VDevice &&) = delete;
 
   VkCommandPool getCommandPool() { return commandPool; }
+  // command buffers from this pool can only be submitted to computeQueue()
+  VkCommandPool getComputeCommandPool() { return computeCommandPool; }
   VkDevice device() { return device_; }
   VkSurfaceKHR surface() { return surface_; }
   VkQueue graphicsQueue() { return graphicsQueue_; }
   VkQueue presentQueue() { return presentQueue_; }
-
-  SwapChainSupportDetails getSwapChainSupport() { return querySwapChainSupport(physicalDevice); }
+  // the graphics queue when there is no dedicated compute family
+  VkQueue computeQueue() { return computeQueue_; }
+  bool hasDedicatedComputeQueue() const { return dedicatedComputeQueue; }
+  uint32_t graphicsQueueFamily() const { return graphicsFamilyIndex; }
+  uint32_t computeQueueFamily() const { return computeFamilyIndex; }
+  // shared by every graphics and compute pipeline, saved to disk on destruction
+  VkPipelineCache getPipelineCache() { return pipelineCache; }
+  // pipelines load glsl sources through it when set, without one only .spv files can be loaded
+  void setShaderCompiler(VShaderCompiler *compiler) { shaderCompiler = compiler; }
+  VShaderCompiler *getShaderCompiler() { return shaderCompiler; }
+
+  SwapChainSupportDetails getSwapChainSupport(std::pmr::memory_resource *memory = std::pmr::get_default_resource()) {
+    return querySwapChainSupport(physicalDevice, memory);
+  }
   uint32_t findMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags properties);
+  VkMemoryPropertyFlags getMemoryTypeFlags(uint32_t memoryTypeIndex);
   QueueFamilyIndices findPhysicalQueueFamilies() { return findQueueFamilies(physicalDevice); }
   VkFormat findSupportedFormat(
       const std::vector<VkFormat> &candidates, VkImageTiling tiling, VkFormatFeatureFlags features);
@@ -57,7 +85,9 @@ class VDevice {
       VkBufferUsageFlags usage,
       VkMemoryPropertyFlags properties,
       VkBuffer &buffer,
-      VkDeviceMemory &bufferMemory);
+      VkDeviceMemory &bufferMemory,
+      uint32_t *memoryTypeIndex = nullptr,
+      bool sharedWithCompute = false);
   VkCommandBuffer beginSingleTimeCommands();
   void endSingleTimeCommands(VkCommandBuffer commandBuffer);
   void copyBuffer(VkBuffer srcBuffer, VkBuffer dstBuffer, VkDeviceSize size);
@@ -70,7 +100,26 @@ class VDevice {
       VkImage &image,
       VkDeviceMemory &imageMemory);
 
+  // every allocation of device memory goes through these so the budget sees it. streamable resources
+  // are evicted first when it wouldn't fit, and once more if the driver runs out anyway
+  VkResult allocateMemory(const VkMemoryAllocateInfo &allocInfo, VkDeviceMemory &memory);
+  void freeMemory(VkDeviceMemory memory);
+  VMemoryBudget &getMemoryBudget() { return memoryBudget; }
+
   VkPhysicalDeviceProperties properties;
+  // the lower of what the loader and the device support, capped at the 1.2 the engine is written against
+  uint32_t apiVersion = VK_API_VERSION_1_0;
+  // only filled in when descriptor indexing is enabled
+  VkPhysicalDeviceDescriptorIndexingProperties descriptorIndexingProperties{};
+
+  bool supportsDescriptorIndexing() const { return descriptorIndexingEnabled; }
+  bool supportsDynamicRendering() const { return dynamicRenderingEnabled; }
+  // VK_EXT_memory_budget, the budget falls back to its own accounting without it
+  bool supportsMemoryBudget() const { return memoryBudgetEnabled; }
+
+  // VK_KHR_dynamic_rendering entry points, null unless supportsDynamicRendering()
+  PFN_vkCmdBeginRenderingKHR cmdBeginRendering = nullptr;
+  PFN_vkCmdEndRenderingKHR cmdEndRendering = nullptr;
 
  private:
   void createInstance();
@@ -79,6 +128,8 @@ class VDevice {
   void pickPhysicalDevice();
   void createLogicalDevice();
   void createCommandPool();
+  void createPipelineCache();
+  void savePipelineCache();
 
   bool isDeviceSuitable(VkPhysicalDevice device);
   std::vector<const char *> getRequiredExtensions();
@@ -87,20 +138,35 @@ class VDevice {
   void populateDebugMessengerCreateInfo(VkDebugUtilsMessengerCreateInfoEXT &createInfo);
   void hasGflwRequiredInstanceExtensions();
   bool checkDeviceExtensionSupport(VkPhysicalDevice device);
-  SwapChainSupportDetails querySwapChainSupport(VkPhysicalDevice device);
+  bool isDeviceExtensionSupported(VkPhysicalDevice device, const char *extensionName);
+  SwapChainSupportDetails querySwapChainSupport(
+      VkPhysicalDevice device, std::pmr::memory_resource *memory = std::pmr::get_default_resource());
 
   VkInstance instance;
   VkDebugUtilsMessengerEXT debugMessenger;
   VkPhysicalDevice physicalDevice = VK_NULL_HANDLE;
   VWindow &window;
   VkCommandPool commandPool;
+  VkCommandPool computeCommandPool = VK_NULL_HANDLE;
+  VkPipelineCache pipelineCache = VK_NULL_HANDLE;
+  VShaderCompiler *shaderCompiler = nullptr;
 
   VkDevice device_;
   VkSurfaceKHR surface_;
   VkQueue graphicsQueue_;
   VkQueue presentQueue_;
+  VkQueue computeQueue_;
+  uint32_t graphicsFamilyIndex = 0;
+  uint32_t computeFamilyIndex = 0;
+  bool dedicatedComputeQueue = false;
+  bool descriptorIndexingEnabled = false;
+  bool dynamicRenderingEnabled = false;
+  bool memoryBudgetEnabled = false;
+  uint32_t instanceApiVersion = VK_API_VERSION_1_0;
+  VMemoryBudget memoryBudget;
 
   const std::vector<const char *> validationLayers = {"VK_LAYER_KHRONOS_validation"};
+  const std::string pipelineCachePath = "pipeline_cache.bin";
   const std::vector<const char *> deviceExtensions = {VK_KHR_SWAPCHAIN_EXTENSION_NAME};
 };
 
@@ -11,7 +11,8 @@ class VWindow {
 
 
 public:
-	VWindow(int w, int h, std::string name);
+	// an invisible window still gets a surface and swapchain, for running without anything on screen
+	VWindow(int w, int h, std::string name, bool visible = true);
 	~VWindow();
 
 	VWindow(const VWindow&) = delete;
@@ -36,6 +37,7 @@ private:
 	void initWindow();
 	int width;
 	int height;
+	bool visible;
 	bool framebufferResized = false;
 
 	std::string windowName;
@@ -1,17 +1,73 @@
 #include "Engine.hpp"
+#include "v_benchmarks.hpp"
+#include "v_cooker.hpp"
 
 // std
 #include <cstdlib>
 #include <iostream>
 #include <stdexcept>
+#include <string>
 
-int main() {
+int main(int argc, char** argv) {
 
-	vwdw::Engine app{};
+	if (argc > 2 && std::string(argv[1]) == "--bench") {
+		return vwdw::runBenchmark(argv[2]);
+	}
+	if (argc > 3 && std::string(argv[1]) == "--cook") {
+		return vwdw::runCooker(argv[2], argv[3]);
+	}
+
+	vwdw::EngineOptions options{};
+	for (int i = 1; i < argc; i++) {
+		if (std::string(argv[i]) == "--depth-prepass") {
+			options.depthPrepass = true;
+		}
+		if (std::string(argv[i]) == "--cull-back-faces") {
+			options.cullBackFaces = true;
+		}
+		if (std::string(argv[i]) == "--dynamic-rendering") {
+			options.dynamicRendering = true;
+		}
+		if (std::string(argv[i]) == "--runtime-shaders") {
+			options.runtimeShaders = true;
+		}
+		if (std::string(argv[i]) == "--hot-reload") {
+			options.hotReload = true;
+		}
+		if (std::string(argv[i]) == "--pipelined") {
+			options.pipelined = true;
+		}
+		if (std::string(argv[i]) == "--check-allocations" && i + 1 < argc) {
+			options.allocationCheckFrames = static_cast<uint32_t>(std::strtoul(argv[++i], nullptr, 10));
+		}
+		if (std::string(argv[i]) == "--memory-budget" && i + 1 < argc) {
+			options.memoryBudgetMiB = static_cast<uint32_t>(std::strtoul(argv[++i], nullptr, 10));
+		}
+		if ((std::string(argv[i]) == "--capture" || std::string(argv[i]) == "--capture-raw") && i + 1 < argc) {
+			options.captureRaw = std::string(argv[i]) == "--capture-raw";
+			options.captureDir = argv[++i];
+		}
+		if (std::string(argv[i]) == "--capture-draws" && i + 1 < argc) {
+			options.drawCapturePath = argv[++i];
+		}
+		if (std::string(argv[i]) == "--replay" && i + 1 < argc) {
+			options.replayPath = argv[++i];
+		}
+		if (std::string(argv[i]) == "--iterations" && i + 1 < argc) {
+			options.replayIterations = static_cast<uint32_t>(std::strtoul(argv[++i], nullptr, 10));
+		}
+		if (std::string(argv[i]) == "--particles" && i + 1 < argc) {
+			options.particleCount = static_cast<uint32_t>(std::strtoul(argv[++i], nullptr, 10));
+		}
+	}
+
+	vwdw::Engine app{ options };
 
 	try {
 		app.run();
-
+		if (!app.allocationCheckPassed()) {
+			return EXIT_FAILURE;
+		}
 	}
 	catch (const std::exception& e) {
 		std::cerr << e.what() << '\n';
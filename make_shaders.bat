@@ -1,5 +1,12 @@
-REM add shaders using this pattern
+REM not needed to run, the cooker compiles Shaders/*.vert etc. itself and a source wins over its .spv. add shaders using this pattern
 
 C:/VulkanSDK/1.3.283.0/Bin/glslc.exe Shaders/simple_shader.vert -o Shaders/simple_shader.vert.spv
 C:/VulkanSDK/1.3.283.0/Bin/glslc.exe Shaders/simple_shader.frag -o Shaders/simple_shader.frag.spv
+C:/VulkanSDK/1.3.283.0/Bin/glslc.exe Shaders/simple_shader_bindless.frag -o Shaders/simple_shader_bindless.frag.spv
+C:/VulkanSDK/1.3.283.0/Bin/glslc.exe Shaders/depth_only.vert -o Shaders/depth_only.vert.spv
+C:/VulkanSDK/1.3.283.0/Bin/glslc.exe Shaders/particle_emit.comp -o Shaders/particle_emit.comp.spv
+C:/VulkanSDK/1.3.283.0/Bin/glslc.exe Shaders/particle_simulate.comp -o Shaders/particle_simulate.comp.spv
+C:/VulkanSDK/1.3.283.0/Bin/glslc.exe Shaders/particle_indirect.comp -o Shaders/particle_indirect.comp.spv
+C:/VulkanSDK/1.3.283.0/Bin/glslc.exe Shaders/particle.vert -o Shaders/particle.vert.spv
+C:/VulkanSDK/1.3.283.0/Bin/glslc.exe Shaders/particle.frag -o Shaders/particle.frag.spv
 pause
\ No newline at end of file
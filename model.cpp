@@ -1,32 +1,95 @@
 #include "model.hpp"
+#include "v_asset_formats.hpp"
 #include<cassert>
 #include<cstring>
+#include<fstream>
+#include<stdexcept>
 
 
 namespace vwdw {
 
-VModel::VModel(VDevice& device, const std::vector<Vertex>& verts): vDevice{device}
+VModel::VModel(VDevice& device, const std::vector<Vertex>& verts, const std::vector<uint32_t>& indices): vDevice{device}
 {
 	createVertexBuffers(verts);
+	createIndexBuffer(indices);
+	computeBounds(verts);
+}
+
+std::unique_ptr<VModel> VModel::loadCooked(VDevice& device, const std::string& path)
+{
+	std::vector<Vertex> verts;
+	std::vector<uint32_t> indices;
+	readCooked(path, verts, indices);
+	return std::make_unique<VModel>(device, verts, indices);
+}
+
+void VModel::readCooked(const std::string& path, std::vector<Vertex>& verts, std::vector<uint32_t>& indices)
+{
+	std::ifstream file{ path, std::ios::binary };
+	if (!file.is_open())
+	{
+		throw std::runtime_error("failed to open file: " + path);
+	}
+
+	CookedMeshHeader header{};
+	file.read(reinterpret_cast<char*>(&header), sizeof(header));
+	if (!file || header.magic != COOKED_MESH_MAGIC || header.version != COOKED_MESH_VERSION)
+	{
+		throw std::runtime_error("not a cooked mesh: " + path);
+	}
+
+	// the counts have to match the bytes that follow before anything is sized from them
+	file.seekg(0, std::ios::end);
+	uint64_t remaining = static_cast<uint64_t>(file.tellg()) - sizeof(header);
+	file.seekg(sizeof(header));
+	if (static_cast<uint64_t>(header.vertexCount) * sizeof(Vertex) + static_cast<uint64_t>(header.indexCount) * sizeof(uint32_t) != remaining)
+	{
+		throw std::runtime_error("truncated cooked mesh: " + path);
+	}
+
+	verts.resize(header.vertexCount);
+	indices.resize(header.indexCount);
+	file.read(reinterpret_cast<char*>(verts.data()), sizeof(Vertex) * verts.size());
+	file.read(reinterpret_cast<char*>(indices.data()), sizeof(uint32_t) * indices.size());
+	if (!file)
+	{
+		throw std::runtime_error("truncated cooked mesh: " + path);
+	}
+	for (uint32_t index : indices)
+	{
+		if (index >= header.vertexCount)
+		{
+			throw std::runtime_error("cooked mesh index out of range: " + path);
+		}
+	}
 }
 
 VModel::~VModel()
 {
-	vkDestroyBuffer(vDevice.device(), vertexBuffer, nullptr);
-	vkFreeMemory(vDevice.device(), vBufferMem, nullptr);
 }
 
 
 void VModel::bind(VkCommandBuffer cBuffer)
 {
-	VkBuffer buffers[] = { vertexBuffer };
+	VkBuffer buffers[] = { vertexBuffer->getBuffer() };
 	VkDeviceSize offsets[] = { 0 };
 	vkCmdBindVertexBuffers(cBuffer, 0, 1, buffers, offsets);
+	if (indexBuffer)
+	{
+		vkCmdBindIndexBuffer(cBuffer, indexBuffer->getBuffer(), 0, VK_INDEX_TYPE_UINT32);
+	}
 }
 
 void VModel::draw(VkCommandBuffer cBuffer)
 {
-	vkCmdDraw(cBuffer, vertexCount, 1, 0, 0);
+	if (indexBuffer)
+	{
+		vkCmdDrawIndexed(cBuffer, indexCount, 1, 0, 0, 0);
+	}
+	else
+	{
+		vkCmdDraw(cBuffer, vertexCount, 1, 0, 0);
+	}
 }
 
 void VModel::createVertexBuffers(const std::vector<Vertex>& verts)
@@ -35,29 +98,57 @@ void VModel::createVertexBuffers(const std::vector<Vertex>& verts)
 
 	assert(vertexCount >= 3 && "vertex count must be atleast 3");
 	VkDeviceSize bufferSize = sizeof(verts[0])*vertexCount;
-	vDevice.createBuffer(bufferSize, VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, vertexBuffer, vBufferMem);
+	vertexBuffer = std::make_unique<VBuffer>(vDevice, bufferSize, VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT);
+	vertexBuffer->write(verts.data(), bufferSize);
+
+}
+
+void VModel::createIndexBuffer(const std::vector<uint32_t>& indices)
+{
+	indexCount = static_cast<uint32_t>(indices.size());
+	if (indexCount == 0)
+	{
+		return;
+	}
+
+	VkDeviceSize bufferSize = sizeof(indices[0]) * indexCount;
+	indexBuffer = std::make_unique<VBuffer>(vDevice, bufferSize, VK_BUFFER_USAGE_INDEX_BUFFER_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT);
+	indexBuffer->write(indices.data(), bufferSize);
+}
 
-	void *data;
-	vkMapMemory(vDevice.device(), vBufferMem, 0, bufferSize, 0, &data);
-	memcpy(data, verts.data(), static_cast<size_t>(bufferSize));
-	vkUnmapMemory(vDevice.device(), vBufferMem);
+void VModel::computeBounds(const std::vector<Vertex>& verts)
+{
+	bounds.min = verts[0].pos;
+	bounds.max = bounds.min;
+	for (const auto& v : verts)
+	{
+		bounds.min = glm::min(bounds.min, v.pos);
+		bounds.max = glm::max(bounds.max, v.pos);
+	}
 
+	bounds.center = (bounds.min + bounds.max) * 0.5f;
+	bounds.radius = 0.0f;
+	for (const auto& v : verts)
+	{
+		float dist = glm::length(v.pos - bounds.center);
+		bounds.radius = dist > bounds.radius ? dist : bounds.radius;
+	}
 }
 
-std::vector<VkVertexInputBindingDescription> VModel::Vertex::getBindingDescriptions()
+std::pmr::vector<VkVertexInputBindingDescription> VModel::Vertex::getBindingDescriptions(std::pmr::memory_resource* memory)
 {
-	std::vector<VkVertexInputBindingDescription> bindingDescriptions(1);
+	std::pmr::vector<VkVertexInputBindingDescription> bindingDescriptions(1, memory);
 	bindingDescriptions[0].stride = sizeof(Vertex);
 	bindingDescriptions[0].inputRate = VK_VERTEX_INPUT_RATE_VERTEX;
 	bindingDescriptions[0].binding = 0;
 	return bindingDescriptions;
 }
 
-std::vector<VkVertexInputAttributeDescription> VModel::Vertex::getAttributeDescriptions()
+std::pmr::vector<VkVertexInputAttributeDescription> VModel::Vertex::getAttributeDescriptions(std::pmr::memory_resource* memory)
 {
-	std::vector<VkVertexInputAttributeDescription> attrDescriptions(2);
+	std::pmr::vector<VkVertexInputAttributeDescription> attrDescriptions(2, memory);
 	attrDescriptions[0].location = 0;
-	attrDescriptions[0].format = VK_FORMAT_R32G32_SFLOAT;
+	attrDescriptions[0].format = VK_FORMAT_R32G32B32_SFLOAT;
 	attrDescriptions[0].binding = 0;
 	attrDescriptions[0].offset = offsetof(Vertex, pos);
 
@@ -1,9 +1,13 @@
 #pragma once
 
 #include "VDevice.hpp"
+#include "v_buffer.hpp"
 #define GLM_FORCE_RADIANS
 #define GLM_FORCE_DEPTH_ZERO_TO_ONE
 #include<glm/glm.hpp>
+#include<memory>
+#include<memory_resource>
+#include<string>
 #include<vector>
 
 
@@ -13,30 +17,50 @@ namespace vwdw {
 	public:
 
 		struct Vertex {
-			glm::vec2 pos;
+			glm::vec3 pos;
 			glm::vec3 color;
 			
-			static std::vector<VkVertexInputBindingDescription> getBindingDescriptions();
-			static std::vector<VkVertexInputAttributeDescription> getAttributeDescriptions();
+			// only needed while a pipeline is created, pass a scratch arena to keep them off the heap
+			static std::pmr::vector<VkVertexInputBindingDescription> getBindingDescriptions(std::pmr::memory_resource* memory = std::pmr::get_default_resource());
+			static std::pmr::vector<VkVertexInputAttributeDescription> getAttributeDescriptions(std::pmr::memory_resource* memory = std::pmr::get_default_resource());
 		};
 
-		VModel(VDevice &device, const std::vector<Vertex> &verts);
+		// object space bounds, used by the frustum culler
+		struct Bounds {
+			glm::vec3 min{ 0.0f };
+			glm::vec3 max{ 0.0f };
+			glm::vec3 center{ 0.0f };
+			float radius = 0.0f;
+		};
+
+		VModel(VDevice &device, const std::vector<Vertex> &verts, const std::vector<uint32_t> &indices = {});
 		~VModel();
 
+		// reads a .vmesh written by the asset cooker
+		static std::unique_ptr<VModel> loadCooked(VDevice &device, const std::string &path);
+		// just the file, for building the model somewhere else (a handle pool)
+		static void readCooked(const std::string &path, std::vector<Vertex> &verts, std::vector<uint32_t> &indices);
+
 		VModel(const VModel&) = delete;
 		VModel& operator=(const VModel&) = delete;
 
 		void bind(VkCommandBuffer cBuffer);
 		void draw(VkCommandBuffer cBuffer);
 
+		const Bounds& getBounds() const { return bounds; }
 
 	private:
 		void createVertexBuffers(const std::vector<Vertex>& verts);
+		void createIndexBuffer(const std::vector<uint32_t>& indices);
+		void computeBounds(const std::vector<Vertex>& verts);
 
 		VDevice &vDevice;
-		VkBuffer vertexBuffer;
-		VkDeviceMemory vBufferMem;
+		std::unique_ptr<VBuffer> vertexBuffer;
 		uint32_t vertexCount;
+		// null for non indexed models
+		std::unique_ptr<VBuffer> indexBuffer;
+		uint32_t indexCount = 0;
+		Bounds bounds;
 	};
 
 }
\ No newline at end of file
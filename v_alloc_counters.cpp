@@ -0,0 +1,120 @@
+#include "v_alloc_counters.hpp"
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+namespace vwdw {
+
+// plain globals with constant initialization, operator new can run before any constructor does
+static std::atomic<uint64_t> heapAllocations{ 0 };
+static std::atomic<uint64_t> heapBytes{ 0 };
+static std::atomic<uint64_t> vulkanObjects{ 0 };
+
+VAllocationCounters readAllocationCounters()
+{
+	VAllocationCounters counters;
+	counters.heapAllocations = heapAllocations.load(std::memory_order_relaxed);
+	counters.heapBytes = heapBytes.load(std::memory_order_relaxed);
+	counters.vulkanObjects = vulkanObjects.load(std::memory_order_relaxed);
+	return counters;
+}
+
+void countVulkanObject()
+{
+	vulkanObjects.fetch_add(1, std::memory_order_relaxed);
+}
+
+static void* countedAlloc(size_t size)
+{
+	heapAllocations.fetch_add(1, std::memory_order_relaxed);
+	heapBytes.fetch_add(size, std::memory_order_relaxed);
+	return std::malloc(size == 0 ? 1 : size);
+}
+
+static void* countedAlignedAlloc(size_t size, size_t alignment)
+{
+	heapAllocations.fetch_add(1, std::memory_order_relaxed);
+	heapBytes.fetch_add(size, std::memory_order_relaxed);
+#ifdef _MSC_VER
+	return _aligned_malloc(size == 0 ? 1 : size, alignment);
+#else
+	// aligned_alloc wants a multiple of the alignment
+	size_t rounded = (size + alignment - 1) / alignment * alignment;
+	return std::aligned_alloc(alignment, rounded == 0 ? alignment : rounded);
+#endif
+}
+
+static void alignedFree(void* p)
+{
+#ifdef _MSC_VER
+	_aligned_free(p);
+#else
+	std::free(p);
+#endif
+}
+
+}
+
+// replacements for the global allocation functions, every new in the process is counted
+
+void* operator new(size_t size)
+{
+	if (void* p = vwdw::countedAlloc(size))
+	{
+		return p;
+	}
+	throw std::bad_alloc{};
+}
+
+void* operator new[](size_t size)
+{
+	return operator new(size);
+}
+
+void* operator new(size_t size, const std::nothrow_t&) noexcept
+{
+	return vwdw::countedAlloc(size);
+}
+
+void* operator new[](size_t size, const std::nothrow_t&) noexcept
+{
+	return vwdw::countedAlloc(size);
+}
+
+void* operator new(size_t size, std::align_val_t alignment)
+{
+	if (void* p = vwdw::countedAlignedAlloc(size, static_cast<size_t>(alignment)))
+	{
+		return p;
+	}
+	throw std::bad_alloc{};
+}
+
+void* operator new[](size_t size, std::align_val_t alignment)
+{
+	return operator new(size, alignment);
+}
+
+void* operator new(size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept
+{
+	return vwdw::countedAlignedAlloc(size, static_cast<size_t>(alignment));
+}
+
+void* operator new[](size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept
+{
+	return vwdw::countedAlignedAlloc(size, static_cast<size_t>(alignment));
+}
+
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete[](void* p) noexcept { std::free(p); }
+void operator delete(void* p, size_t) noexcept { std::free(p); }
+void operator delete[](void* p, size_t) noexcept { std::free(p); }
+void operator delete(void* p, const std::nothrow_t&) noexcept { std::free(p); }
+void operator delete[](void* p, const std::nothrow_t&) noexcept { std::free(p); }
+void operator delete(void* p, std::align_val_t) noexcept { vwdw::alignedFree(p); }
+void operator delete[](void* p, std::align_val_t) noexcept { vwdw::alignedFree(p); }
+void operator delete(void* p, size_t, std::align_val_t) noexcept { vwdw::alignedFree(p); }
+void operator delete[](void* p, size_t, std::align_val_t) noexcept { vwdw::alignedFree(p); }
+void operator delete(void* p, std::align_val_t, const std::nothrow_t&) noexcept { vwdw::alignedFree(p); }
+void operator delete[](void* p, std::align_val_t, const std::nothrow_t&) noexcept { vwdw::alignedFree(p); }
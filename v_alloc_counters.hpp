@@ -0,0 +1,51 @@
+#pragma once
+
+// vulkan.h has to be in before the macros below, or they'd rewrite its prototypes
+#include <vulkan/vulkan.h>
+
+#include <cstdint>
+
+namespace vwdw {
+
+	// running totals since startup over every thread. heap counts come from the replaced global
+	// operator new, vulkan counts from the vkCreate* / vkAllocate* wrappers below
+	struct VAllocationCounters {
+		uint64_t heapAllocations = 0;
+		uint64_t heapBytes = 0;
+		uint64_t vulkanObjects = 0;
+	};
+
+	VAllocationCounters readAllocationCounters();
+	void countVulkanObject();
+
+	inline VAllocationCounters operator-(const VAllocationCounters& a, const VAllocationCounters& b)
+	{
+		return { a.heapAllocations - b.heapAllocations, a.heapBytes - b.heapBytes, a.vulkanObjects - b.vulkanObjects };
+	}
+
+}
+
+// every create / allocate the engine calls goes through the counter. the name inside the expansion
+// isn't expanded again, so it still calls the real entry point
+#define VWDW_COUNT_VULKAN_OBJECT(call) (::vwdw::countVulkanObject(), call)
+
+#define vkAllocateCommandBuffers(...) VWDW_COUNT_VULKAN_OBJECT(vkAllocateCommandBuffers(__VA_ARGS__))
+#define vkAllocateDescriptorSets(...) VWDW_COUNT_VULKAN_OBJECT(vkAllocateDescriptorSets(__VA_ARGS__))
+#define vkAllocateMemory(...) VWDW_COUNT_VULKAN_OBJECT(vkAllocateMemory(__VA_ARGS__))
+#define vkCreateBuffer(...) VWDW_COUNT_VULKAN_OBJECT(vkCreateBuffer(__VA_ARGS__))
+#define vkCreateCommandPool(...) VWDW_COUNT_VULKAN_OBJECT(vkCreateCommandPool(__VA_ARGS__))
+#define vkCreateComputePipelines(...) VWDW_COUNT_VULKAN_OBJECT(vkCreateComputePipelines(__VA_ARGS__))
+#define vkCreateDescriptorPool(...) VWDW_COUNT_VULKAN_OBJECT(vkCreateDescriptorPool(__VA_ARGS__))
+#define vkCreateDescriptorSetLayout(...) VWDW_COUNT_VULKAN_OBJECT(vkCreateDescriptorSetLayout(__VA_ARGS__))
+#define vkCreateFence(...) VWDW_COUNT_VULKAN_OBJECT(vkCreateFence(__VA_ARGS__))
+#define vkCreateFramebuffer(...) VWDW_COUNT_VULKAN_OBJECT(vkCreateFramebuffer(__VA_ARGS__))
+#define vkCreateGraphicsPipelines(...) VWDW_COUNT_VULKAN_OBJECT(vkCreateGraphicsPipelines(__VA_ARGS__))
+#define vkCreateImage(...) VWDW_COUNT_VULKAN_OBJECT(vkCreateImage(__VA_ARGS__))
+#define vkCreateImageView(...) VWDW_COUNT_VULKAN_OBJECT(vkCreateImageView(__VA_ARGS__))
+#define vkCreatePipelineCache(...) VWDW_COUNT_VULKAN_OBJECT(vkCreatePipelineCache(__VA_ARGS__))
+#define vkCreatePipelineLayout(...) VWDW_COUNT_VULKAN_OBJECT(vkCreatePipelineLayout(__VA_ARGS__))
+#define vkCreateRenderPass(...) VWDW_COUNT_VULKAN_OBJECT(vkCreateRenderPass(__VA_ARGS__))
+#define vkCreateSampler(...) VWDW_COUNT_VULKAN_OBJECT(vkCreateSampler(__VA_ARGS__))
+#define vkCreateSemaphore(...) VWDW_COUNT_VULKAN_OBJECT(vkCreateSemaphore(__VA_ARGS__))
+#define vkCreateShaderModule(...) VWDW_COUNT_VULKAN_OBJECT(vkCreateShaderModule(__VA_ARGS__))
+#define vkCreateSwapchainKHR(...) VWDW_COUNT_VULKAN_OBJECT(vkCreateSwapchainKHR(__VA_ARGS__))
@@ -0,0 +1,33 @@
+#pragma once
+
+#include <cstdint>
+
+namespace vwdw {
+
+	// layouts of the files written by the asset cooker, little endian and read back as raw structs
+
+	static constexpr uint32_t COOKED_MESH_MAGIC = 0x48534D56; // "VMSH"
+	static constexpr uint32_t COOKED_MESH_VERSION = 1;
+
+	// followed by vertexCount VModel::Vertex then indexCount uint32_t indices
+	struct CookedMeshHeader {
+		uint32_t magic;
+		uint32_t version;
+		uint32_t vertexCount;
+		uint32_t indexCount;
+	};
+
+	static constexpr uint32_t COOKED_TEXTURE_MAGIC = 0x58455456; // "VTEX"
+	static constexpr uint32_t COOKED_TEXTURE_VERSION = 1;
+
+	// followed by mipLevels of (uint32_t byte size, bytes), largest level first
+	struct CookedTextureHeader {
+		uint32_t magic;
+		uint32_t version;
+		uint32_t format; // VkFormat
+		uint32_t width;
+		uint32_t height;
+		uint32_t mipLevels;
+	};
+
+}
@@ -0,0 +1,902 @@
+#include "v_benchmarks.hpp"
+
+#include "v_culling.hpp"
+#include "v_scene.hpp"
+#include "v_render_queue.hpp"
+#include "v_frame_graph.hpp"
+#include "v_jobs.hpp"
+#include "v_resize.hpp"
+#include "v_handle_pool.hpp"
+#include "v_image.hpp"
+#include "v_frame_arena.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <thread>
+#include <vector>
+
+namespace vwdw {
+
+using BenchClock = std::chrono::steady_clock;
+
+static double elapsedMs(BenchClock::time_point start)
+{
+	return std::chrono::duration<double, std::milli>(BenchClock::now() - start).count();
+}
+
+static int benchCulling()
+{
+	constexpr uint32_t OBJECT_COUNT = 1000000;
+	constexpr int ITERATIONS = 20;
+
+	std::mt19937 rng{ 1234 };
+	std::uniform_real_distribution<float> position{ -200.0f, 200.0f };
+	std::uniform_real_distribution<float> size{ 0.25f, 2.0f };
+
+	std::vector<glm::vec3> centers(OBJECT_COUNT);
+	std::vector<float> radii(OBJECT_COUNT);
+
+	VFrustumCuller culler;
+	culler.reserve(OBJECT_COUNT);
+	for (uint32_t i = 0; i < OBJECT_COUNT; i++)
+	{
+		centers[i] = glm::vec3{ position(rng), position(rng), position(rng) };
+		radii[i] = size(rng);
+		glm::vec3 extent{ radii[i] * 0.7f };
+		culler.addObject(centers[i], radii[i], centers[i] - extent, centers[i] + extent);
+	}
+
+	// camera at the origin looking down -z, roughly 1/6 of the field is visible
+	glm::mat4 proj = glm::perspective(glm::radians(60.0f), 16.0f / 9.0f, 0.1f, 300.0f);
+	VFrustum frustum = VFrustum::fromViewProjection(proj);
+
+	// scalar sphere + box reference, one object at a time
+	size_t referenceVisible = 0;
+	auto start = BenchClock::now();
+	for (int it = 0; it < ITERATIONS; it++)
+	{
+		referenceVisible = 0;
+		for (uint32_t i = 0; i < OBJECT_COUNT; i++)
+		{
+			bool inside = true;
+			for (int p = 0; p < 6 && inside; p++)
+			{
+				const glm::vec4& pl = frustum.planes[p];
+				float d = pl.x * centers[i].x + pl.y * centers[i].y + pl.z * centers[i].z + pl.w;
+				float e = (std::fabs(pl.x) + std::fabs(pl.y) + std::fabs(pl.z)) * radii[i] * 0.7f;
+				inside = d + radii[i] >= 0.0f && d + e >= 0.0f;
+			}
+			referenceVisible += inside ? 1 : 0;
+		}
+	}
+	double scalarMs = elapsedMs(start) / ITERATIONS;
+
+	std::cout << "frustum culling, " << OBJECT_COUNT << " objects, " << VFrustumCuller::LANES << " lanes" << std::endl;
+	std::cout << "\tscalar reference: " << scalarMs << " ms, visible " << referenceVisible << std::endl;
+
+	VJobSystem jobSystem;
+	std::vector<VJobSystem*> jobSystems{ nullptr };
+	if (jobSystem.workerCount() > 1)
+	{
+		jobSystems.push_back(&jobSystem);
+	}
+
+	int result = 0;
+	for (VJobSystem* jobs : jobSystems)
+	{
+		culler.setJobSystem(jobs);
+		culler.cull(frustum);
+		uint32_t workers = culler.getWorkerCount();
+
+		start = BenchClock::now();
+		for (int it = 0; it < ITERATIONS; it++)
+		{
+			culler.cull(frustum);
+		}
+		double ms = elapsedMs(start) / ITERATIONS;
+
+		size_t visible = culler.visibleObjects().size();
+		std::cout << "\tsimd, " << workers << " worker(s): " << ms << " ms, "
+			<< (OBJECT_COUNT / ms) / 1000.0 << " Mobjects/s, " << scalarMs / ms << "x, visible " << visible << std::endl;
+		if (visible != referenceVisible)
+		{
+			std::cout << "\tvisible count does not match the scalar reference" << std::endl;
+			result = 1;
+		}
+	}
+	return result;
+}
+
+static glm::mat4 translation(float x, float y, float z)
+{
+	glm::mat4 m{ 1.0f };
+	m[3] = glm::vec4{ x, y, z, 1.0f };
+	return m;
+}
+
+static int benchScene()
+{
+	// 1000 roots x 9 children x 10 grandchildren = 100k nodes
+	constexpr uint32_t ROOTS = 1000;
+	constexpr uint32_t CHILDREN = 9;
+	constexpr uint32_t GRANDCHILDREN = 10;
+	constexpr int ITERATIONS = 200;
+
+	VScene scene;
+	scene.reserve(ROOTS * (1 + CHILDREN * (1 + GRANDCHILDREN)));
+	std::vector<VScene::NodeId> roots;
+	std::vector<VScene::NodeId> leaves;
+	for (uint32_t r = 0; r < ROOTS; r++)
+	{
+		VScene::NodeId root = scene.createNode(VScene::NO_NODE, translation(static_cast<float>(r), 0.0f, 0.0f));
+		roots.push_back(root);
+		for (uint32_t c = 0; c < CHILDREN; c++)
+		{
+			VScene::NodeId child = scene.createNode(root, translation(0.0f, static_cast<float>(c), 0.0f));
+			for (uint32_t g = 0; g < GRANDCHILDREN; g++)
+			{
+				leaves.push_back(scene.createNode(child, translation(0.0f, 0.0f, static_cast<float>(g))));
+			}
+		}
+	}
+
+	auto start = BenchClock::now();
+	scene.update();
+	double buildMs = elapsedMs(start);
+
+	std::cout << "scene transforms, " << scene.nodeCount() << " nodes" << std::endl;
+	std::cout << "	first update (order rebuild + full propagate): " << buildMs << " ms" << std::endl;
+
+	start = BenchClock::now();
+	size_t changed = 0;
+	for (int it = 0; it < ITERATIONS; it++)
+	{
+		changed += scene.update().size();
+	}
+	std::cout << "	static frame: " << elapsedMs(start) * 1000.0 / ITERATIONS << " us, " << changed / ITERATIONS << " nodes touched" << std::endl;
+
+	std::mt19937 rng{ 99 };
+	std::uniform_int_distribution<size_t> pickLeaf{ 0, leaves.size() - 1 };
+	std::uniform_int_distribution<size_t> pickRoot{ 0, roots.size() - 1 };
+
+	// ~1% of the scene moving: 10 whole root subtrees plus 100 loose leaves
+	start = BenchClock::now();
+	changed = 0;
+	for (int it = 0; it < ITERATIONS; it++)
+	{
+		for (int i = 0; i < 10; i++)
+		{
+			VScene::NodeId node = roots[pickRoot(rng)];
+			scene.setLocalTransform(node, translation(static_cast<float>(it), 1.0f, 0.0f));
+		}
+		for (int i = 0; i < 100; i++)
+		{
+			VScene::NodeId node = leaves[pickLeaf(rng)];
+			scene.setLocalTransform(node, translation(0.0f, 0.0f, static_cast<float>(it)));
+		}
+		changed += scene.update().size();
+	}
+	std::cout << "	~1% dynamic frame: " << elapsedMs(start) * 1000.0 / ITERATIONS << " us, " << changed / ITERATIONS << " nodes touched" << std::endl;
+
+	start = BenchClock::now();
+	for (int it = 0; it < ITERATIONS / 10; it++)
+	{
+		for (VScene::NodeId root : roots)
+		{
+			scene.setLocalTransform(root, translation(static_cast<float>(root), static_cast<float>(it), 0.0f));
+		}
+		scene.update();
+	}
+	std::cout << "	fully dynamic frame: " << elapsedMs(start) * 1000.0 / (ITERATIONS / 10) << " us" << std::endl;
+
+	// spot check against a plain matrix walk: leaf = root * child * leaf
+	int result = 0;
+	for (size_t i = 0; i < leaves.size(); i += 997)
+	{
+		VScene::NodeId leaf = leaves[i];
+		VScene::NodeId child = roots[i / (CHILDREN * GRANDCHILDREN)] + 1 + static_cast<VScene::NodeId>((i % (CHILDREN * GRANDCHILDREN)) / GRANDCHILDREN) * (GRANDCHILDREN + 1);
+		VScene::NodeId root = roots[i / (CHILDREN * GRANDCHILDREN)];
+		glm::mat4 expected = scene.getLocalTransform(root) * scene.getLocalTransform(child) * scene.getLocalTransform(leaf);
+		glm::vec4 got = scene.getWorldTransform(leaf)[3];
+		if (std::fabs(got.x - expected[3].x) > 1e-3f || std::fabs(got.y - expected[3].y) > 1e-3f || std::fabs(got.z - expected[3].z) > 1e-3f)
+		{
+			std::cout << "	world transform mismatch on node " << leaf << std::endl;
+			result = 1;
+		}
+	}
+	return result;
+}
+
+static int benchRenderQueue()
+{
+	constexpr uint32_t DRAWS = 100000;
+	constexpr uint32_t PIPELINES = 32;
+	constexpr uint32_t MESHES = 512;
+	constexpr int ITERATIONS = 50;
+
+	std::mt19937 rng{ 5 };
+	std::uniform_int_distribution<uint32_t> pickPipeline{ 0, PIPELINES - 1 };
+	std::uniform_int_distribution<uint32_t> pickMesh{ 0, MESHES - 1 };
+	std::uniform_real_distribution<float> pickDepth{ 0.0f, 1.0f };
+
+	std::vector<uint64_t> keys(DRAWS);
+	std::vector<VDrawItem> items(DRAWS);
+	for (uint32_t i = 0; i < DRAWS; i++)
+	{
+		uint32_t pipeline = pickPipeline(rng);
+		uint32_t mesh = pickMesh(rng);
+		keys[i] = VRenderQueue::makeKey(0, pipeline, 0, mesh, pickDepth(rng));
+		// simulate() never looks the handles up, they only need to be distinct
+		items[i].pipeline = VPipelineHandle{ pipeline, 0 };
+		items[i].mesh = VMeshHandle{ mesh, 0 };
+		items[i].object = i;
+	}
+
+	VRenderQueue queue;
+	queue.reserve(DRAWS);
+	for (uint32_t i = 0; i < DRAWS; i++)
+	{
+		queue.push(keys[i], items[i]);
+	}
+	VRenderQueue::Stats unsorted = queue.simulate();
+
+	double sortMs = 0.0;
+	for (int it = 0; it < ITERATIONS; it++)
+	{
+		queue.clear();
+		for (uint32_t i = 0; i < DRAWS; i++)
+		{
+			queue.push(keys[i], items[i]);
+		}
+		auto start = BenchClock::now();
+		queue.sort();
+		sortMs += elapsedMs(start);
+	}
+	VRenderQueue::Stats sorted = queue.simulate();
+
+	int result = 0;
+	for (uint32_t i = 1; i < queue.size(); i++)
+	{
+		const VDrawItem& a = queue.itemAt(i - 1);
+		const VDrawItem& b = queue.itemAt(i);
+		if (keys[a.object] > keys[b.object])
+		{
+			result = 1;
+		}
+	}
+
+	std::cout << "render queue, " << DRAWS << " draws, " << PIPELINES << " pipelines, " << MESHES << " meshes" << std::endl;
+	std::cout << "	radix sort: " << sortMs / ITERATIONS << " ms" << std::endl;
+	std::cout << "	submission order: " << unsorted.pipelineBinds << " pipeline binds, " << unsorted.vertexBinds << " vertex binds" << std::endl;
+	std::cout << "	sorted: " << sorted.pipelineBinds << " pipeline binds (" << sorted.pipelineBindsSkipped << " skipped), "
+		<< sorted.vertexBinds << " vertex binds (" << sorted.vertexBindsSkipped << " skipped)" << std::endl;
+	if (result != 0)
+	{
+		std::cout << "	queue is not sorted by key" << std::endl;
+	}
+	return result;
+}
+
+static int benchFrameGraph()
+{
+	constexpr uint32_t WIDTH = 2560;
+	constexpr uint32_t HEIGHT = 1440;
+	constexpr uint32_t SHADOW_SIZE = 4096;
+	constexpr uint32_t BLOOM_LEVELS = 5;
+	constexpr int ITERATIONS = 1000;
+	using Access = VFrameGraph::Access;
+
+	// a deferred frame: shadows, gbuffer, ssao, lighting, bloom, tonemap to the backbuffer,
+	// plus a debug view nobody reads that should get culled
+	VFrameGraph graph{ nullptr };
+	auto build = [&]() {
+		graph.reset();
+		auto backbuffer = graph.importImage("backbuffer", { WIDTH, HEIGHT, VK_FORMAT_B8G8R8A8_SRGB }, VK_IMAGE_LAYOUT_UNDEFINED, Access::Present);
+		auto shadow = graph.createTexture("shadow map", { SHADOW_SIZE, SHADOW_SIZE, VK_FORMAT_D32_SFLOAT });
+		auto depth = graph.createTexture("depth", { WIDTH, HEIGHT, VK_FORMAT_D32_SFLOAT });
+		auto albedo = graph.createTexture("albedo", { WIDTH, HEIGHT, VK_FORMAT_R8G8B8A8_UNORM });
+		auto normals = graph.createTexture("normals", { WIDTH, HEIGHT, VK_FORMAT_R16G16B16A16_SFLOAT });
+		auto ao = graph.createTexture("ssao", { WIDTH, HEIGHT, VK_FORMAT_R8_UNORM });
+		auto hdr = graph.createTexture("hdr", { WIDTH, HEIGHT, VK_FORMAT_R16G16B16A16_SFLOAT });
+		auto debug = graph.createTexture("debug view", { WIDTH, HEIGHT, VK_FORMAT_R8G8B8A8_UNORM });
+
+		graph.addPass("shadows", [&](VFrameGraph::PassBuilder& pass) { pass.write(shadow, Access::DepthAttachment); }, nullptr);
+		graph.addPass("gbuffer", [&](VFrameGraph::PassBuilder& pass) {
+			pass.write(depth, Access::DepthAttachment);
+			pass.write(albedo, Access::ColorAttachment);
+			pass.write(normals, Access::ColorAttachment);
+		}, nullptr);
+		graph.addPass("ssao", [&](VFrameGraph::PassBuilder& pass) {
+			pass.read(depth, Access::Sampled);
+			pass.read(normals, Access::Sampled);
+			pass.write(ao, Access::StorageWrite);
+		}, nullptr);
+		graph.addPass("lighting", [&](VFrameGraph::PassBuilder& pass) {
+			pass.read(shadow, Access::Sampled);
+			pass.read(depth, Access::Sampled);
+			pass.read(albedo, Access::Sampled);
+			pass.read(normals, Access::Sampled);
+			pass.read(ao, Access::Sampled);
+			pass.write(hdr, Access::ColorAttachment);
+		}, nullptr);
+		graph.addPass("debug normals", [&](VFrameGraph::PassBuilder& pass) {
+			pass.read(normals, Access::Sampled);
+			pass.write(debug, Access::ColorAttachment);
+		}, nullptr);
+
+		// downsample chain then back up, each level only lives until the next one has consumed it
+		auto previous = hdr;
+		std::vector<VFrameGraph::ResourceId> bloom;
+		for (uint32_t level = 0; level < BLOOM_LEVELS; level++)
+		{
+			auto target = graph.createTexture("bloom " + std::to_string(level), { WIDTH >> (level + 1), HEIGHT >> (level + 1), VK_FORMAT_R16G16B16A16_SFLOAT });
+			graph.addPass("bloom down " + std::to_string(level), [&](VFrameGraph::PassBuilder& pass) {
+				pass.read(previous, Access::Sampled);
+				pass.write(target, Access::StorageWrite);
+			}, nullptr);
+			bloom.push_back(target);
+			previous = target;
+		}
+		for (uint32_t level = BLOOM_LEVELS - 1; level-- > 0;)
+		{
+			auto target = graph.createTexture("bloom up " + std::to_string(level), graph.getDesc(bloom[level]));
+			graph.addPass("bloom up " + std::to_string(level), [&](VFrameGraph::PassBuilder& pass) {
+				pass.read(previous, Access::Sampled);
+				pass.read(bloom[level], Access::Sampled);
+				pass.write(target, Access::StorageWrite);
+			}, nullptr);
+			previous = target;
+		}
+		graph.addPass("tonemap", [&](VFrameGraph::PassBuilder& pass) {
+			pass.read(hdr, Access::Sampled);
+			pass.read(previous, Access::Sampled);
+			pass.write(backbuffer, Access::ColorAttachment);
+		}, nullptr);
+		graph.compile();
+	};
+
+	build();
+	auto start = BenchClock::now();
+	for (int it = 0; it < ITERATIONS; it++)
+	{
+		build();
+	}
+	double buildMs = elapsedMs(start) / ITERATIONS;
+
+	const VFrameGraph::Stats& stats = graph.getStats();
+	std::cout << "frame graph, " << WIDTH << "x" << HEIGHT << " deferred frame" << std::endl;
+	std::cout << "	order:";
+	for (const std::string& name : graph.getPassOrder())
+	{
+		std::cout << " [" << name << "]";
+	}
+	std::cout << std::endl;
+	std::cout << "	" << stats.passes << " passes, " << stats.culledPasses << " culled, " << stats.transientImages << " transient images" << std::endl;
+	std::cout << "	" << stats.barriers << " image barriers in " << stats.barrierBatches << " vkCmdPipelineBarrier calls" << std::endl;
+	std::cout << "	transient memory: " << stats.transientBytes / (1024.0 * 1024.0) << " MiB without aliasing, "
+		<< stats.aliasedBytes / (1024.0 * 1024.0) << " MiB aliased" << std::endl;
+	std::cout << "	build + compile: " << buildMs * 1000.0 << " us" << std::endl;
+
+	// the debug pass is the only dead one, and aliasing can never need more than separate allocations
+	return stats.culledPasses == 1 && stats.aliasedBytes <= stats.transientBytes ? 0 : 1;
+}
+
+static int benchJobs()
+{
+	constexpr int ITERATIONS = 2000;
+	constexpr uint32_t JOB_COUNT = 100000;
+	constexpr uint32_t CHAIN_LENGTH = 10000;
+
+	VJobSystem jobSystem;
+	uint32_t workers = jobSystem.workerCount();
+	std::cout << "job system, " << workers << " worker(s)" << std::endl;
+	int result = 0;
+
+	// what culling and the texture loader did before: a fresh set of threads per call
+	auto start = BenchClock::now();
+	for (int it = 0; it < ITERATIONS / 10; it++)
+	{
+		std::vector<std::thread> threads;
+		for (uint32_t w = 1; w < workers; w++)
+		{
+			threads.emplace_back([]() {});
+		}
+		for (auto& thread : threads)
+		{
+			thread.join();
+		}
+	}
+	double spawnUs = elapsedMs(start) * 1000.0 / (ITERATIONS / 10);
+	std::cout << "\tspawn + join " << workers - 1 << " threads: " << spawnUs << " us" << std::endl;
+
+	// empty parallel for, pure fork / join overhead
+	std::atomic<uint32_t> covered{ 0 };
+	start = BenchClock::now();
+	for (int it = 0; it < ITERATIONS; it++)
+	{
+		jobSystem.parallelFor(workers * 64, 1, [&covered](uint32_t begin, uint32_t end) {
+			covered.fetch_add(end - begin, std::memory_order_relaxed);
+		});
+	}
+	double forUs = elapsedMs(start) * 1000.0 / ITERATIONS;
+	std::cout << "\tempty parallelFor over " << workers * 4 << " batches: " << forUs << " us";
+	if (workers > 1)
+	{
+		std::cout << ", " << spawnUs / forUs << "x faster than spawning";
+	}
+	std::cout << std::endl;
+	if (covered.load() != workers * 64 * ITERATIONS)
+	{
+		std::cout << "\tparallelFor skipped or repeated indices" << std::endl;
+		result = 1;
+	}
+
+	// many tiny independent jobs queued from the owner thread and stolen by the rest
+	std::atomic<uint32_t> ran{ 0 };
+	VJobSystem::Counter counter;
+	start = BenchClock::now();
+	for (uint32_t i = 0; i < JOB_COUNT; i++)
+	{
+		jobSystem.run([&ran]() { ran.fetch_add(1, std::memory_order_relaxed); }, &counter);
+	}
+	jobSystem.wait(counter);
+	double jobNs = elapsedMs(start) * 1000000.0 / JOB_COUNT;
+	std::cout << "\t" << JOB_COUNT << " empty jobs: " << jobNs << " ns per job" << std::endl;
+	if (ran.load() != JOB_COUNT)
+	{
+		std::cout << "\tonly " << ran.load() << " jobs ran" << std::endl;
+		result = 1;
+	}
+
+	// a chain where every job waits on the one before it, the worst case for runAfter
+	std::vector<std::unique_ptr<VJobSystem::Counter>> chain;
+	chain.reserve(CHAIN_LENGTH);
+	std::vector<uint32_t> order;
+	order.reserve(CHAIN_LENGTH);
+	start = BenchClock::now();
+	chain.push_back(std::make_unique<VJobSystem::Counter>());
+	jobSystem.run([&order]() { order.push_back(0); }, chain.back().get());
+	for (uint32_t i = 1; i < CHAIN_LENGTH; i++)
+	{
+		VJobSystem::Counter& previous = *chain.back();
+		chain.push_back(std::make_unique<VJobSystem::Counter>());
+		jobSystem.runAfter(previous, [&order, i]() { order.push_back(i); }, chain.back().get());
+	}
+	jobSystem.wait(*chain.back());
+	double linkNs = elapsedMs(start) * 1000000.0 / CHAIN_LENGTH;
+	std::cout << "\tdependency chain of " << CHAIN_LENGTH << ": " << linkNs << " ns per link" << std::endl;
+	for (uint32_t i = 0; i < CHAIN_LENGTH && result == 0; i++)
+	{
+		if (i >= order.size() || order[i] != i)
+		{
+			std::cout << "\tdependency chain ran out of order" << std::endl;
+			result = 1;
+		}
+	}
+	// earlier links finished before the last one, but make sure none is still inside finish()
+	for (auto& link : chain)
+	{
+		jobSystem.wait(*link);
+	}
+	return result;
+}
+
+// one soak run, see benchResize
+struct ResizeSoakResult {
+	uint32_t frames = 0;
+	uint32_t rebuilds = 0;
+	uint32_t hitchFrames = 0;
+	uint32_t droppedFrames = 0;
+	uint32_t stretchedFrames = 0;
+	uint32_t depthAllocations = 0;
+	VkExtent2D finalExtent{};
+};
+
+// strict: any size mismatch makes acquire / present return out of date (win32).
+// otherwise a mismatched swapchain is only suboptimal and can keep presenting
+static ResizeSoakResult runResizeSoak(bool coalesced, bool strict)
+{
+	constexpr double DRAG_SECONDS = 3.0;
+	constexpr double SOAK_SECONDS = 4.0;
+	constexpr double EVENT_INTERVAL = 0.002;
+	constexpr double FRAME_INTERVAL = 1.0 / 60.0;
+	constexpr uint32_t MAX_DIMENSION = 16384;
+
+	auto windowAt = [](double t) {
+		// out to 1600x1200 and back, then held still
+		double phase = t < DRAG_SECONDS ? std::sin(t / DRAG_SECONDS * 3.14159265358979) : 0.0;
+		return VkExtent2D{ static_cast<uint32_t>(800 + 800 * phase), static_cast<uint32_t>(600 + 600 * phase) };
+	};
+
+	using Clock = VResizeCoalescer::Clock;
+	Clock::time_point start{};
+	auto at = [start](double t) { return start + std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(t)); };
+
+	ResizeSoakResult result;
+	VResizeCoalescer coalescer;
+	VkExtent2D swapExtent = windowAt(0.0);
+	VkExtent2D depthCapacity = coalesced ? attachmentCapacityFor(swapExtent, MAX_DIMENSION) : swapExtent;
+	result.depthAllocations = 1;
+	bool resized = false;
+	bool outOfDate = false;
+	double nextEvent = EVENT_INTERVAL;
+	VkExtent2D window = swapExtent;
+
+	auto rebuild = [&](bool& rebuiltThisFrame) {
+		swapExtent = window;
+		result.rebuilds++;
+		rebuiltThisFrame = true;
+		if (!coalesced || !attachmentCapacityFits(depthCapacity, swapExtent))
+		{
+			depthCapacity = coalesced ? attachmentCapacityFor(swapExtent, MAX_DIMENSION) : swapExtent;
+			result.depthAllocations++;
+		}
+	};
+	auto mismatched = [&]() { return swapExtent.width != window.width || swapExtent.height != window.height; };
+
+	for (double t = 0.0; t < SOAK_SECONDS; t += FRAME_INTERVAL)
+	{
+		// size events that came in since the last frame
+		for (; nextEvent <= t; nextEvent += EVENT_INTERVAL)
+		{
+			VkExtent2D next = windowAt(nextEvent);
+			if (next.width != window.width || next.height != window.height)
+			{
+				window = next;
+				resized = true;
+			}
+		}
+		result.frames++;
+		bool rebuilt = false;
+
+		if (coalesced)
+		{
+			if (resized)
+			{
+				resized = false;
+				coalescer.request(at(t));
+			}
+			if (coalescer.shouldRecreate(at(t), outOfDate))
+			{
+				rebuild(rebuilt);
+				outOfDate = false;
+				coalescer.recreated();
+			}
+		}
+
+		// acquire. the coalesced engine rebuilds and acquires again, unless it already rebuilt this frame
+		if (strict && mismatched() && coalesced && !rebuilt)
+		{
+			rebuild(rebuilt);
+			coalescer.recreated();
+		}
+		if (strict && mismatched())
+		{
+			if (coalesced)
+			{
+				outOfDate = true;
+			}
+			else
+			{
+				rebuild(rebuilt);
+			}
+			result.droppedFrames++;
+			result.hitchFrames += rebuilt ? 1 : 0;
+			continue;
+		}
+
+		// present
+		bool suboptimal = mismatched();
+		result.stretchedFrames += suboptimal ? 1 : 0;
+		if (coalesced)
+		{
+			if (suboptimal && !coalescer.isPending())
+			{
+				coalescer.request(at(t));
+			}
+		}
+		else if (suboptimal || resized)
+		{
+			resized = false;
+			rebuild(rebuilt);
+		}
+		result.hitchFrames += rebuilt ? 1 : 0;
+	}
+	result.finalExtent = swapExtent;
+	return result;
+}
+
+static int benchResize()
+{
+	std::cout << "resize soak, 3 s edge drag to 1600x1200 and back at 500 size events/s, then 1 s still, 60 fps" << std::endl;
+	int rc = 0;
+	for (bool strict : { true, false })
+	{
+		ResizeSoakResult before = runResizeSoak(false, strict);
+		ResizeSoakResult after = runResizeSoak(true, strict);
+		std::cout << (strict ? "\tout of date on mismatch:" : "\tsuboptimal on mismatch:") << std::endl;
+		for (const ResizeSoakResult* r : { &before, &after })
+		{
+			std::cout << (r == &before ? "\t\trebuild per event: " : "\t\tcoalesced + pooled: ")
+				<< r->rebuilds << " rebuilds, " << r->hitchFrames << " hitch frames of " << r->frames << ", "
+				<< r->droppedFrames << " dropped, " << r->stretchedFrames << " stretched, "
+				<< r->depthAllocations << " depth allocations" << std::endl;
+		}
+		// both have to end up at the final size, with fewer rebuilds and reallocations
+		if (after.finalExtent.width != 800 || after.finalExtent.height != 600 ||
+			after.rebuilds > before.rebuilds || after.depthAllocations >= before.depthAllocations)
+		{
+			std::cout << "\tcoalescing did worse than rebuilding on every event" << std::endl;
+			rc = 1;
+		}
+	}
+	return rc;
+}
+
+// about the size of a VModel: a few vulkan handles, counts and bounds
+struct BenchResource {
+	uint64_t handles[8];
+	uint32_t drawCount;
+	float bounds[7];
+};
+
+static int benchHandles()
+{
+	constexpr uint32_t RESOURCES = 4096;
+	constexpr uint32_t LOOKUPS = 1 << 22;
+	constexpr int ITERATIONS = 10;
+
+	std::mt19937 rng{ 47 };
+	std::uniform_int_distribution<uint32_t> pick{ 0, RESOURCES - 1 };
+
+	// the pointer version the engine used to have, each resource its own allocation between
+	// everything else allocated at load time
+	std::vector<std::unique_ptr<BenchResource>> owned;
+	std::vector<std::unique_ptr<char[]>> interleaved;
+	VHandlePool<BenchResource> pool;
+	std::vector<VHandle<BenchResource>> handles;
+	for (uint32_t i = 0; i < RESOURCES; i++)
+	{
+		owned.push_back(std::make_unique<BenchResource>());
+		owned.back()->drawCount = i;
+		interleaved.push_back(std::make_unique<char[]>(64 + pick(rng) % 512));
+		handles.push_back(pool.emplace());
+		pool[handles.back()].drawCount = i;
+	}
+
+	std::vector<uint32_t> order(LOOKUPS);
+	for (uint32_t& index : order)
+	{
+		index = pick(rng);
+	}
+	std::vector<VHandle<BenchResource>> orderHandles(LOOKUPS);
+	for (uint32_t i = 0; i < LOOKUPS; i++)
+	{
+		orderHandles[i] = handles[order[i]];
+	}
+
+	uint64_t pointerSum = 0;
+	uint64_t handleSum = 0;
+	double pointerMs = 0.0;
+	double handleMs = 0.0;
+	for (int it = 0; it < ITERATIONS; it++)
+	{
+		auto start = BenchClock::now();
+		for (uint32_t index : order)
+		{
+			pointerSum += owned[index]->drawCount;
+		}
+		pointerMs += elapsedMs(start);
+
+		start = BenchClock::now();
+		for (VHandle<BenchResource> handle : orderHandles)
+		{
+			// the checked lookup, what a draw record pays
+			const BenchResource* resource = pool.get(handle);
+			handleSum += resource != nullptr ? resource->drawCount : 0;
+		}
+		handleMs += elapsedMs(start);
+	}
+
+	int result = pointerSum == handleSum ? 0 : 1;
+
+	// a released handle goes stale, and stays stale after its slot is reused
+	VHandle<BenchResource> released = handles[7];
+	pool.release(released);
+	VHandle<BenchResource> reused = pool.emplace();
+	if (pool.contains(released) || pool.get(released) != nullptr || reused.index() != released.index() || !pool.contains(reused))
+	{
+		std::cout << "	stale handle was not detected" << std::endl;
+		result = 1;
+	}
+	// a slot that ran out of generations is retired rather than wrapping back to old handles
+	VHandlePool<BenchResource> small;
+	VHandle<BenchResource> first = small.emplace();
+	VHandle<BenchResource> last = first;
+	for (uint32_t i = 0; i < VHandle<BenchResource>::MAX_GENERATION; i++)
+	{
+		small.release(last);
+		last = small.emplace();
+	}
+	small.release(last);
+	if (small.emplace().index() == first.index() || small.contains(first))
+	{
+		std::cout << "	exhausted slot was reused" << std::endl;
+		result = 1;
+	}
+
+	std::cout << "handles, " << RESOURCES << " resources of " << sizeof(BenchResource) << " bytes, " << LOOKUPS << " random lookups" << std::endl;
+	std::cout << "	unique_ptr: " << pointerMs * 1e6 / (double(ITERATIONS) * LOOKUPS) << " ns per lookup" << std::endl;
+	std::cout << "	handle pool (checked): " << handleMs * 1e6 / (double(ITERATIONS) * LOOKUPS) << " ns per lookup" << std::endl;
+	std::cout << "	" << sizeof(VHandle<BenchResource>) << " byte handles vs " << sizeof(BenchResource*) << " byte pointers, "
+		<< sizeof(VDrawItem) << " byte draw items" << std::endl;
+	if (pointerSum != handleSum)
+	{
+		std::cout << "	lookups disagree" << std::endl;
+	}
+	return result;
+}
+
+static int benchPng()
+{
+	constexpr uint32_t WIDTH = 1920;
+	constexpr uint32_t HEIGHT = 1080;
+	constexpr int ITERATIONS = 20;
+
+	// something like a rendered frame: a vertical gradient, flat shaded boxes, a bit of noise
+	std::mt19937 rng{ 49 };
+	VImageData frame;
+	frame.width = WIDTH;
+	frame.height = HEIGHT;
+	frame.pixels.resize(size_t(WIDTH) * HEIGHT * 4);
+	for (uint32_t y = 0; y < HEIGHT; y++)
+	{
+		for (uint32_t x = 0; x < WIDTH; x++)
+		{
+			uint8_t* p = &frame.pixels[(size_t(y) * WIDTH + x) * 4];
+			bool box = ((x / 160) + (y / 120)) % 3 == 0;
+			p[0] = box ? 180 : static_cast<uint8_t>(y * 255 / HEIGHT);
+			p[1] = box ? 60 : static_cast<uint8_t>(40 + (rng() & 3));
+			p[2] = box ? 40 : static_cast<uint8_t>(255 - y * 255 / HEIGHT);
+			p[3] = 255;
+		}
+	}
+
+	std::vector<uint8_t> file;
+	double ms = 0.0;
+	for (int it = 0; it < ITERATIONS; it++)
+	{
+		auto start = BenchClock::now();
+		encodePng(frame, file);
+		ms += elapsedMs(start);
+	}
+	ms /= ITERATIONS;
+
+	double frameMs = 1000.0 / 60.0;
+	std::cout << "png, " << WIDTH << "x" << HEIGHT << " rgba frame" << std::endl;
+	std::cout << "	" << ms << " ms per frame, " << frame.pixels.size() / (ms * 1000.0) << " MB/s, "
+		<< file.size() << " of " << frame.pixels.size() << " bytes" << std::endl;
+	std::cout << "	capturing at 60 fps needs " << static_cast<int>(std::ceil(ms / frameMs)) << " encoder threads" << std::endl;
+	return file.size() < frame.pixels.size() ? 0 : 1;
+}
+
+static int benchArena()
+{
+	constexpr size_t ARENA_SIZE = 64 * 1024;
+	constexpr int FRAMES = 20000;
+	constexpr int LISTS = 16;
+	constexpr int ITEMS = 200;
+
+	// a frame's worth of short lived lists, the way the render loop builds them
+	auto buildFrame = [](std::pmr::memory_resource* resource)
+	{
+		uint64_t sum = 0;
+		for (int list = 0; list < LISTS; list++)
+		{
+			std::pmr::vector<uint32_t> items{ resource };
+			for (int i = 0; i < ITEMS; i++)
+			{
+				items.push_back(static_cast<uint32_t>(list * i));
+			}
+			sum += items.back();
+		}
+		return sum;
+	};
+
+	uint64_t heapSum = 0;
+	auto start = BenchClock::now();
+	for (int frame = 0; frame < FRAMES; frame++)
+	{
+		heapSum += buildFrame(std::pmr::new_delete_resource());
+	}
+	double heapMs = elapsedMs(start);
+
+	VLinearArena arena{ ARENA_SIZE };
+	uint64_t arenaSum = 0;
+	start = BenchClock::now();
+	for (int frame = 0; frame < FRAMES; frame++)
+	{
+		arena.reset();
+		arenaSum += buildFrame(&arena);
+	}
+	double arenaMs = elapsedMs(start);
+
+	int result = heapSum == arenaSum ? 0 : 1;
+
+	// whatever spills past the arena still has to come back at the alignment asked for
+	for (size_t alignment : { size_t(8), alignof(std::max_align_t), size_t(32), size_t(64), size_t(256) })
+	{
+		VLinearArena small{ 64 };
+		// the first one fits, the rest go upstream
+		for (int i = 0; i < 5; i++)
+		{
+			void* p = small.allocate(i == 0 ? 48 : 64, alignment);
+			if (reinterpret_cast<uintptr_t>(p) % alignment != 0)
+			{
+				std::cout << "	allocation " << i << " misaligned at alignment " << alignment << std::endl;
+				result = 1;
+			}
+		}
+		if (small.overflowCount() == 0)
+		{
+			std::cout << "	nothing overflowed at alignment " << alignment << std::endl;
+			result = 1;
+		}
+	}
+
+	std::cout << "arena, " << FRAMES << " frames of " << LISTS << " lists x " << ITEMS << " items" << std::endl;
+	std::cout << "	new/delete: " << heapMs * 1000.0 / FRAMES << " us per frame" << std::endl;
+	std::cout << "	linear arena: " << arenaMs * 1000.0 / FRAMES << " us per frame, " << arena.highWater() << " bytes at peak, "
+		<< arena.overflowCount() << " overflows" << std::endl;
+	return result;
+}
+
+int runBenchmark(const std::string& name)
+{
+	if (name == "culling")
+	{
+		return benchCulling();
+	}
+	if (name == "scene")
+	{
+		return benchScene();
+	}
+	if (name == "renderqueue")
+	{
+		return benchRenderQueue();
+	}
+	if (name == "framegraph")
+	{
+		return benchFrameGraph();
+	}
+	if (name == "jobs")
+	{
+		return benchJobs();
+	}
+	if (name == "resize")
+	{
+		return benchResize();
+	}
+	if (name == "handles")
+	{
+		return benchHandles();
+	}
+	if (name == "png")
+	{
+		return benchPng();
+	}
+	if (name == "arena")
+	{
+		return benchArena();
+	}
+
+	std::cerr << "unknown benchmark: " << name << '\n';
+	std::cerr << "available: culling, scene, renderqueue, framegraph, jobs, resize, handles, png, arena" << '\n';
+	return 1;
+}
+
+}
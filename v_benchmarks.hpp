@@ -0,0 +1,11 @@
+#pragma once
+
+#include <string>
+
+namespace vwdw {
+
+	// cpu side microbenchmarks, run with: BRRRR --bench <name>
+	// returns the process exit code
+	int runBenchmark(const std::string& name);
+
+}
@@ -0,0 +1,192 @@
+#include "v_bindless.hpp"
+#include "v_swap_chain.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <stdexcept>
+
+namespace vwdw {
+
+VBindlessTable::VBindlessTable(VDevice& device, uint32_t maxSampledImages, uint32_t maxStorageBuffers)
+	: vDevice{ device }
+{
+	if (!vDevice.supportsDescriptorIndexing())
+	{
+		throw std::runtime_error("bindless table needs descriptor indexing");
+	}
+
+	const auto& limits = vDevice.descriptorIndexingProperties;
+	imageSlots.capacity = std::min({ maxSampledImages, limits.maxDescriptorSetUpdateAfterBindSampledImages, limits.maxPerStageDescriptorUpdateAfterBindSampledImages });
+	bufferSlots.capacity = std::min({ maxStorageBuffers, limits.maxDescriptorSetUpdateAfterBindStorageBuffers, limits.maxPerStageDescriptorUpdateAfterBindStorageBuffers });
+
+	createLayout();
+	createSet();
+}
+
+VBindlessTable::~VBindlessTable()
+{
+	vkDestroyDescriptorPool(vDevice.device(), descriptorPool, nullptr);
+	vkDestroyDescriptorSetLayout(vDevice.device(), setLayout, nullptr);
+}
+
+void VBindlessTable::createLayout()
+{
+	std::array<VkDescriptorSetLayoutBinding, 2> bindings{};
+	bindings[0].binding = SAMPLED_IMAGE_BINDING;
+	bindings[0].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+	bindings[0].descriptorCount = imageSlots.capacity;
+	bindings[0].stageFlags = VK_SHADER_STAGE_ALL;
+
+	bindings[1].binding = STORAGE_BUFFER_BINDING;
+	bindings[1].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+	bindings[1].descriptorCount = bufferSlots.capacity;
+	bindings[1].stageFlags = VK_SHADER_STAGE_ALL;
+
+	// slots that were never written are fine as long as no shader reads them
+	std::array<VkDescriptorBindingFlags, 2> bindingFlags{};
+	bindingFlags[0] = VK_DESCRIPTOR_BINDING_UPDATE_AFTER_BIND_BIT | VK_DESCRIPTOR_BINDING_PARTIALLY_BOUND_BIT;
+	bindingFlags[1] = VK_DESCRIPTOR_BINDING_UPDATE_AFTER_BIND_BIT | VK_DESCRIPTOR_BINDING_PARTIALLY_BOUND_BIT;
+
+	VkDescriptorSetLayoutBindingFlagsCreateInfo flagsInfo{};
+	flagsInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_BINDING_FLAGS_CREATE_INFO;
+	flagsInfo.bindingCount = static_cast<uint32_t>(bindingFlags.size());
+	flagsInfo.pBindingFlags = bindingFlags.data();
+
+	VkDescriptorSetLayoutCreateInfo layoutInfo{};
+	layoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+	layoutInfo.pNext = &flagsInfo;
+	layoutInfo.flags = VK_DESCRIPTOR_SET_LAYOUT_CREATE_UPDATE_AFTER_BIND_POOL_BIT;
+	layoutInfo.bindingCount = static_cast<uint32_t>(bindings.size());
+	layoutInfo.pBindings = bindings.data();
+
+	if (vkCreateDescriptorSetLayout(vDevice.device(), &layoutInfo, nullptr, &setLayout) != VK_SUCCESS)
+	{
+		throw std::runtime_error("failed to create bindless descriptor set layout");
+	}
+}
+
+void VBindlessTable::createSet()
+{
+	std::array<VkDescriptorPoolSize, 2> poolSizes{};
+	poolSizes[0].type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+	poolSizes[0].descriptorCount = imageSlots.capacity;
+	poolSizes[1].type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+	poolSizes[1].descriptorCount = bufferSlots.capacity;
+
+	VkDescriptorPoolCreateInfo poolInfo{};
+	poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+	poolInfo.flags = VK_DESCRIPTOR_POOL_CREATE_UPDATE_AFTER_BIND_BIT;
+	poolInfo.maxSets = 1;
+	poolInfo.poolSizeCount = static_cast<uint32_t>(poolSizes.size());
+	poolInfo.pPoolSizes = poolSizes.data();
+
+	if (vkCreateDescriptorPool(vDevice.device(), &poolInfo, nullptr, &descriptorPool) != VK_SUCCESS)
+	{
+		throw std::runtime_error("failed to create bindless descriptor pool");
+	}
+
+	VkDescriptorSetAllocateInfo allocInfo{};
+	allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+	allocInfo.descriptorPool = descriptorPool;
+	allocInfo.descriptorSetCount = 1;
+	allocInfo.pSetLayouts = &setLayout;
+
+	if (vkAllocateDescriptorSets(vDevice.device(), &allocInfo, &descriptorSet) != VK_SUCCESS)
+	{
+		throw std::runtime_error("failed to allocate bindless descriptor set");
+	}
+}
+
+VBindlessTable::Handle VBindlessTable::Slots::acquire()
+{
+	if (!freeList.empty())
+	{
+		Handle handle = freeList.back();
+		freeList.pop_back();
+		return handle;
+	}
+	if (next >= capacity)
+	{
+		throw std::runtime_error("bindless table is full");
+	}
+	return next++;
+}
+
+VBindlessTable::Handle VBindlessTable::addSampledImage(VkImageView view, VkSampler sampler, VkImageLayout layout)
+{
+	Handle handle = imageSlots.acquire();
+
+	VkDescriptorImageInfo imageInfo{};
+	imageInfo.imageView = view;
+	imageInfo.sampler = sampler;
+	imageInfo.imageLayout = layout;
+
+	VkWriteDescriptorSet write{};
+	write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+	write.dstSet = descriptorSet;
+	write.dstBinding = SAMPLED_IMAGE_BINDING;
+	write.dstArrayElement = handle;
+	write.descriptorCount = 1;
+	write.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+	write.pImageInfo = &imageInfo;
+	vkUpdateDescriptorSets(vDevice.device(), 1, &write, 0, nullptr);
+	return handle;
+}
+
+VBindlessTable::Handle VBindlessTable::addStorageBuffer(VkBuffer buffer, VkDeviceSize offset, VkDeviceSize range)
+{
+	Handle handle = bufferSlots.acquire();
+
+	VkDescriptorBufferInfo bufferInfo{};
+	bufferInfo.buffer = buffer;
+	bufferInfo.offset = offset;
+	bufferInfo.range = range;
+
+	VkWriteDescriptorSet write{};
+	write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+	write.dstSet = descriptorSet;
+	write.dstBinding = STORAGE_BUFFER_BINDING;
+	write.dstArrayElement = handle;
+	write.descriptorCount = 1;
+	write.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+	write.pBufferInfo = &bufferInfo;
+	vkUpdateDescriptorSets(vDevice.device(), 1, &write, 0, nullptr);
+	return handle;
+}
+
+void VBindlessTable::releaseSampledImage(Handle handle)
+{
+	assert(handle < imageSlots.next && "sampled image handle was never handed out");
+	imageSlots.pending.push_back({ handle, frame });
+}
+
+void VBindlessTable::releaseStorageBuffer(Handle handle)
+{
+	assert(handle < bufferSlots.next && "storage buffer handle was never handed out");
+	bufferSlots.pending.push_back({ handle, frame });
+}
+
+void VBindlessTable::recycle(Slots& slots)
+{
+	// anything released MAX_FRAMES_IN_FLIGHT frames ago can't be referenced by a pending submit anymore
+	auto it = std::remove_if(slots.pending.begin(), slots.pending.end(), [&](const std::pair<Handle, uint64_t>& p)
+		{
+			if (frame - p.second < VSwapChain::MAX_FRAMES_IN_FLIGHT)
+			{
+				return false;
+			}
+			slots.freeList.push_back(p.first);
+			return true;
+		});
+	slots.pending.erase(it, slots.pending.end());
+}
+
+void VBindlessTable::beginFrame()
+{
+	frame++;
+	recycle(imageSlots);
+	recycle(bufferSlots);
+}
+
+}
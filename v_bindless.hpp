@@ -0,0 +1,68 @@
+#pragma once
+
+#include "VDevice.hpp"
+
+#include <cstdint>
+#include <vector>
+
+namespace vwdw {
+
+	// one device wide update-after-bind descriptor set holding every sampled image and storage buffer.
+	// shaders index it with the integer handles handed out here (passed through push constants), so the
+	// set is bound once per command buffer instead of once per material
+	class VBindlessTable {
+	public:
+		using Handle = uint32_t;
+		static constexpr Handle INVALID_HANDLE = 0xFFFFFFFF;
+
+		// binding numbers inside the set, shaders declare the same
+		static constexpr uint32_t SAMPLED_IMAGE_BINDING = 0;
+		static constexpr uint32_t STORAGE_BUFFER_BINDING = 1;
+
+		// capacities are clamped to the device's update-after-bind limits
+		VBindlessTable(VDevice& device, uint32_t maxSampledImages = 16384, uint32_t maxStorageBuffers = 16384);
+		~VBindlessTable();
+
+		VBindlessTable(const VBindlessTable&) = delete;
+		VBindlessTable& operator=(const VBindlessTable&) = delete;
+
+		Handle addSampledImage(VkImageView view, VkSampler sampler, VkImageLayout layout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+		Handle addStorageBuffer(VkBuffer buffer, VkDeviceSize offset = 0, VkDeviceSize range = VK_WHOLE_SIZE);
+		// handles are only recycled once every frame in flight that could still read them has finished
+		void releaseSampledImage(Handle handle);
+		void releaseStorageBuffer(Handle handle);
+
+		// call once per frame after the frame's fence wait, recycles handles released long enough ago
+		void beginFrame();
+
+		VkDescriptorSetLayout getDescriptorSetLayout() { return setLayout; }
+		VkDescriptorSet getDescriptorSet() { return descriptorSet; }
+		uint32_t sampledImageCapacity() const { return imageSlots.capacity; }
+		uint32_t storageBufferCapacity() const { return bufferSlots.capacity; }
+
+	private:
+		struct Slots {
+			uint32_t capacity = 0;
+			uint32_t next = 0;
+			std::vector<Handle> freeList;
+			// released handles tagged with the frame they were released in
+			std::vector<std::pair<Handle, uint64_t>> pending;
+
+			Handle acquire();
+		};
+
+		void createLayout();
+		void createSet();
+		void recycle(Slots& slots);
+
+		VDevice& vDevice;
+		Slots imageSlots;
+		Slots bufferSlots;
+		uint64_t frame = 0;
+
+		VkDescriptorSetLayout setLayout = VK_NULL_HANDLE;
+		VkDescriptorPool descriptorPool = VK_NULL_HANDLE;
+		VkDescriptorSet descriptorSet = VK_NULL_HANDLE;
+	};
+
+}
@@ -0,0 +1,101 @@
+#include "v_buffer.hpp"
+
+#include <cassert>
+#include <cstring>
+#include <stdexcept>
+
+namespace vwdw {
+
+VBuffer::VBuffer(VDevice& device, VkDeviceSize size, VkBufferUsageFlags usage, VkMemoryPropertyFlags memoryProperties, bool sharedWithCompute)
+	: vDevice{ device }, bufferSize{ size }
+{
+	uint32_t memoryType;
+	vDevice.createBuffer(size, usage, memoryProperties, buffer, memory, &memoryType, sharedWithCompute);
+
+	VkMemoryPropertyFlags flags = vDevice.getMemoryTypeFlags(memoryType);
+	coherent = (flags & VK_MEMORY_PROPERTY_HOST_COHERENT_BIT) != 0;
+
+	if (flags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT)
+	{
+		if (vkMapMemory(vDevice.device(), memory, 0, VK_WHOLE_SIZE, 0, &mapped) != VK_SUCCESS)
+		{
+			throw std::runtime_error("failed to map buffer memory");
+		}
+	}
+}
+
+VBuffer::~VBuffer()
+{
+	if (mapped != nullptr)
+	{
+		vkUnmapMemory(vDevice.device(), memory);
+	}
+	vkDestroyBuffer(vDevice.device(), buffer, nullptr);
+	vDevice.freeMemory(memory);
+}
+
+void VBuffer::write(const void* data, VkDeviceSize size, VkDeviceSize offset)
+{
+	assert(mapped != nullptr && "cannot write to a buffer that isn't host visible");
+	if (size == VK_WHOLE_SIZE)
+	{
+		size = bufferSize - offset;
+	}
+	assert(offset + size <= bufferSize && "write past the end of the buffer");
+
+	std::memcpy(static_cast<char*>(mapped) + offset, data, static_cast<size_t>(size));
+	flush(size, offset);
+}
+
+VkMappedMemoryRange VBuffer::atomRange(VkDeviceSize size, VkDeviceSize offset) const
+{
+	VkDeviceSize atom = vDevice.properties.limits.nonCoherentAtomSize;
+	if (atom == 0)
+	{
+		atom = 1;
+	}
+
+	VkMappedMemoryRange range{};
+	range.sType = VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE;
+	range.memory = memory;
+	range.offset = offset / atom * atom;
+	range.size = VK_WHOLE_SIZE;
+	if (size != VK_WHOLE_SIZE)
+	{
+		// rounding up can run past the allocation, whole size covers the tail legally
+		VkDeviceSize end = (offset + size + atom - 1) / atom * atom;
+		if (end < bufferSize)
+		{
+			range.size = end - range.offset;
+		}
+	}
+	return range;
+}
+
+void VBuffer::flush(VkDeviceSize size, VkDeviceSize offset)
+{
+	if (coherent || mapped == nullptr)
+	{
+		return;
+	}
+	VkMappedMemoryRange range = atomRange(size, offset);
+	if (vkFlushMappedMemoryRanges(vDevice.device(), 1, &range) != VK_SUCCESS)
+	{
+		throw std::runtime_error("failed to flush buffer memory");
+	}
+}
+
+void VBuffer::invalidate(VkDeviceSize size, VkDeviceSize offset)
+{
+	if (coherent || mapped == nullptr)
+	{
+		return;
+	}
+	VkMappedMemoryRange range = atomRange(size, offset);
+	if (vkInvalidateMappedMemoryRanges(vDevice.device(), 1, &range) != VK_SUCCESS)
+	{
+		throw std::runtime_error("failed to invalidate buffer memory");
+	}
+}
+
+}
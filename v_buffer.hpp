@@ -0,0 +1,43 @@
+#pragma once
+
+#include "VDevice.hpp"
+
+namespace vwdw {
+
+	// a VkBuffer and its memory. host visible buffers are mapped once at creation and stay mapped
+	// until destruction, writes only need a flush when the memory type picked isn't coherent
+	class VBuffer {
+	public:
+		// sharedWithCompute makes it usable from the graphics and async compute queues at once
+		VBuffer(VDevice& device, VkDeviceSize size, VkBufferUsageFlags usage, VkMemoryPropertyFlags memoryProperties, bool sharedWithCompute = false);
+		~VBuffer();
+
+		VBuffer(const VBuffer&) = delete;
+		VBuffer& operator=(const VBuffer&) = delete;
+
+		// copies into the mapping and flushes the written range
+		void write(const void* data, VkDeviceSize size = VK_WHOLE_SIZE, VkDeviceSize offset = 0);
+		// no-ops on coherent memory, ranges are widened to nonCoherentAtomSize
+		void flush(VkDeviceSize size = VK_WHOLE_SIZE, VkDeviceSize offset = 0);
+		void invalidate(VkDeviceSize size = VK_WHOLE_SIZE, VkDeviceSize offset = 0);
+
+		VkBuffer getBuffer() const { return buffer; }
+		VkDeviceMemory getMemory() const { return memory; }
+		VkDeviceSize getSize() const { return bufferSize; }
+		// null unless the buffer is host visible
+		void* getMappedMemory() const { return mapped; }
+		bool isHostVisible() const { return mapped != nullptr; }
+		bool isCoherent() const { return coherent; }
+
+	private:
+		VkMappedMemoryRange atomRange(VkDeviceSize size, VkDeviceSize offset) const;
+
+		VDevice& vDevice;
+		VkBuffer buffer = VK_NULL_HANDLE;
+		VkDeviceMemory memory = VK_NULL_HANDLE;
+		VkDeviceSize bufferSize;
+		void* mapped = nullptr;
+		bool coherent = false;
+	};
+
+}
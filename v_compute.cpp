@@ -0,0 +1,131 @@
+#include "v_compute.hpp"
+
+#include <stdexcept>
+
+namespace vwdw {
+
+VComputePipeline::VComputePipeline(VDevice& device, const std::string& compPath, VkPipelineLayout layout, const VSpecializationConstants& constants)
+	: vDevice{ device }
+{
+	VwdwPipeline::createShaderMod(vDevice, VwdwPipeline::loadShader(vDevice, compPath), &compShaderMod);
+
+	VkSpecializationInfo specializationInfo = constants.getInfo();
+
+	VkComputePipelineCreateInfo pipelineInfo{};
+	pipelineInfo.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+	pipelineInfo.stage.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+	pipelineInfo.stage.stage = VK_SHADER_STAGE_COMPUTE_BIT;
+	pipelineInfo.stage.module = compShaderMod;
+	pipelineInfo.stage.pName = "main";
+	pipelineInfo.stage.pSpecializationInfo = constants.empty() ? nullptr : &specializationInfo;
+	pipelineInfo.layout = layout;
+	pipelineInfo.basePipelineIndex = -1;
+	pipelineInfo.basePipelineHandle = VK_NULL_HANDLE;
+
+	if (vkCreateComputePipelines(vDevice.device(), vDevice.getPipelineCache(), 1, &pipelineInfo, nullptr, &computePipeline) != VK_SUCCESS)
+	{
+		vkDestroyShaderModule(vDevice.device(), compShaderMod, nullptr);
+		throw std::runtime_error("failed to create compute pipeline");
+	}
+}
+
+VComputePipeline::~VComputePipeline()
+{
+	vkDestroyShaderModule(vDevice.device(), compShaderMod, nullptr);
+	vkDestroyPipeline(vDevice.device(), computePipeline, nullptr);
+}
+
+void VComputePipeline::bind(VkCommandBuffer commandBuffer)
+{
+	vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, computePipeline);
+}
+
+VAsyncCompute::VAsyncCompute(VDevice& device, uint32_t framesInFlight) : vDevice{ device }
+{
+	commandBuffers.resize(framesInFlight);
+	fences.resize(framesInFlight, VK_NULL_HANDLE);
+	finishedSemaphores.resize(framesInFlight, VK_NULL_HANDLE);
+
+	VkCommandBufferAllocateInfo allocInfo{};
+	allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+	allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+	allocInfo.commandPool = vDevice.getComputeCommandPool();
+	allocInfo.commandBufferCount = framesInFlight;
+	if (vkAllocateCommandBuffers(vDevice.device(), &allocInfo, commandBuffers.data()) != VK_SUCCESS)
+	{
+		throw std::runtime_error("failed to allocate compute command buffers");
+	}
+
+	VkSemaphoreCreateInfo semaphoreInfo{};
+	semaphoreInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+	// created signalled so the first begin() on each slot doesn't wait forever
+	VkFenceCreateInfo fenceInfo{};
+	fenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+	fenceInfo.flags = VK_FENCE_CREATE_SIGNALED_BIT;
+	for (uint32_t i = 0; i < framesInFlight; i++)
+	{
+		if (vkCreateSemaphore(vDevice.device(), &semaphoreInfo, nullptr, &finishedSemaphores[i]) != VK_SUCCESS ||
+			vkCreateFence(vDevice.device(), &fenceInfo, nullptr, &fences[i]) != VK_SUCCESS)
+		{
+			throw std::runtime_error("failed to create compute synchronization objects");
+		}
+	}
+}
+
+VAsyncCompute::~VAsyncCompute()
+{
+	waitIdle();
+	for (size_t i = 0; i < fences.size(); i++)
+	{
+		vkDestroySemaphore(vDevice.device(), finishedSemaphores[i], nullptr);
+		vkDestroyFence(vDevice.device(), fences[i], nullptr);
+	}
+	vkFreeCommandBuffers(vDevice.device(), vDevice.getComputeCommandPool(), static_cast<uint32_t>(commandBuffers.size()), commandBuffers.data());
+}
+
+VkCommandBuffer VAsyncCompute::begin(uint32_t frameIndex)
+{
+	vkWaitForFences(vDevice.device(), 1, &fences[frameIndex], VK_TRUE, UINT64_MAX);
+
+	VkCommandBuffer commandBuffer = commandBuffers[frameIndex];
+	vkResetCommandBuffer(commandBuffer, 0);
+
+	VkCommandBufferBeginInfo beginInfo{};
+	beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+	beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+	if (vkBeginCommandBuffer(commandBuffer, &beginInfo) != VK_SUCCESS)
+	{
+		throw std::runtime_error("failed to begin compute command buffer");
+	}
+	return commandBuffer;
+}
+
+VkSemaphore VAsyncCompute::submit(uint32_t frameIndex)
+{
+	VkCommandBuffer commandBuffer = commandBuffers[frameIndex];
+	if (vkEndCommandBuffer(commandBuffer) != VK_SUCCESS)
+	{
+		throw std::runtime_error("failed to record compute command buffer");
+	}
+
+	VkSubmitInfo submitInfo{};
+	submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+	submitInfo.commandBufferCount = 1;
+	submitInfo.pCommandBuffers = &commandBuffer;
+	submitInfo.signalSemaphoreCount = 1;
+	submitInfo.pSignalSemaphores = &finishedSemaphores[frameIndex];
+
+	vkResetFences(vDevice.device(), 1, &fences[frameIndex]);
+	if (vkQueueSubmit(vDevice.computeQueue(), 1, &submitInfo, fences[frameIndex]) != VK_SUCCESS)
+	{
+		throw std::runtime_error("failed to submit compute command buffer");
+	}
+	return finishedSemaphores[frameIndex];
+}
+
+void VAsyncCompute::waitIdle()
+{
+	vkWaitForFences(vDevice.device(), static_cast<uint32_t>(fences.size()), fences.data(), VK_TRUE, UINT64_MAX);
+}
+
+}
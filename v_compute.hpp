@@ -0,0 +1,60 @@
+#pragma once
+
+#include "v_specialization.hpp"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace vwdw {
+
+	// a compute shader built the same way as VwdwPipeline: spir-v from disk (or glsl through the shader
+	// compiler), the device's pipeline cache, a layout owned by the caller and optional specialization constants
+	class VComputePipeline {
+	public:
+		VComputePipeline(VDevice& device, const std::string& compPath, VkPipelineLayout layout, const VSpecializationConstants& constants = {});
+		~VComputePipeline();
+
+		VComputePipeline(const VComputePipeline&) = delete;
+		VComputePipeline& operator=(const VComputePipeline&) = delete;
+
+		void bind(VkCommandBuffer commandBuffer);
+		// workgroups needed to cover count items, groupSize has to match the shader's local_size_x
+		static uint32_t groupCount(uint32_t count, uint32_t groupSize) { return (count + groupSize - 1) / groupSize; }
+
+	private:
+		VDevice& vDevice;
+		VkShaderModule compShaderMod = VK_NULL_HANDLE;
+		VkPipeline computePipeline = VK_NULL_HANDLE;
+	};
+
+	// records and submits compute work on the device's compute queue, one command buffer per frame in
+	// flight. submit() hands back a semaphore for the graphics submission to wait on, so the compute work
+	// overlaps whatever graphics is still running and only the stage that consumes its results waits.
+	// with a dedicated compute family, buffers written here and read by graphics need
+	// VK_SHARING_MODE_CONCURRENT over both families (or an ownership transfer)
+	class VAsyncCompute {
+	public:
+		VAsyncCompute(VDevice& device, uint32_t framesInFlight);
+		~VAsyncCompute();
+
+		VAsyncCompute(const VAsyncCompute&) = delete;
+		VAsyncCompute& operator=(const VAsyncCompute&) = delete;
+
+		// waits for the slot's previous submission, then starts recording into its command buffer
+		VkCommandBuffer begin(uint32_t frameIndex);
+		// the returned semaphore is signalled once and has to be waited on exactly once before the slot is used again
+		VkSemaphore submit(uint32_t frameIndex);
+		// blocks until every slot is idle, for teardown / resource recreation
+		void waitIdle();
+
+		bool isAsync() const { return vDevice.hasDedicatedComputeQueue(); }
+
+	private:
+		VDevice& vDevice;
+		std::vector<VkCommandBuffer> commandBuffers;
+		std::vector<VkFence> fences;
+		std::vector<VkSemaphore> finishedSemaphores;
+	};
+
+}
@@ -0,0 +1,701 @@
+#include "v_cooker.hpp"
+#include "v_asset_formats.hpp"
+#include "v_image.hpp"
+#include "v_shader_compiler.hpp"
+#include "model.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <memory>
+#include <sstream>
+#include <unordered_map>
+
+namespace fs = std::filesystem;
+
+namespace vwdw {
+
+uint64_t hashBytes(const void* data, size_t size, uint64_t seed)
+{
+	const uint8_t* bytes = static_cast<const uint8_t*>(data);
+	uint64_t hash = seed;
+	for (size_t i = 0; i < size; i++)
+	{
+		hash ^= bytes[i];
+		hash *= 0x100000001b3ull;
+	}
+	return hash;
+}
+
+template <typename T>
+static void appendBytes(std::vector<uint8_t>& out, const T* data, size_t count)
+{
+	const uint8_t* bytes = reinterpret_cast<const uint8_t*>(data);
+	out.insert(out.end(), bytes, bytes + sizeof(T) * count);
+}
+
+// ---- meshes ----
+
+struct VertexKey {
+	float values[6];
+	bool operator==(const VertexKey& other) const { return std::memcmp(values, other.values, sizeof(values)) == 0; }
+};
+
+struct VertexKeyHash {
+	size_t operator()(const VertexKey& key) const { return static_cast<size_t>(hashBytes(key.values, sizeof(key.values))); }
+};
+
+static bool parseObjIndex(const std::string& token, size_t count, uint32_t& index)
+{
+	// only the position index matters, texcoord / normal indices after the first '/' are ignored
+	long value = std::strtol(token.c_str(), nullptr, 10);
+	if (value < 0)
+	{
+		value += static_cast<long>(count) + 1;
+	}
+	if (value < 1 || static_cast<size_t>(value) > count)
+	{
+		return false;
+	}
+	index = static_cast<uint32_t>(value - 1);
+	return true;
+}
+
+bool cookMesh(const std::vector<uint8_t>& source, std::vector<uint8_t>& cooked, std::string& error)
+{
+	// obj with optional vertex colours (v x y z r g b), polygons are fanned into triangles
+	std::vector<glm::vec3> positions;
+	std::vector<glm::vec3> colors;
+	std::vector<uint32_t> corners;
+
+	std::istringstream stream{ std::string(source.begin(), source.end()) };
+	std::string line;
+	uint32_t lineNumber = 0;
+	while (std::getline(stream, line))
+	{
+		lineNumber++;
+		std::istringstream tokens{ line };
+		std::string type;
+		tokens >> type;
+		if (type == "v")
+		{
+			glm::vec3 p{ 0.0f };
+			glm::vec3 c{ 1.0f };
+			tokens >> p.x >> p.y >> p.z;
+			if (tokens.fail())
+			{
+				error = "bad vertex on line " + std::to_string(lineNumber);
+				return false;
+			}
+			float r, g, b;
+			if (tokens >> r >> g >> b)
+			{
+				c = glm::vec3{ r, g, b };
+			}
+			positions.push_back(p);
+			colors.push_back(c);
+		}
+		else if (type == "f")
+		{
+			std::vector<uint32_t> face;
+			std::string token;
+			while (tokens >> token)
+			{
+				uint32_t index;
+				if (!parseObjIndex(token, positions.size(), index))
+				{
+					error = "bad face index on line " + std::to_string(lineNumber);
+					return false;
+				}
+				face.push_back(index);
+			}
+			for (size_t i = 2; i < face.size(); i++)
+			{
+				corners.push_back(face[0]);
+				corners.push_back(face[i - 1]);
+				corners.push_back(face[i]);
+			}
+		}
+	}
+	if (corners.empty())
+	{
+		error = "mesh has no faces";
+		return false;
+	}
+
+	// identical corners collapse into one vertex
+	std::vector<VModel::Vertex> vertices;
+	std::vector<uint32_t> indices;
+	indices.reserve(corners.size());
+	std::unordered_map<VertexKey, uint32_t, VertexKeyHash> unique;
+	for (uint32_t corner : corners)
+	{
+		VModel::Vertex v{};
+		v.pos = positions[corner];
+		v.color = colors[corner];
+		VertexKey key{ { v.pos.x, v.pos.y, v.pos.z, v.color.x, v.color.y, v.color.z } };
+		auto inserted = unique.emplace(key, static_cast<uint32_t>(vertices.size()));
+		if (inserted.second)
+		{
+			vertices.push_back(v);
+		}
+		indices.push_back(inserted.first->second);
+	}
+
+	std::vector<uint32_t> remap;
+	optimizeMesh(indices, static_cast<uint32_t>(vertices.size()), remap);
+	std::vector<VModel::Vertex> ordered(vertices.size());
+	uint32_t used = 0;
+	for (size_t v = 0; v < vertices.size(); v++)
+	{
+		if (remap[v] != UINT32_MAX)
+		{
+			ordered[remap[v]] = vertices[v];
+			used++;
+		}
+	}
+	ordered.resize(used);
+
+	CookedMeshHeader header{};
+	header.magic = COOKED_MESH_MAGIC;
+	header.version = COOKED_MESH_VERSION;
+	header.vertexCount = static_cast<uint32_t>(ordered.size());
+	header.indexCount = static_cast<uint32_t>(indices.size());
+
+	cooked.clear();
+	appendBytes(cooked, &header, 1);
+	appendBytes(cooked, ordered.data(), ordered.size());
+	appendBytes(cooked, indices.data(), indices.size());
+	return true;
+}
+
+void optimizeMesh(std::vector<uint32_t>& indices, uint32_t vertexCount, std::vector<uint32_t>& vertexRemap)
+{
+	const uint32_t CACHE_SIZE = 32;
+	uint32_t triangleCount = static_cast<uint32_t>(indices.size() / 3);
+
+	// triangles using each vertex, the live ones are kept at the front of each vertex's range
+	std::vector<uint32_t> remaining(vertexCount, 0);
+	for (uint32_t index : indices)
+	{
+		remaining[index]++;
+	}
+	std::vector<uint32_t> adjacencyStart(vertexCount + 1, 0);
+	for (uint32_t v = 0; v < vertexCount; v++)
+	{
+		adjacencyStart[v + 1] = adjacencyStart[v] + remaining[v];
+	}
+	std::vector<uint32_t> adjacency(indices.size());
+	std::vector<uint32_t> fill(adjacencyStart.begin(), adjacencyStart.end() - 1);
+	for (uint32_t t = 0; t < triangleCount; t++)
+	{
+		for (int c = 0; c < 3; c++)
+		{
+			adjacency[fill[indices[t * 3 + c]]++] = t;
+		}
+	}
+
+	std::vector<int32_t> cachePosition(vertexCount, -1);
+	auto vertexScore = [&](uint32_t v)
+		{
+			if (remaining[v] == 0)
+			{
+				return -1.0f;
+			}
+			float score = 0.0f;
+			int32_t position = cachePosition[v];
+			if (position >= 0)
+			{
+				// the last triangle's vertices score flat so the next one doesn't just reuse an edge
+				score = position < 3 ? 0.75f : std::pow(1.0f - static_cast<float>(position - 3) / static_cast<float>(CACHE_SIZE - 3), 1.5f);
+			}
+			// vertices with few triangles left get finished off first
+			return score + 2.0f / std::sqrt(static_cast<float>(remaining[v]));
+		};
+
+	std::vector<float> vertexScores(vertexCount);
+	for (uint32_t v = 0; v < vertexCount; v++)
+	{
+		vertexScores[v] = vertexScore(v);
+	}
+	std::vector<float> triangleScores(triangleCount);
+	std::vector<uint8_t> emitted(triangleCount, 0);
+	int64_t best = -1;
+	float bestScore = -1.0f;
+	for (uint32_t t = 0; t < triangleCount; t++)
+	{
+		triangleScores[t] = vertexScores[indices[t * 3]] + vertexScores[indices[t * 3 + 1]] + vertexScores[indices[t * 3 + 2]];
+		if (triangleScores[t] > bestScore)
+		{
+			bestScore = triangleScores[t];
+			best = t;
+		}
+	}
+
+	std::vector<uint32_t> output;
+	output.reserve(indices.size());
+	std::vector<uint32_t> cache;
+	std::vector<uint32_t> nextCache;
+	std::vector<uint32_t> touched;
+	uint32_t scanCursor = 0;
+	while (output.size() < indices.size())
+	{
+		if (best < 0)
+		{
+			// nothing in the cache has work left, restart from the next unemitted triangle
+			while (emitted[scanCursor])
+			{
+				scanCursor++;
+			}
+			best = scanCursor;
+		}
+
+		uint32_t t = static_cast<uint32_t>(best);
+		emitted[t] = 1;
+		const uint32_t* tri = &indices[t * 3];
+		nextCache.clear();
+		for (int c = 0; c < 3; c++)
+		{
+			uint32_t v = tri[c];
+			output.push_back(v);
+
+			uint32_t* begin = &adjacency[adjacencyStart[v]];
+			uint32_t* end = begin + remaining[v];
+			uint32_t* found = std::find(begin, end, t);
+			if (found != end)
+			{
+				*found = *(end - 1);
+				remaining[v]--;
+			}
+			if (std::find(nextCache.begin(), nextCache.end(), v) == nextCache.end())
+			{
+				nextCache.push_back(v);
+			}
+		}
+		for (uint32_t v : cache)
+		{
+			if (std::find(nextCache.begin(), nextCache.end(), v) == nextCache.end())
+			{
+				nextCache.push_back(v);
+			}
+		}
+
+		touched.assign(nextCache.begin(), nextCache.end());
+		for (size_t i = CACHE_SIZE; i < nextCache.size(); i++)
+		{
+			cachePosition[nextCache[i]] = -1;
+		}
+		if (nextCache.size() > CACHE_SIZE)
+		{
+			nextCache.resize(CACHE_SIZE);
+		}
+		for (size_t i = 0; i < nextCache.size(); i++)
+		{
+			cachePosition[nextCache[i]] = static_cast<int32_t>(i);
+		}
+		cache.swap(nextCache);
+
+		for (uint32_t v : touched)
+		{
+			vertexScores[v] = vertexScore(v);
+		}
+		best = -1;
+		bestScore = -1.0f;
+		for (uint32_t v : touched)
+		{
+			for (uint32_t i = 0; i < remaining[v]; i++)
+			{
+				uint32_t other = adjacency[adjacencyStart[v] + i];
+				const uint32_t* o = &indices[other * 3];
+				triangleScores[other] = vertexScores[o[0]] + vertexScores[o[1]] + vertexScores[o[2]];
+				if (triangleScores[other] > bestScore)
+				{
+					bestScore = triangleScores[other];
+					best = other;
+				}
+			}
+		}
+	}
+
+	// vertices are renumbered in the order the new index stream first touches them
+	vertexRemap.assign(vertexCount, UINT32_MAX);
+	uint32_t next = 0;
+	for (uint32_t& index : output)
+	{
+		if (vertexRemap[index] == UINT32_MAX)
+		{
+			vertexRemap[index] = next++;
+		}
+		index = vertexRemap[index];
+	}
+	indices.swap(output);
+}
+
+// ---- textures ----
+
+bool cookTexture(const std::vector<uint8_t>& source, std::vector<uint8_t>& cooked, std::string& error)
+{
+	VImageData level;
+	if (!decodeImage(source, level, error))
+	{
+		return false;
+	}
+
+	CookedTextureHeader header{};
+	header.magic = COOKED_TEXTURE_MAGIC;
+	header.version = COOKED_TEXTURE_VERSION;
+	header.format = VK_FORMAT_BC1_RGB_SRGB_BLOCK;
+	header.width = level.width;
+	header.height = level.height;
+	header.mipLevels = 1;
+	for (uint32_t size = level.width > level.height ? level.width : level.height; size > 1; size >>= 1)
+	{
+		header.mipLevels++;
+	}
+
+	cooked.clear();
+	appendBytes(cooked, &header, 1);
+
+	std::vector<uint8_t> blocks;
+	VImageData next;
+	for (uint32_t i = 0; i < header.mipLevels; i++)
+	{
+		compressBC1(level, blocks);
+		uint32_t size = static_cast<uint32_t>(blocks.size());
+		appendBytes(cooked, &size, 1);
+		appendBytes(cooked, blocks.data(), blocks.size());
+
+		if (i + 1 < header.mipLevels)
+		{
+			downsampleImage(level, next);
+			std::swap(level, next);
+		}
+	}
+	return true;
+}
+
+// ---- shaders ----
+
+bool cookShader(const std::vector<uint8_t>& source, std::vector<uint8_t>& cooked, std::string& error)
+{
+	if (source.size() < 20 || source.size() % 4 != 0)
+	{
+		error = "spir-v size isn't a whole number of words";
+		return false;
+	}
+
+	size_t wordCount = source.size() / 4;
+	std::vector<uint32_t> words(wordCount);
+	std::memcpy(words.data(), source.data(), source.size());
+	if (words[0] != 0x07230203)
+	{
+		error = "bad spir-v magic number";
+		return false;
+	}
+	if (words[1] < 0x00010000 || words[1] > 0x00010600)
+	{
+		error = "unsupported spir-v version";
+		return false;
+	}
+	if (words[3] == 0)
+	{
+		error = "spir-v id bound is zero";
+		return false;
+	}
+
+	// every instruction's word count has to land exactly on the end of the module
+	bool hasEntryPoint = false;
+	bool hasMemoryModel = false;
+	size_t pos = 5;
+	while (pos < wordCount)
+	{
+		uint32_t instructionWords = words[pos] >> 16;
+		uint32_t opcode = words[pos] & 0xFFFF;
+		if (instructionWords == 0 || pos + instructionWords > wordCount)
+		{
+			error = "malformed spir-v instruction at word " + std::to_string(pos);
+			return false;
+		}
+		hasMemoryModel |= opcode == 14;
+		hasEntryPoint |= opcode == 15;
+		pos += instructionWords;
+	}
+	if (!hasEntryPoint || !hasMemoryModel)
+	{
+		error = "spir-v module has no entry point";
+		return false;
+	}
+
+	cooked = source;
+	return true;
+}
+
+bool cookShaderSource(const std::string& path, const std::vector<uint8_t>& source, VShaderCompiler& compiler, std::vector<uint8_t>& cooked, std::string& error)
+{
+	std::vector<uint32_t> spirv;
+	if (!compiler.compileSource(std::string(source.begin(), source.end()), path, {}, spirv, error))
+	{
+		return false;
+	}
+	std::vector<uint8_t> bytes(spirv.size() * sizeof(uint32_t));
+	std::memcpy(bytes.data(), spirv.data(), bytes.size());
+	return cookShader(bytes, cooked, error);
+}
+
+// ---- driver ----
+
+enum class AssetKind { Mesh, Texture, Shader, ShaderSource };
+
+struct CookJob {
+	fs::path source;
+	fs::path output;
+	std::string key;
+	AssetKind kind;
+
+	enum class Result { Cooked, UpToDate, Failed };
+	Result result = Result::Failed;
+	uint64_t hash = 0;
+	std::string error;
+};
+
+static bool assetKindFor(const fs::path& path, AssetKind& kind, fs::path& cookedName)
+{
+	std::string extension = path.extension().string();
+	std::transform(extension.begin(), extension.end(), extension.begin(), [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+	cookedName = path;
+	if (extension == ".obj")
+	{
+		kind = AssetKind::Mesh;
+		cookedName.replace_extension(".vmesh");
+		return true;
+	}
+	if (extension == ".tga" || extension == ".ppm")
+	{
+		kind = AssetKind::Texture;
+		cookedName.replace_extension(".vtex");
+		return true;
+	}
+	if (extension == ".spv")
+	{
+		kind = AssetKind::Shader;
+		return true;
+	}
+	if (VShaderCompiler::isShaderSource(path.string()))
+	{
+		kind = AssetKind::ShaderSource;
+		cookedName += ".spv";
+		return true;
+	}
+	return false;
+}
+
+static std::unordered_map<std::string, uint64_t> readManifest(const fs::path& path)
+{
+	std::unordered_map<std::string, uint64_t> entries;
+	std::ifstream file{ path };
+	std::string line;
+	while (std::getline(file, line))
+	{
+		size_t space = line.find(' ');
+		if (space == std::string::npos)
+		{
+			continue;
+		}
+		entries[line.substr(space + 1)] = std::strtoull(line.substr(0, space).c_str(), nullptr, 16);
+	}
+	return entries;
+}
+
+static bool readBytes(const fs::path& path, std::vector<uint8_t>& bytes)
+{
+	std::ifstream file{ path, std::ios::binary };
+	if (!file.is_open())
+	{
+		return false;
+	}
+	bytes.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+	return true;
+}
+
+// written next to the target then renamed over it, so a crash never leaves a half written output
+static bool writeBytes(const fs::path& path, const std::vector<uint8_t>& bytes)
+{
+	std::error_code ec;
+	fs::create_directories(path.parent_path(), ec);
+	fs::path temp = path;
+	temp += ".tmp";
+	{
+		std::ofstream file{ temp, std::ios::binary | std::ios::trunc };
+		if (!file.is_open())
+		{
+			return false;
+		}
+		file.write(reinterpret_cast<const char*>(bytes.data()), static_cast<std::streamsize>(bytes.size()));
+		if (!file)
+		{
+			return false;
+		}
+	}
+	fs::rename(temp, path, ec);
+	return !ec;
+}
+
+static void runJob(CookJob& job, const std::unordered_map<std::string, uint64_t>& manifest, VShaderCompiler* compiler)
+{
+	std::vector<uint8_t> source;
+	if (!readBytes(job.source, source))
+	{
+		job.error = "failed to read " + job.source.string();
+		return;
+	}
+
+	uint32_t version = COOKER_VERSION;
+	job.hash = hashBytes(source.data(), source.size(), hashBytes(&version, sizeof(version)));
+
+	auto entry = manifest.find(job.key);
+	std::error_code ec;
+	if (entry != manifest.end() && entry->second == job.hash && fs::exists(job.output, ec))
+	{
+		job.result = CookJob::Result::UpToDate;
+		return;
+	}
+
+	std::vector<uint8_t> cooked;
+	std::string error;
+	bool ok = false;
+	switch (job.kind)
+	{
+	case AssetKind::Mesh: ok = cookMesh(source, cooked, error); break;
+	case AssetKind::Texture: ok = cookTexture(source, cooked, error); break;
+	case AssetKind::Shader: ok = cookShader(source, cooked, error); break;
+	case AssetKind::ShaderSource: ok = cookShaderSource(job.source.string(), source, *compiler, cooked, error); break;
+	}
+	if (!ok)
+	{
+		job.error = job.key + ": " + error;
+		return;
+	}
+	if (!writeBytes(job.output, cooked))
+	{
+		job.error = "failed to write " + job.output.string();
+		return;
+	}
+	job.result = CookJob::Result::Cooked;
+}
+
+CookStats cookAssets(const std::string& sourceDir, const std::string& outputDir, VJobSystem* jobSystem)
+{
+	CookStats stats;
+	std::error_code ec;
+	if (!fs::is_directory(sourceDir, ec))
+	{
+		stats.failed++;
+		stats.errors.push_back("source directory not found: " + sourceDir);
+		return stats;
+	}
+
+	std::vector<CookJob> jobs;
+	for (const auto& entry : fs::recursive_directory_iterator(sourceDir, ec))
+	{
+		AssetKind kind;
+		fs::path relative = entry.path().lexically_relative(sourceDir);
+		fs::path cookedName;
+		if (!entry.is_regular_file() || !assetKindFor(relative, kind, cookedName))
+		{
+			continue;
+		}
+		CookJob job;
+		job.source = entry.path();
+		job.key = relative.generic_string();
+		job.output = fs::path(outputDir) / cookedName;
+		job.kind = kind;
+		jobs.push_back(std::move(job));
+	}
+
+	// glsl and an already compiled .spv of it would both cook to the same output, the source wins so
+	// a stale binary can't shadow it
+	std::vector<fs::path> sourceOutputs;
+	for (const CookJob& job : jobs)
+	{
+		if (job.kind == AssetKind::ShaderSource)
+		{
+			sourceOutputs.push_back(job.output);
+		}
+	}
+	jobs.erase(std::remove_if(jobs.begin(), jobs.end(), [&sourceOutputs](const CookJob& job)
+		{
+			return job.kind == AssetKind::Shader && std::find(sourceOutputs.begin(), sourceOutputs.end(), job.output) != sourceOutputs.end();
+		}), jobs.end());
+	// no disk cache, the manifest already skips sources that haven't changed
+	std::unique_ptr<VShaderCompiler> compiler;
+	if (!sourceOutputs.empty())
+	{
+		compiler = std::make_unique<VShaderCompiler>("");
+	}
+
+	fs::path manifestPath = fs::path(outputDir) / "manifest.txt";
+	auto manifest = readManifest(manifestPath);
+
+	// one job per file, idle workers steal so big textures and tiny shaders balance out
+	if (jobSystem != nullptr)
+	{
+		VJobSystem::Counter counter;
+		for (auto& job : jobs)
+		{
+			jobSystem->run([&job, &manifest, &compiler]() { runJob(job, manifest, compiler.get()); }, &counter);
+		}
+		jobSystem->wait(counter);
+	}
+	else
+	{
+		for (auto& job : jobs)
+		{
+			runJob(job, manifest, compiler.get());
+		}
+	}
+
+	// failed inputs are left out of the manifest so they're retried next time
+	std::sort(jobs.begin(), jobs.end(), [](const CookJob& a, const CookJob& b) { return a.key < b.key; });
+	std::string manifestText;
+	for (const auto& job : jobs)
+	{
+		switch (job.result)
+		{
+		case CookJob::Result::Cooked: stats.cooked++; break;
+		case CookJob::Result::UpToDate: stats.upToDate++; break;
+		case CookJob::Result::Failed:
+			stats.failed++;
+			stats.errors.push_back(job.error);
+			continue;
+		}
+		char hash[17];
+		std::snprintf(hash, sizeof(hash), "%016llx", static_cast<unsigned long long>(job.hash));
+		manifestText += std::string(hash) + " " + job.key + "\n";
+	}
+	if (!writeBytes(manifestPath, std::vector<uint8_t>(manifestText.begin(), manifestText.end())))
+	{
+		stats.errors.push_back("failed to write " + manifestPath.string());
+	}
+	return stats;
+}
+
+int runCooker(const std::string& sourceDir, const std::string& outputDir)
+{
+	VJobSystem jobSystem;
+	CookStats stats = cookAssets(sourceDir, outputDir, &jobSystem);
+	for (const auto& error : stats.errors)
+	{
+		std::cerr << error << std::endl;
+	}
+	std::cout << "cooked " << stats.cooked << ", up to date " << stats.upToDate << ", failed " << stats.failed << std::endl;
+	return stats.failed == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+}
@@ -0,0 +1,50 @@
+#pragma once
+
+#include "v_jobs.hpp"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace vwdw {
+
+	class VShaderCompiler;
+
+	// bumping this invalidates every manifest entry, do it whenever a cooked format or cook step changes
+	static constexpr uint32_t COOKER_VERSION = 2;
+
+	struct CookStats {
+		uint32_t cooked = 0;
+		uint32_t upToDate = 0;
+		uint32_t failed = 0;
+		std::vector<std::string> errors;
+	};
+
+	// cooks every recognised file under sourceDir into the same relative path under outputDir:
+	//   .obj -> .vmesh   indexed, deduplicated, vertex cache ordered mesh
+	//   .tga/.ppm -> .vtex   full mip chain, bc1 compressed
+	//   .spv -> .spv   structurally validated spir-v
+	//   .vert/.frag/.comp/... -> <name>.spv   glsl compiled with shaderc, taking the place of a .spv of
+	//   the same name so a stale binary next to its source is never used
+	// inputs are hashed (fnv-1a over the content) and skipped when outputDir/manifest.txt already
+	// has the same hash and the output exists. every file is its own job on jobSystem, without one they
+	// are cooked one after another on the calling thread
+	CookStats cookAssets(const std::string& sourceDir, const std::string& outputDir, VJobSystem* jobSystem = nullptr);
+
+	// BRRRR --cook <source dir> <output dir>
+	int runCooker(const std::string& sourceDir, const std::string& outputDir);
+
+	uint64_t hashBytes(const void* data, size_t size, uint64_t seed = 0xcbf29ce484222325ull);
+
+	// the individual cook steps, input is the source file's bytes
+	bool cookMesh(const std::vector<uint8_t>& source, std::vector<uint8_t>& cooked, std::string& error);
+	bool cookTexture(const std::vector<uint8_t>& source, std::vector<uint8_t>& cooked, std::string& error);
+	bool cookShader(const std::vector<uint8_t>& source, std::vector<uint8_t>& cooked, std::string& error);
+	// path only picks the stage, by extension
+	bool cookShaderSource(const std::string& path, const std::vector<uint8_t>& source, VShaderCompiler& compiler, std::vector<uint8_t>& cooked, std::string& error);
+
+	// reorders triangles for the post transform vertex cache (forsyth), then renumbers vertices in
+	// first use order so fetches walk the vertex buffer forwards
+	void optimizeMesh(std::vector<uint32_t>& indices, uint32_t vertexCount, std::vector<uint32_t>& vertexRemap);
+
+}
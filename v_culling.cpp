@@ -0,0 +1,290 @@
+#include "v_culling.hpp"
+
+#include <cmath>
+
+#if defined(__AVX__) || defined(__SSE2__) || defined(_M_X64) || defined(_M_IX86)
+#define VWDW_CULL_SIMD
+#include <immintrin.h>
+#endif
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+namespace vwdw {
+
+static uint32_t lowestBit(uint32_t mask)
+{
+#ifdef _MSC_VER
+	unsigned long index;
+	_BitScanForward(&index, mask);
+	return static_cast<uint32_t>(index);
+#else
+	return static_cast<uint32_t>(__builtin_ctz(mask));
+#endif
+}
+
+VFrustum VFrustum::fromViewProjection(const glm::mat4& m)
+{
+	// glm is column major so row i is (m[0][i], m[1][i], m[2][i], m[3][i])
+	glm::vec4 row0{ m[0][0], m[1][0], m[2][0], m[3][0] };
+	glm::vec4 row1{ m[0][1], m[1][1], m[2][1], m[3][1] };
+	glm::vec4 row2{ m[0][2], m[1][2], m[2][2], m[3][2] };
+	glm::vec4 row3{ m[0][3], m[1][3], m[2][3], m[3][3] };
+
+	VFrustum frustum{};
+	frustum.planes[0] = row3 + row0; // left
+	frustum.planes[1] = row3 - row0; // right
+	frustum.planes[2] = row3 + row1; // bottom
+	frustum.planes[3] = row3 - row1; // top
+	frustum.planes[4] = row2;        // near, depth is zero to one
+	frustum.planes[5] = row3 - row2; // far
+
+	for (auto& plane : frustum.planes)
+	{
+		float len = std::sqrt(plane.x * plane.x + plane.y * plane.y + plane.z * plane.z);
+		if (len > 0.0f)
+		{
+			plane = plane * (1.0f / len);
+		}
+	}
+	return frustum;
+}
+
+void VFrustumCuller::resizeStorage(uint32_t blocks)
+{
+	// storage is always a whole number of simd blocks so the kernel never reads past the end
+	size_t padded = static_cast<size_t>(blocks) * LANES;
+	for (auto* arr : { &sphereX, &sphereY, &sphereZ, &sphereR, &boxX, &boxY, &boxZ, &extentX, &extentY, &extentZ })
+	{
+		arr->resize(padded, 0.0f);
+	}
+}
+
+void VFrustumCuller::reserve(uint32_t objects)
+{
+	size_t padded = static_cast<size_t>((objects + LANES - 1) / LANES) * LANES;
+	for (auto* arr : { &sphereX, &sphereY, &sphereZ, &sphereR, &boxX, &boxY, &boxZ, &extentX, &extentY, &extentZ })
+	{
+		arr->reserve(padded);
+	}
+	visible.reserve(objects);
+}
+
+uint32_t VFrustumCuller::addObject(const glm::vec3& sphereCenter, float sphereRadius, const glm::vec3& boxMin, const glm::vec3& boxMax)
+{
+	uint32_t id = count++;
+	if (id % LANES == 0)
+	{
+		resizeStorage(id / LANES + 1);
+	}
+	updateObject(id, sphereCenter, sphereRadius, boxMin, boxMax);
+	return id;
+}
+
+void VFrustumCuller::updateObject(uint32_t id, const glm::vec3& sphereCenter, float sphereRadius, const glm::vec3& boxMin, const glm::vec3& boxMax)
+{
+	sphereX[id] = sphereCenter.x;
+	sphereY[id] = sphereCenter.y;
+	sphereZ[id] = sphereCenter.z;
+	sphereR[id] = sphereRadius;
+
+	boxX[id] = (boxMin.x + boxMax.x) * 0.5f;
+	boxY[id] = (boxMin.y + boxMax.y) * 0.5f;
+	boxZ[id] = (boxMin.z + boxMax.z) * 0.5f;
+	extentX[id] = (boxMax.x - boxMin.x) * 0.5f;
+	extentY[id] = (boxMax.y - boxMin.y) * 0.5f;
+	extentZ[id] = (boxMax.z - boxMin.z) * 0.5f;
+}
+
+void VFrustumCuller::clear()
+{
+	count = 0;
+	resizeStorage(0);
+	visible.clear();
+}
+
+const std::vector<uint32_t>& VFrustumCuller::cull(const VFrustum& frustum)
+{
+	visible.clear();
+	uint32_t blocks = (count + LANES - 1) / LANES;
+	if (blocks == 0)
+	{
+		return visible;
+	}
+
+	uint32_t workers = getWorkerCount();
+	uint32_t maxWorkers = count / MIN_OBJECTS_PER_WORKER;
+	if (workers > maxWorkers)
+	{
+		workers = maxWorkers == 0 ? 1 : maxWorkers;
+	}
+
+	if (workers == 1)
+	{
+		cullBlocks(frustum, 0, blocks, visible);
+		return visible;
+	}
+
+	if (workerVisible.size() < workers)
+	{
+		workerVisible.resize(workers);
+	}
+
+	// each chunk is a contiguous run of blocks so the merged list stays sorted
+	uint32_t blocksPerWorker = (blocks + workers - 1) / workers;
+	jobs->parallelFor(workers, 1, [&](uint32_t begin, uint32_t end) {
+		for (uint32_t w = begin; w < end; w++)
+		{
+			uint32_t first = w * blocksPerWorker;
+			uint32_t last = first + blocksPerWorker < blocks ? first + blocksPerWorker : blocks;
+			workerVisible[w].clear();
+			if (first < last)
+			{
+				cullBlocks(frustum, first, last, workerVisible[w]);
+			}
+		}
+	});
+
+	for (uint32_t w = 0; w < workers; w++)
+	{
+		visible.insert(visible.end(), workerVisible[w].begin(), workerVisible[w].end());
+	}
+	return visible;
+}
+
+void VFrustumCuller::cullBlocks(const VFrustum& frustum, uint32_t firstBlock, uint32_t lastBlock, std::vector<uint32_t>& out) const
+{
+	// lanes past the last real object are masked off when the final block is emitted
+	uint32_t lastIndex = (count + LANES - 1) / LANES - 1;
+	uint32_t tailLanes = count - lastIndex * LANES;
+	uint32_t tailMask = (1u << tailLanes) - 1;
+
+#if defined(VWDW_CULL_SIMD) && defined(__AVX__)
+	__m256 nx[6], ny[6], nz[6], nw[6], ax[6], ay[6], az[6];
+	for (int p = 0; p < 6; p++)
+	{
+		nx[p] = _mm256_set1_ps(frustum.planes[p].x);
+		ny[p] = _mm256_set1_ps(frustum.planes[p].y);
+		nz[p] = _mm256_set1_ps(frustum.planes[p].z);
+		nw[p] = _mm256_set1_ps(frustum.planes[p].w);
+		ax[p] = _mm256_set1_ps(std::fabs(frustum.planes[p].x));
+		ay[p] = _mm256_set1_ps(std::fabs(frustum.planes[p].y));
+		az[p] = _mm256_set1_ps(std::fabs(frustum.planes[p].z));
+	}
+	const __m256 zero = _mm256_setzero_ps();
+
+	for (uint32_t b = firstBlock; b < lastBlock; b++)
+	{
+		size_t base = static_cast<size_t>(b) * LANES;
+
+		// sphere test first, it's cheaper and rejects most of what's off screen
+		__m256 cx = _mm256_loadu_ps(&sphereX[base]);
+		__m256 cy = _mm256_loadu_ps(&sphereY[base]);
+		__m256 cz = _mm256_loadu_ps(&sphereZ[base]);
+		__m256 r = _mm256_loadu_ps(&sphereR[base]);
+		__m256 inside = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+		for (int p = 0; p < 6; p++)
+		{
+			__m256 d = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(nx[p], cx), _mm256_mul_ps(ny[p], cy)), _mm256_add_ps(_mm256_mul_ps(nz[p], cz), nw[p]));
+			inside = _mm256_and_ps(inside, _mm256_cmp_ps(_mm256_add_ps(d, r), zero, _CMP_GE_OQ));
+		}
+		uint32_t mask = static_cast<uint32_t>(_mm256_movemask_ps(inside));
+		if (mask == 0)
+		{
+			continue;
+		}
+
+		__m256 bx = _mm256_loadu_ps(&boxX[base]);
+		__m256 by = _mm256_loadu_ps(&boxY[base]);
+		__m256 bz = _mm256_loadu_ps(&boxZ[base]);
+		__m256 ex = _mm256_loadu_ps(&extentX[base]);
+		__m256 ey = _mm256_loadu_ps(&extentY[base]);
+		__m256 ez = _mm256_loadu_ps(&extentZ[base]);
+		for (int p = 0; p < 6; p++)
+		{
+			__m256 d = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(nx[p], bx), _mm256_mul_ps(ny[p], by)), _mm256_add_ps(_mm256_mul_ps(nz[p], bz), nw[p]));
+			__m256 e = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(ax[p], ex), _mm256_mul_ps(ay[p], ey)), _mm256_mul_ps(az[p], ez));
+			inside = _mm256_and_ps(inside, _mm256_cmp_ps(_mm256_add_ps(d, e), zero, _CMP_GE_OQ));
+		}
+		mask = static_cast<uint32_t>(_mm256_movemask_ps(inside));
+#elif defined(VWDW_CULL_SIMD)
+	__m128 nx[6], ny[6], nz[6], nw[6], ax[6], ay[6], az[6];
+	for (int p = 0; p < 6; p++)
+	{
+		nx[p] = _mm_set1_ps(frustum.planes[p].x);
+		ny[p] = _mm_set1_ps(frustum.planes[p].y);
+		nz[p] = _mm_set1_ps(frustum.planes[p].z);
+		nw[p] = _mm_set1_ps(frustum.planes[p].w);
+		ax[p] = _mm_set1_ps(std::fabs(frustum.planes[p].x));
+		ay[p] = _mm_set1_ps(std::fabs(frustum.planes[p].y));
+		az[p] = _mm_set1_ps(std::fabs(frustum.planes[p].z));
+	}
+	const __m128 zero = _mm_setzero_ps();
+
+	for (uint32_t b = firstBlock; b < lastBlock; b++)
+	{
+		size_t base = static_cast<size_t>(b) * LANES;
+
+		__m128 cx = _mm_loadu_ps(&sphereX[base]);
+		__m128 cy = _mm_loadu_ps(&sphereY[base]);
+		__m128 cz = _mm_loadu_ps(&sphereZ[base]);
+		__m128 r = _mm_loadu_ps(&sphereR[base]);
+		__m128 inside = _mm_castsi128_ps(_mm_set1_epi32(-1));
+		for (int p = 0; p < 6; p++)
+		{
+			__m128 d = _mm_add_ps(_mm_add_ps(_mm_mul_ps(nx[p], cx), _mm_mul_ps(ny[p], cy)), _mm_add_ps(_mm_mul_ps(nz[p], cz), nw[p]));
+			inside = _mm_and_ps(inside, _mm_cmpge_ps(_mm_add_ps(d, r), zero));
+		}
+		uint32_t mask = static_cast<uint32_t>(_mm_movemask_ps(inside));
+		if (mask == 0)
+		{
+			continue;
+		}
+
+		__m128 bx = _mm_loadu_ps(&boxX[base]);
+		__m128 by = _mm_loadu_ps(&boxY[base]);
+		__m128 bz = _mm_loadu_ps(&boxZ[base]);
+		__m128 ex = _mm_loadu_ps(&extentX[base]);
+		__m128 ey = _mm_loadu_ps(&extentY[base]);
+		__m128 ez = _mm_loadu_ps(&extentZ[base]);
+		for (int p = 0; p < 6; p++)
+		{
+			__m128 d = _mm_add_ps(_mm_add_ps(_mm_mul_ps(nx[p], bx), _mm_mul_ps(ny[p], by)), _mm_add_ps(_mm_mul_ps(nz[p], bz), nw[p]));
+			__m128 e = _mm_add_ps(_mm_add_ps(_mm_mul_ps(ax[p], ex), _mm_mul_ps(ay[p], ey)), _mm_mul_ps(az[p], ez));
+			inside = _mm_and_ps(inside, _mm_cmpge_ps(_mm_add_ps(d, e), zero));
+		}
+		mask = static_cast<uint32_t>(_mm_movemask_ps(inside));
+#else
+	for (uint32_t b = firstBlock; b < lastBlock; b++)
+	{
+		size_t base = static_cast<size_t>(b) * LANES;
+		uint32_t mask = 0;
+		for (uint32_t lane = 0; lane < LANES; lane++)
+		{
+			size_t i = base + lane;
+			bool inside = true;
+			for (int p = 0; p < 6 && inside; p++)
+			{
+				const glm::vec4& pl = frustum.planes[p];
+				float ds = pl.x * sphereX[i] + pl.y * sphereY[i] + pl.z * sphereZ[i] + pl.w;
+				float db = pl.x * boxX[i] + pl.y * boxY[i] + pl.z * boxZ[i] + pl.w;
+				float e = std::fabs(pl.x) * extentX[i] + std::fabs(pl.y) * extentY[i] + std::fabs(pl.z) * extentZ[i];
+				inside = ds + sphereR[i] >= 0.0f && db + e >= 0.0f;
+			}
+			mask |= inside ? 1u << lane : 0u;
+		}
+#endif
+		if (b == lastIndex)
+		{
+			mask &= tailMask;
+		}
+		while (mask != 0)
+		{
+			out.push_back(static_cast<uint32_t>(base) + lowestBit(mask));
+			mask &= mask - 1;
+		}
+	}
+}
+
+}
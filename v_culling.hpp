@@ -0,0 +1,77 @@
+#pragma once
+
+#define GLM_FORCE_RADIANS
+#define GLM_FORCE_DEPTH_ZERO_TO_ONE
+#include<glm/glm.hpp>
+
+#include "v_jobs.hpp"
+
+#include <cstdint>
+#include <vector>
+
+namespace vwdw {
+
+	// six normalized planes (xyz = inward normal, w = distance) pulled out of a view projection matrix
+	struct VFrustum {
+		glm::vec4 planes[6];
+
+		static VFrustum fromViewProjection(const glm::mat4& viewProj);
+	};
+
+	// keeps object bounds as structure of arrays so the frustum test can run 4 (SSE) or 8 (AVX) objects per instruction
+	class VFrustumCuller {
+	public:
+#if defined(__AVX__)
+		static constexpr uint32_t LANES = 8;
+#else
+		static constexpr uint32_t LANES = 4;
+#endif
+		// below this many objects per worker the threads cost more than they save
+		static constexpr uint32_t MIN_OBJECTS_PER_WORKER = 32 * 1024;
+
+		VFrustumCuller() = default;
+		~VFrustumCuller() = default;
+
+		VFrustumCuller(const VFrustumCuller&) = delete;
+		VFrustumCuller& operator=(const VFrustumCuller&) = delete;
+
+		uint32_t addObject(const glm::vec3& sphereCenter, float sphereRadius, const glm::vec3& boxMin, const glm::vec3& boxMax);
+		void updateObject(uint32_t id, const glm::vec3& sphereCenter, float sphereRadius, const glm::vec3& boxMin, const glm::vec3& boxMax);
+		void reserve(uint32_t objects);
+		void clear();
+
+		uint32_t objectCount() const { return count; }
+		// the culled range is split across the system's workers, null culls on the calling thread
+		void setJobSystem(VJobSystem* jobSystem) { jobs = jobSystem; }
+		uint32_t getWorkerCount() const { return jobs != nullptr ? jobs->workerCount() : 1; }
+
+		// tests every object against the frustum, returns the ids that survive in ascending order
+		const std::vector<uint32_t>& cull(const VFrustum& frustum);
+		const std::vector<uint32_t>& visibleObjects() const { return visible; }
+
+	private:
+		void resizeStorage(uint32_t blocks);
+		void cullBlocks(const VFrustum& frustum, uint32_t firstBlock, uint32_t lastBlock, std::vector<uint32_t>& out) const;
+
+		uint32_t count = 0;
+		VJobSystem* jobs = nullptr;
+
+		// bounding spheres
+		std::vector<float> sphereX;
+		std::vector<float> sphereY;
+		std::vector<float> sphereZ;
+		std::vector<float> sphereR;
+
+		// aabbs stored as center and half extents
+		std::vector<float> boxX;
+		std::vector<float> boxY;
+		std::vector<float> boxZ;
+		std::vector<float> extentX;
+		std::vector<float> extentY;
+		std::vector<float> extentZ;
+
+		std::vector<uint32_t> visible;
+		std::vector<std::vector<uint32_t>> workerVisible;
+	};
+
+}
@@ -0,0 +1,161 @@
+#include "v_draw_capture.hpp"
+
+#include <stdexcept>
+
+namespace vwdw {
+
+VDrawCaptureWriter::VDrawCaptureWriter(const std::string& path, uint32_t meshCount, uint32_t textureCount)
+	: path{ path }, file{ path, std::ios::binary | std::ios::trunc }
+{
+	if (!file.is_open())
+	{
+		throw std::runtime_error("failed to open file: " + path);
+	}
+	header.magic = DRAW_CAPTURE_MAGIC;
+	header.version = DRAW_CAPTURE_VERSION;
+	header.meshCount = meshCount;
+	header.textureCount = textureCount;
+	file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+}
+
+VDrawCaptureWriter::~VDrawCaptureWriter()
+{
+	close();
+}
+
+void VDrawCaptureWriter::write(const CapturedFrame& frame)
+{
+	if (!file.is_open())
+	{
+		return;
+	}
+	DrawCaptureFrame frameHeader{};
+	frameHeader.drawCount = static_cast<uint32_t>(frame.draws.size());
+	for (int column = 0; column < 4; column++)
+	{
+		for (int row = 0; row < 4; row++)
+		{
+			frameHeader.viewProjection[column * 4 + row] = frame.viewProjection[column][row];
+		}
+	}
+
+	packed.resize(frame.draws.size());
+	for (size_t i = 0; i < frame.draws.size(); i++)
+	{
+		const CapturedDraw& draw = frame.draws[i];
+		DrawCaptureDraw& out = packed[i];
+		for (int row = 0; row < 3; row++)
+		{
+			for (int column = 0; column < 4; column++)
+			{
+				out.transform[row * 4 + column] = draw.transform[column][row];
+			}
+		}
+		for (int c = 0; c < 4; c++)
+		{
+			out.tint[c] = draw.tint[c];
+		}
+		out.mesh = draw.mesh;
+		out.variant = draw.variant;
+		out.texture = draw.texture;
+		out.depth = draw.depth;
+	}
+
+	file.write(reinterpret_cast<const char*>(&frameHeader), sizeof(frameHeader));
+	file.write(reinterpret_cast<const char*>(packed.data()), static_cast<std::streamsize>(sizeof(DrawCaptureDraw) * packed.size()));
+	if (!file)
+	{
+		throw std::runtime_error("failed to write draw capture: " + path);
+	}
+	header.frameCount++;
+}
+
+void VDrawCaptureWriter::close()
+{
+	if (!file.is_open())
+	{
+		return;
+	}
+	file.seekp(0);
+	file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+	file.close();
+}
+
+VDrawCapture VDrawCapture::load(const std::string& path)
+{
+	std::ifstream file{ path, std::ios::binary };
+	if (!file.is_open())
+	{
+		throw std::runtime_error("failed to open file: " + path);
+	}
+
+	DrawCaptureHeader header{};
+	file.read(reinterpret_cast<char*>(&header), sizeof(header));
+	if (!file || header.magic != DRAW_CAPTURE_MAGIC || header.version != DRAW_CAPTURE_VERSION)
+	{
+		throw std::runtime_error("not a draw capture: " + path);
+	}
+
+	// the counts are only trusted as far as the bytes after them can back them up, a corrupt header
+	// must not turn into a huge allocation
+	file.seekg(0, std::ios::end);
+	uint64_t remaining = static_cast<uint64_t>(file.tellg()) - sizeof(header);
+	file.seekg(sizeof(header));
+	if (header.frameCount > remaining / sizeof(DrawCaptureFrame))
+	{
+		throw std::runtime_error("truncated draw capture: " + path);
+	}
+
+	VDrawCapture capture;
+	capture.meshCount = header.meshCount;
+	capture.textureCount = header.textureCount;
+	capture.frames.resize(header.frameCount);
+	std::vector<DrawCaptureDraw> packed;
+	for (CapturedFrame& frame : capture.frames)
+	{
+		DrawCaptureFrame frameHeader{};
+		file.read(reinterpret_cast<char*>(&frameHeader), sizeof(frameHeader));
+		remaining -= sizeof(frameHeader);
+		if (!file || frameHeader.drawCount > remaining / sizeof(DrawCaptureDraw))
+		{
+			throw std::runtime_error("truncated draw capture: " + path);
+		}
+		remaining -= sizeof(DrawCaptureDraw) * static_cast<uint64_t>(frameHeader.drawCount);
+		for (int column = 0; column < 4; column++)
+		{
+			for (int row = 0; row < 4; row++)
+			{
+				frame.viewProjection[column][row] = frameHeader.viewProjection[column * 4 + row];
+			}
+		}
+
+		packed.resize(frameHeader.drawCount);
+		file.read(reinterpret_cast<char*>(packed.data()), static_cast<std::streamsize>(sizeof(DrawCaptureDraw) * packed.size()));
+		if (!file)
+		{
+			throw std::runtime_error("truncated draw capture: " + path);
+		}
+		frame.draws.resize(packed.size());
+		for (size_t i = 0; i < packed.size(); i++)
+		{
+			const DrawCaptureDraw& in = packed[i];
+			CapturedDraw& draw = frame.draws[i];
+			draw.transform = glm::mat4{ 1.0f };
+			for (int row = 0; row < 3; row++)
+			{
+				for (int column = 0; column < 4; column++)
+				{
+					draw.transform[column][row] = in.transform[row * 4 + column];
+				}
+			}
+			draw.tint = glm::vec4{ in.tint[0], in.tint[1], in.tint[2], in.tint[3] };
+			draw.mesh = in.mesh;
+			draw.variant = in.variant;
+			draw.texture = in.texture;
+			draw.depth = in.depth;
+		}
+	}
+	return capture;
+}
+
+}
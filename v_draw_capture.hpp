@@ -0,0 +1,91 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+
+namespace vwdw {
+
+	static constexpr uint32_t DRAW_CAPTURE_MAGIC = 0x50434456; // "VDCP"
+	static constexpr uint32_t DRAW_CAPTURE_VERSION = 1;
+
+	// one opaque draw as the engine queued it. mesh, texture and variant are the engine's own ids (cooked
+	// file order, pipeline variant order), so a capture only replays against the same cooked assets
+	struct CapturedDraw {
+		glm::mat4 transform{ 1.0f };
+		glm::vec4 tint{ 1.0f };
+		uint32_t mesh = 0;
+		uint32_t variant = 0;
+		// index into the cooked textures, UINT32_MAX for none
+		uint32_t texture = UINT32_MAX;
+		// the sort depth, kept so a replay sorts exactly like the captured frame did
+		float depth = 0.0f;
+	};
+
+	struct CapturedFrame {
+		glm::mat4 viewProjection{ 1.0f };
+		std::vector<CapturedDraw> draws;
+	};
+
+	// the file, little endian: DrawCaptureHeader, then per frame a DrawCaptureFrame followed by
+	// drawCount DrawCaptureDraw. transforms are affine and stored as their top three rows
+	struct DrawCaptureHeader {
+		uint32_t magic;
+		uint32_t version;
+		uint32_t frameCount;
+		// how many meshes and textures the capturing engine had, a replay needs at least as many
+		uint32_t meshCount;
+		uint32_t textureCount;
+	};
+
+	struct DrawCaptureFrame {
+		uint32_t drawCount;
+		float viewProjection[16];
+	};
+
+	struct DrawCaptureDraw {
+		float transform[12];
+		float tint[4];
+		uint32_t mesh;
+		uint32_t variant;
+		uint32_t texture;
+		float depth;
+	};
+
+	// appends frames to a capture file as they're drawn. the frame count in the header is only right
+	// once the writer is closed or destroyed
+	class VDrawCaptureWriter {
+	public:
+		VDrawCaptureWriter(const std::string& path, uint32_t meshCount, uint32_t textureCount);
+		~VDrawCaptureWriter();
+
+		VDrawCaptureWriter(const VDrawCaptureWriter&) = delete;
+		VDrawCaptureWriter& operator=(const VDrawCaptureWriter&) = delete;
+
+		void write(const CapturedFrame& frame);
+		// patches the header, nothing is written after it
+		void close();
+
+		uint32_t frameCount() const { return header.frameCount; }
+
+	private:
+		std::string path;
+		std::ofstream file;
+		DrawCaptureHeader header{};
+		// one frame's draws, converted in one go and written with a single call
+		std::vector<DrawCaptureDraw> packed;
+	};
+
+	// a whole capture read back into memory, so replaying it never touches the disk
+	struct VDrawCapture {
+		uint32_t meshCount = 0;
+		uint32_t textureCount = 0;
+		std::vector<CapturedFrame> frames;
+
+		static VDrawCapture load(const std::string& path);
+	};
+
+}
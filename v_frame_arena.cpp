@@ -0,0 +1,99 @@
+#include "v_frame_arena.hpp"
+
+#include <algorithm>
+
+namespace vwdw {
+
+VLinearArena::VLinearArena(void* buffer, size_t size, std::pmr::memory_resource* upstream)
+	: base{ static_cast<std::byte*>(buffer) }, size{ size }, upstream{ upstream }
+{
+}
+
+VLinearArena::VLinearArena(size_t size, std::pmr::memory_resource* upstream)
+	: owned{ new std::byte[size] }, base{ owned.get() }, size{ size }, upstream{ upstream }
+{
+}
+
+VLinearArena::~VLinearArena()
+{
+	reset();
+}
+
+void VLinearArena::reset()
+{
+	while (overflowList != nullptr)
+	{
+		Overflow* block = overflowList;
+		overflowList = block->next;
+		upstream->deallocate(block, block->bytes, block->alignment);
+	}
+	offset = 0;
+	overflowBytes = 0;
+}
+
+void* VLinearArena::do_allocate(size_t bytes, size_t alignment)
+{
+	// aligned on the address, the base itself is only aligned to max_align_t
+	uintptr_t address = reinterpret_cast<uintptr_t>(base) + offset;
+	size_t aligned = offset + (((address + alignment - 1) & ~(uintptr_t(alignment) - 1)) - address);
+	if (aligned + bytes <= size)
+	{
+		offset = aligned + bytes;
+		peak = std::max(peak, offset + overflowBytes);
+		return base + aligned;
+	}
+
+	// the header is rounded up to a multiple of the alignment so the payload after it stays aligned
+	size_t headerSize = (sizeof(Overflow) + alignment - 1) / alignment * alignment;
+	size_t blockAlignment = std::max(alignof(Overflow), alignment);
+	Overflow* block = static_cast<Overflow*>(upstream->allocate(headerSize + bytes, blockAlignment));
+	block->next = overflowList;
+	block->bytes = headerSize + bytes;
+	block->alignment = blockAlignment;
+	overflowList = block;
+	overflowBytes += bytes;
+	overflows++;
+	peak = std::max(peak, offset + overflowBytes);
+	return reinterpret_cast<std::byte*>(block) + headerSize;
+}
+
+void VLinearArena::do_deallocate(void*, size_t, size_t)
+{
+	// everything goes at once in reset()
+}
+
+VFrameArena::VFrameArena(size_t bytesPerFrame, uint32_t framesInFlight)
+{
+	for (uint32_t i = 0; i < framesInFlight; i++)
+	{
+		frames.push_back(std::make_unique<VLinearArena>(bytesPerFrame));
+	}
+}
+
+void VFrameArena::beginFrame(uint32_t frameIndex)
+{
+	current = frameIndex;
+	frames[current]->reset();
+}
+
+size_t VFrameArena::highWater() const
+{
+	size_t peak = 0;
+	for (const auto& frame : frames)
+	{
+		peak = std::max(peak, frame->highWater());
+	}
+	return peak;
+}
+
+uint64_t VFrameArena::overflowCount() const
+{
+	uint64_t count = 0;
+	for (const auto& frame : frames)
+	{
+		count += frame->overflowCount();
+	}
+	return count;
+}
+
+}
@@ -0,0 +1,91 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <memory_resource>
+#include <vector>
+
+namespace vwdw {
+
+	// bump allocator behind a std::pmr::memory_resource, so any std::pmr container can live in it.
+	// deallocate is a no-op and reset() rewinds the whole thing at once. running out of space isn't
+	// an error, the request goes to the upstream resource and is freed on the next reset(); the
+	// overflow counters say when the arena should be made bigger. not thread safe
+	class VLinearArena : public std::pmr::memory_resource {
+	public:
+		// over memory owned by the caller
+		VLinearArena(void* buffer, size_t size, std::pmr::memory_resource* upstream = std::pmr::new_delete_resource());
+		// over a buffer of its own, allocated once
+		explicit VLinearArena(size_t size, std::pmr::memory_resource* upstream = std::pmr::new_delete_resource());
+		~VLinearArena() override;
+
+		VLinearArena(const VLinearArena&) = delete;
+		VLinearArena& operator=(const VLinearArena&) = delete;
+
+		// O(1) unless something overflowed since the last reset
+		void reset();
+
+		size_t capacity() const { return size; }
+		size_t bytesUsed() const { return offset; }
+		// most ever used between two resets, overflow included
+		size_t highWater() const { return peak; }
+		// requests that went upstream since construction
+		uint64_t overflowCount() const { return overflows; }
+
+	protected:
+		void* do_allocate(size_t bytes, size_t alignment) override;
+		void do_deallocate(void* p, size_t bytes, size_t alignment) override;
+		bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override { return this == &other; }
+
+	private:
+		// header in front of every upstream block, chained so reset() can hand them back
+		struct Overflow {
+			Overflow* next;
+			size_t bytes;
+			size_t alignment;
+		};
+
+		std::unique_ptr<std::byte[]> owned;
+		std::byte* base;
+		size_t size;
+		size_t offset = 0;
+		size_t overflowBytes = 0;
+		size_t peak = 0;
+		uint64_t overflows = 0;
+		Overflow* overflowList = nullptr;
+		std::pmr::memory_resource* upstream;
+	};
+
+	// arena with its storage inline, for scratch containers on the stack
+	template<size_t Size>
+	class VScratchArena : public VLinearArena {
+	public:
+		VScratchArena() : VLinearArena{ storage, Size } {}
+
+	private:
+		alignas(std::max_align_t) std::byte storage[Size];
+	};
+
+	// one arena per frame in flight. beginFrame() rewinds the arena of the slot being started, so
+	// anything allocated while recording a frame stays valid until that slot comes round again
+	class VFrameArena {
+	public:
+		VFrameArena(size_t bytesPerFrame, uint32_t framesInFlight);
+
+		VFrameArena(const VFrameArena&) = delete;
+		VFrameArena& operator=(const VFrameArena&) = delete;
+
+		// call once the slot's fence has been waited on
+		void beginFrame(uint32_t frameIndex);
+		std::pmr::memory_resource* resource() { return frames[current].get(); }
+
+		size_t highWater() const;
+		uint64_t overflowCount() const;
+
+	private:
+		std::vector<std::unique_ptr<VLinearArena>> frames;
+		uint32_t current = 0;
+	};
+
+}
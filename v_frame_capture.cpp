@@ -0,0 +1,255 @@
+#include "v_frame_capture.hpp"
+#include "v_image.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <filesystem>
+#include <limits>
+#include <stdexcept>
+
+namespace vwdw {
+
+static bool isBgra(VkFormat format)
+{
+	return format == VK_FORMAT_B8G8R8A8_SRGB || format == VK_FORMAT_B8G8R8A8_UNORM;
+}
+
+bool VFrameCapture::isCapturable(VkFormat format)
+{
+	return isBgra(format) || format == VK_FORMAT_R8G8B8A8_SRGB || format == VK_FORMAT_R8G8B8A8_UNORM;
+}
+
+// cached memory is much faster for the cpu to read, not every device has it
+static VkMemoryPropertyFlags readbackMemory(VDevice& device)
+{
+	try
+	{
+		device.findMemoryType(~0u, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_CACHED_BIT);
+		return VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_CACHED_BIT;
+	}
+	catch (const std::runtime_error&)
+	{
+		return VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+	}
+}
+
+VFrameCapture::VFrameCapture(VDevice& device, const std::string& dir, CaptureFormat format, uint32_t encoderThreads)
+	: vDevice{ device }, dir{ dir }, format{ format }, memoryProperties{ readbackMemory(device) }
+{
+	std::error_code ec;
+	std::filesystem::create_directories(dir, ec);
+	if (ec)
+	{
+		throw std::runtime_error("failed to create capture directory " + dir);
+	}
+
+	if (encoderThreads == 0)
+	{
+		encoderThreads = std::max(1u, std::thread::hardware_concurrency() / 4);
+	}
+	queue.reserve(RING_SIZE);
+	for (uint32_t i = 0; i < encoderThreads; i++)
+	{
+		encoders.emplace_back([this]() { encodeLoop(); });
+	}
+}
+
+VFrameCapture::~VFrameCapture()
+{
+	finish();
+}
+
+void VFrameCapture::finish()
+{
+	if (encoders.empty())
+	{
+		return;
+	}
+	vkDeviceWaitIdle(vDevice.device());
+	// every copy is done now, a frame this far ahead hands all of them over
+	beginFrame(std::numeric_limits<uint64_t>::max() - VSwapChain::MAX_FRAMES_IN_FLIGHT);
+	{
+		std::lock_guard<std::mutex> lock{ mutex };
+		stopping = true;
+	}
+	ready.notify_all();
+	for (std::thread& encoder : encoders)
+	{
+		encoder.join();
+	}
+	encoders.clear();
+}
+
+void VFrameCapture::beginFrame(uint64_t frame)
+{
+	bool any = false;
+	for (Slot& slot : slots)
+	{
+		if (slot.state.load(std::memory_order_acquire) != SlotState::Copying || slot.frame + VSwapChain::MAX_FRAMES_IN_FLIGHT > frame)
+		{
+			continue;
+		}
+		slot.buffer->invalidate();
+		slot.state.store(SlotState::Encoding, std::memory_order_relaxed);
+		std::lock_guard<std::mutex> lock{ mutex };
+		queue.push_back(&slot);
+		any = true;
+	}
+	if (any)
+	{
+		ready.notify_all();
+	}
+}
+
+bool VFrameCapture::record(VkCommandBuffer commandBuffer, VkImage image, VkImageLayout layout, VkFormat imageFormat, VkExtent2D extent, uint64_t frame)
+{
+	Slot& slot = slots[nextSlot];
+	if (!isCapturable(imageFormat) || slot.state.load(std::memory_order_acquire) != SlotState::Free)
+	{
+		dropped++;
+		return false;
+	}
+
+	// grown when the window is, only ever on a free slot
+	VkDeviceSize size = static_cast<VkDeviceSize>(extent.width) * extent.height * 4;
+	if (!slot.buffer || slot.buffer->getSize() < size)
+	{
+		slot.buffer.reset();
+		slot.buffer = std::make_unique<VBuffer>(vDevice, size, VK_BUFFER_USAGE_TRANSFER_DST_BIT, memoryProperties);
+	}
+
+	// the image usually just went to PRESENT_SRC with dstStage BOTTOM_OF_PIPE, which nothing after it
+	// can chain with, so this waits on everything before it instead of the attachment output stage
+	VkImageMemoryBarrier toTransfer{};
+	toTransfer.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+	toTransfer.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	toTransfer.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	toTransfer.image = image;
+	toTransfer.subresourceRange = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1 };
+	toTransfer.oldLayout = layout;
+	toTransfer.newLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+	toTransfer.srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+	toTransfer.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+	vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 0, nullptr, 1, &toTransfer);
+
+	VkBufferImageCopy region{};
+	region.imageSubresource = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1 };
+	region.imageExtent = { extent.width, extent.height, 1 };
+	vkCmdCopyImageToBuffer(commandBuffer, image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, slot.buffer->getBuffer(), 1, &region);
+
+	// back for presenting, and the copy made visible to the host reads once the fence is waited on
+	VkImageMemoryBarrier toPresent = toTransfer;
+	toPresent.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+	toPresent.newLayout = layout;
+	toPresent.srcAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+	toPresent.dstAccessMask = 0;
+	VkBufferMemoryBarrier toHost{};
+	toHost.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+	toHost.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	toHost.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	toHost.buffer = slot.buffer->getBuffer();
+	toHost.size = size;
+	toHost.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+	toHost.dstAccessMask = VK_ACCESS_HOST_READ_BIT;
+	vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT | VK_PIPELINE_STAGE_HOST_BIT, 0, 0, nullptr, 1, &toHost, 1, &toPresent);
+
+	if (format == CaptureFormat::Raw && (extent.width != rawExtent.width || extent.height != rawExtent.height))
+	{
+		// a raw stream can't change size halfway, the new size starts a new file. created here so
+		// the encoders only ever open files that exist
+		rawExtent = extent;
+		rawFrames = 0;
+		std::ofstream{ rawPath(rawFileCount++, extent), std::ios::binary | std::ios::trunc };
+	}
+	slot.format = imageFormat;
+	slot.extent = extent;
+	slot.frame = frame;
+	slot.rawFile = rawFileCount - 1;
+	slot.rawIndex = rawFrames++;
+	slot.state.store(SlotState::Copying, std::memory_order_relaxed);
+	nextSlot = (nextSlot + 1) % RING_SIZE;
+	return true;
+}
+
+void VFrameCapture::encodeLoop()
+{
+	// reused frame after frame, after the first one an encoder doesn't allocate much
+	VImageData image;
+	std::vector<uint8_t> file;
+	for (;;)
+	{
+		Slot* slot;
+		{
+			std::unique_lock<std::mutex> lock{ mutex };
+			ready.wait(lock, [this]() { return stopping || !queue.empty(); });
+			if (queue.empty())
+			{
+				return;
+			}
+			slot = queue.front();
+			queue.erase(queue.begin());
+		}
+		encode(*slot, image, file);
+		slot->state.store(SlotState::Free, std::memory_order_release);
+	}
+}
+
+void VFrameCapture::encode(Slot& slot, VImageData& image, std::vector<uint8_t>& file)
+{
+	// rgba with opaque alpha, the swapchain's alpha is whatever the blend left there
+	image.width = slot.extent.width;
+	image.height = slot.extent.height;
+	size_t pixelCount = static_cast<size_t>(image.width) * image.height;
+	image.pixels.resize(pixelCount * 4);
+	const uint8_t* src = static_cast<const uint8_t*>(slot.buffer->getMappedMemory());
+	uint8_t* dst = image.pixels.data();
+	uint32_t red = isBgra(slot.format) ? 2 : 0;
+	for (size_t i = 0; i < pixelCount; i++, src += 4, dst += 4)
+	{
+		dst[0] = src[red];
+		dst[1] = src[1];
+		dst[2] = src[2 - red];
+		dst[3] = 255;
+	}
+
+	bool ok;
+	if (format == CaptureFormat::Raw)
+	{
+		ok = writeRaw(slot, image.pixels);
+	}
+	else
+	{
+		encodePng(image, file);
+		char name[32];
+		std::snprintf(name, sizeof(name), "frame_%06llu.png", static_cast<unsigned long long>(slot.frame));
+		std::ofstream out{ (std::filesystem::path(dir) / name).string(), std::ios::binary | std::ios::trunc };
+		out.write(reinterpret_cast<const char*>(file.data()), static_cast<std::streamsize>(file.size()));
+		ok = out.good();
+	}
+	(ok ? written : failed).fetch_add(1, std::memory_order_relaxed);
+}
+
+bool VFrameCapture::writeRaw(const Slot& slot, const std::vector<uint8_t>& pixels)
+{
+	std::lock_guard<std::mutex> lock{ rawMutex };
+	if (rawStreamFile != slot.rawFile)
+	{
+		rawStream.close();
+		rawStream.clear();
+		rawStream.open(rawPath(slot.rawFile, slot.extent), std::ios::binary | std::ios::in | std::ios::out);
+		rawStreamFile = slot.rawFile;
+	}
+	// frames finish out of order across the encoders, each goes to its own place in the stream
+	rawStream.clear();
+	rawStream.seekp(static_cast<std::streamoff>(slot.rawIndex * pixels.size()));
+	rawStream.write(reinterpret_cast<const char*>(pixels.data()), static_cast<std::streamsize>(pixels.size()));
+	rawStream.flush();
+	return rawStream.good();
+}
+
+std::string VFrameCapture::rawPath(uint32_t file, VkExtent2D extent) const
+{
+	return (std::filesystem::path(dir) / ("capture_" + std::to_string(file) + "_" + std::to_string(extent.width) + "x" + std::to_string(extent.height) + ".rgba")).string();
+}
+
+}
@@ -0,0 +1,112 @@
+#pragma once
+
+#include "VDevice.hpp"
+#include "v_buffer.hpp"
+#include "v_swap_chain.hpp"
+
+#include <array>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace vwdw {
+
+	struct VImageData;
+
+	enum class CaptureFormat {
+		// dir/frame_<frame number>.png, one file per frame
+		Png,
+		// dir/capture_<n>_<width>x<height>.rgba, frames back to back, a new file whenever the size
+		// changes. ffmpeg -f rawvideo -pix_fmt rgba -s <width>x<height> -i ...
+		Raw,
+	};
+
+	// copies finished frames out of the swapchain without ever waiting on the gpu. each frame's copy
+	// goes into the next free buffer of a small host visible ring at the end of its command buffer.
+	// it's known to be done once the acquire MAX_FRAMES_IN_FLIGHT frames later has waited on the
+	// frame slot's fence, and is handed to encoder threads of the capture's own from there. they don't
+	// use the job system on purpose: the render thread runs jobs while it waits on its own, and a
+	// png there would stall the frame. a frame that finds every buffer busy is dropped, not waited for
+	class VFrameCapture {
+	public:
+		// copying, then encoding for as long as a frame takes at most
+		static constexpr uint32_t RING_SIZE = VSwapChain::MAX_FRAMES_IN_FLIGHT + 2;
+
+		// encoderThreads 0 uses a quarter of the cores
+		VFrameCapture(VDevice& device, const std::string& dir, CaptureFormat format, uint32_t encoderThreads = 0);
+		~VFrameCapture();
+
+		VFrameCapture(const VFrameCapture&) = delete;
+		VFrameCapture& operator=(const VFrameCapture&) = delete;
+
+		// 8 bit rgba / bgra, anything else isn't recorded
+		static bool isCapturable(VkFormat format);
+
+		// after the acquire's fence wait, passes every finished copy on to the encoders
+		void beginFrame(uint64_t frame);
+		// at the end of the frame's command buffer, image is in layout before and after. false when
+		// the frame was dropped
+		bool record(VkCommandBuffer commandBuffer, VkImage image, VkImageLayout layout, VkFormat format, VkExtent2D extent, uint64_t frame);
+
+		// waits for the device, then for every frame already copied to be written. nothing is
+		// recorded after it
+		void finish();
+
+		uint32_t writtenCount() const { return written.load(std::memory_order_relaxed); }
+		uint32_t droppedCount() const { return dropped; }
+		uint32_t failedCount() const { return failed.load(std::memory_order_relaxed); }
+
+	private:
+		enum class SlotState : uint32_t { Free, Copying, Encoding };
+
+		struct Slot {
+			std::unique_ptr<VBuffer> buffer;
+			VkFormat format = VK_FORMAT_UNDEFINED;
+			VkExtent2D extent{};
+			uint64_t frame = 0;
+			// Raw only, where in which file the frame goes
+			uint32_t rawFile = 0;
+			uint64_t rawIndex = 0;
+			std::atomic<SlotState> state{ SlotState::Free };
+		};
+
+		void encodeLoop();
+		void encode(Slot& slot, VImageData& image, std::vector<uint8_t>& file);
+		bool writeRaw(const Slot& slot, const std::vector<uint8_t>& pixels);
+		std::string rawPath(uint32_t file, VkExtent2D extent) const;
+
+		VDevice& vDevice;
+		std::string dir;
+		CaptureFormat format;
+		VkMemoryPropertyFlags memoryProperties;
+		std::array<Slot, RING_SIZE> slots;
+		// the next slot record() tries, the ring is used in order
+		uint32_t nextSlot = 0;
+		uint32_t dropped = 0;
+		std::atomic<uint32_t> written{ 0 };
+		std::atomic<uint32_t> failed{ 0 };
+
+		// Raw bookkeeping on the render thread
+		VkExtent2D rawExtent{};
+		uint32_t rawFileCount = 0;
+		uint64_t rawFrames = 0;
+		// the encoders share one open stream, positioned per frame
+		std::mutex rawMutex;
+		std::ofstream rawStream;
+		uint32_t rawStreamFile = UINT32_MAX;
+
+		std::mutex mutex;
+		std::condition_variable ready;
+		// never holds more than the ring, so reserving it once keeps frames from allocating
+		std::vector<Slot*> queue;
+		bool stopping = false;
+		std::vector<std::thread> encoders;
+	};
+
+}
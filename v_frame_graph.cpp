@@ -0,0 +1,622 @@
+#include "v_frame_graph.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <stdexcept>
+
+namespace vwdw {
+
+struct AccessInfo {
+	VkPipelineStageFlags stages;
+	VkAccessFlags access;
+	VkImageLayout layout;
+	VkImageUsageFlags usage;
+};
+
+static AccessInfo accessInfo(VFrameGraph::Access access)
+{
+	switch (access)
+	{
+	case VFrameGraph::Access::ColorAttachment:
+		return { VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, VK_ACCESS_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT,
+			VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL, VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT };
+	case VFrameGraph::Access::DepthAttachment:
+		return { VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT,
+			VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT,
+			VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL, VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT };
+	case VFrameGraph::Access::DepthRead:
+		return { VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT, VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT,
+			VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL, VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT };
+	case VFrameGraph::Access::Sampled:
+		return { VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT,
+			VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_IMAGE_USAGE_SAMPLED_BIT };
+	case VFrameGraph::Access::StorageRead:
+		return { VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT, VK_IMAGE_LAYOUT_GENERAL, VK_IMAGE_USAGE_STORAGE_BIT };
+	case VFrameGraph::Access::StorageWrite:
+		return { VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT, VK_IMAGE_LAYOUT_GENERAL, VK_IMAGE_USAGE_STORAGE_BIT };
+	case VFrameGraph::Access::TransferSrc:
+		return { VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_READ_BIT, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, VK_IMAGE_USAGE_TRANSFER_SRC_BIT };
+	case VFrameGraph::Access::TransferDst:
+		return { VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_WRITE_BIT, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_USAGE_TRANSFER_DST_BIT };
+	case VFrameGraph::Access::Present:
+		return { VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 0, VK_IMAGE_LAYOUT_PRESENT_SRC_KHR, 0 };
+	}
+	throw std::runtime_error("unknown frame graph access");
+}
+
+static VkImageAspectFlags aspectFor(VkFormat format)
+{
+	switch (format)
+	{
+	case VK_FORMAT_D16_UNORM:
+	case VK_FORMAT_D32_SFLOAT:
+	case VK_FORMAT_X8_D24_UNORM_PACK32:
+		return VK_IMAGE_ASPECT_DEPTH_BIT;
+	case VK_FORMAT_D16_UNORM_S8_UINT:
+	case VK_FORMAT_D24_UNORM_S8_UINT:
+	case VK_FORMAT_D32_SFLOAT_S8_UINT:
+		return VK_IMAGE_ASPECT_DEPTH_BIT | VK_IMAGE_ASPECT_STENCIL_BIT;
+	default:
+		return VK_IMAGE_ASPECT_COLOR_BIT;
+	}
+}
+
+// planning only, close enough for the formats render targets actually use
+static VkDeviceSize bytesPerPixel(VkFormat format)
+{
+	switch (format)
+	{
+	case VK_FORMAT_R8_UNORM:
+		return 1;
+	case VK_FORMAT_R16G16B16A16_SFLOAT:
+	case VK_FORMAT_D32_SFLOAT_S8_UINT:
+		return 8;
+	case VK_FORMAT_R32G32B32A32_SFLOAT:
+		return 16;
+	default:
+		return 4;
+	}
+}
+
+void VFrameGraph::PassBuilder::read(ResourceId resource, Access access)
+{
+	graph.passes[pass].uses.push_back({ resource, access, false });
+}
+
+void VFrameGraph::PassBuilder::write(ResourceId resource, Access access)
+{
+	graph.passes[pass].uses.push_back({ resource, access, true });
+}
+
+void VFrameGraph::PassBuilder::sideEffect()
+{
+	graph.passes[pass].sideEffect = true;
+}
+
+VFrameGraph::VFrameGraph(VDevice* device) : vDevice{ device }
+{
+}
+
+VFrameGraph::~VFrameGraph()
+{
+	destroyTransients();
+}
+
+VFrameGraph::ResourceId VFrameGraph::createTexture(const std::string& name, const TextureDesc& desc)
+{
+	Resource resource{};
+	resource.name = name;
+	resource.desc = desc;
+	resources.push_back(resource);
+	compiled = false;
+	return static_cast<ResourceId>(resources.size() - 1);
+}
+
+VFrameGraph::ResourceId VFrameGraph::importImage(const std::string& name, const TextureDesc& desc, VkImageLayout initialLayout, Access finalAccess)
+{
+	Resource resource{};
+	resource.name = name;
+	resource.desc = desc;
+	resource.imported = true;
+	resource.initialLayout = initialLayout;
+	resource.finalAccess = finalAccess;
+	resources.push_back(resource);
+	compiled = false;
+	return static_cast<ResourceId>(resources.size() - 1);
+}
+
+void VFrameGraph::setImportedImage(ResourceId resource, VkImage image, VkImageView view)
+{
+	assert(resources[resource].imported && "only imported images can be swapped");
+	resources[resource].image = image;
+	resources[resource].view = view;
+}
+
+void VFrameGraph::addPass(const std::string& name, const std::function<void(PassBuilder&)>& setup, ExecuteFn execute)
+{
+	Pass pass{};
+	pass.name = name;
+	pass.execute = std::move(execute);
+	passes.push_back(std::move(pass));
+
+	PassBuilder builder{ *this, static_cast<uint32_t>(passes.size() - 1) };
+	setup(builder);
+	compiled = false;
+}
+
+void VFrameGraph::compile()
+{
+	destroyTransients();
+	stats = Stats{};
+
+	// walk backwards from what leaves the graph (imports, side effects): a pass lives if it writes
+	// something a live pass reads. once a resource is needed every earlier writer is kept, which is
+	// conservative for passes that fully overwrite but never drops a load
+	std::vector<bool> needed(resources.size(), false);
+	for (size_t r = 0; r < resources.size(); r++)
+	{
+		needed[r] = resources[r].imported;
+	}
+	for (size_t p = passes.size(); p-- > 0;)
+	{
+		Pass& pass = passes[p];
+		pass.alive = pass.sideEffect;
+		for (const ResourceUse& use : pass.uses)
+		{
+			if (use.write && needed[use.resource])
+			{
+				pass.alive = true;
+			}
+		}
+		if (!pass.alive)
+		{
+			continue;
+		}
+		for (const ResourceUse& use : pass.uses)
+		{
+			needed[use.resource] = true;
+		}
+	}
+
+	// declaration order is already a valid order, a pass can only read what earlier passes wrote
+	order.clear();
+	for (uint32_t p = 0; p < passes.size(); p++)
+	{
+		if (passes[p].alive)
+		{
+			order.push_back(p);
+		}
+	}
+	stats.passes = static_cast<uint32_t>(order.size());
+	stats.culledPasses = static_cast<uint32_t>(passes.size() - order.size());
+
+	planLifetimes();
+	createTransientImages();
+	planAliasing();
+	allocateTransientMemory();
+	planBarriers();
+	compiled = true;
+}
+
+void VFrameGraph::planLifetimes()
+{
+	for (Resource& resource : resources)
+	{
+		resource.firstUse = UINT32_MAX;
+		resource.lastUse = 0;
+		resource.usage = 0;
+		resource.aliases.clear();
+	}
+	for (uint32_t i = 0; i < order.size(); i++)
+	{
+		for (const ResourceUse& use : passes[order[i]].uses)
+		{
+			Resource& resource = resources[use.resource];
+			resource.firstUse = std::min(resource.firstUse, i);
+			resource.lastUse = std::max(resource.lastUse, i);
+			resource.usage |= accessInfo(use.access).usage;
+		}
+	}
+}
+
+void VFrameGraph::createTransientImages()
+{
+	for (Resource& resource : resources)
+	{
+		if (resource.imported || resource.firstUse == UINT32_MAX)
+		{
+			continue;
+		}
+		stats.transientImages++;
+
+		if (vDevice == nullptr)
+		{
+			// 64k is what most desktop drivers align optimal images to
+			resource.alignment = 64 * 1024;
+			resource.size = resource.desc.width * resource.desc.height * bytesPerPixel(resource.desc.format);
+			resource.size = (resource.size + resource.alignment - 1) / resource.alignment * resource.alignment;
+			resource.memoryTypeBits = 1;
+			continue;
+		}
+
+		VkImageCreateInfo imageInfo{};
+		imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+		imageInfo.imageType = VK_IMAGE_TYPE_2D;
+		imageInfo.extent = { resource.desc.width, resource.desc.height, 1 };
+		imageInfo.mipLevels = 1;
+		imageInfo.arrayLayers = 1;
+		imageInfo.format = resource.desc.format;
+		imageInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+		imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+		imageInfo.usage = resource.usage;
+		imageInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+		imageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+		// the memory is shared with other transients, so the contents never outlive the lifetime
+		imageInfo.flags = VK_IMAGE_CREATE_ALIAS_BIT;
+
+		if (vkCreateImage(vDevice->device(), &imageInfo, nullptr, &resource.image) != VK_SUCCESS)
+		{
+			throw std::runtime_error("failed to create frame graph image " + resource.name);
+		}
+
+		VkMemoryRequirements memRequirements;
+		vkGetImageMemoryRequirements(vDevice->device(), resource.image, &memRequirements);
+		resource.size = memRequirements.size;
+		resource.alignment = memRequirements.alignment;
+		resource.memoryTypeBits = memRequirements.memoryTypeBits;
+	}
+}
+
+void VFrameGraph::planAliasing()
+{
+	// one heap per memory type, transients only share memory with images that can live in it
+	heapMemoryTypes.clear();
+	std::vector<std::vector<ResourceId>> heapResources;
+	for (ResourceId r = 0; r < resources.size(); r++)
+	{
+		Resource& resource = resources[r];
+		if (resource.imported || resource.firstUse == UINT32_MAX)
+		{
+			continue;
+		}
+		stats.transientBytes += resource.size;
+
+		uint32_t memoryType = vDevice != nullptr ? vDevice->findMemoryType(resource.memoryTypeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT) : 0;
+		auto found = std::find(heapMemoryTypes.begin(), heapMemoryTypes.end(), memoryType);
+		resource.heap = static_cast<uint32_t>(found - heapMemoryTypes.begin());
+		if (found == heapMemoryTypes.end())
+		{
+			heapMemoryTypes.push_back(memoryType);
+			heapResources.emplace_back();
+		}
+		heapResources[resource.heap].push_back(r);
+	}
+
+	heapSizes.assign(heapResources.size(), 0);
+	for (uint32_t h = 0; h < heapResources.size(); h++)
+	{
+		// biggest first, each goes at the lowest offset that doesn't collide with anything placed
+		// whose lifetime overlaps its own
+		std::vector<ResourceId>& list = heapResources[h];
+		std::sort(list.begin(), list.end(), [this](ResourceId a, ResourceId b) { return resources[a].size > resources[b].size; });
+
+		std::vector<ResourceId> placed;
+		for (ResourceId r : list)
+		{
+			Resource& resource = resources[r];
+			auto livesWith = [&resource](const Resource& other) {
+				return other.firstUse <= resource.lastUse && resource.firstUse <= other.lastUse;
+			};
+
+			std::vector<VkDeviceSize> candidates{ 0 };
+			for (ResourceId p : placed)
+			{
+				if (livesWith(resources[p]))
+				{
+					candidates.push_back(resources[p].offset + resources[p].size);
+				}
+			}
+			std::sort(candidates.begin(), candidates.end());
+
+			VkDeviceSize offset = 0;
+			for (VkDeviceSize candidate : candidates)
+			{
+				offset = (candidate + resource.alignment - 1) / resource.alignment * resource.alignment;
+				bool collides = false;
+				for (ResourceId p : placed)
+				{
+					const Resource& other = resources[p];
+					if (livesWith(other) && offset < other.offset + other.size && other.offset < offset + resource.size)
+					{
+						collides = true;
+						break;
+					}
+				}
+				if (!collides)
+				{
+					break;
+				}
+			}
+			resource.offset = offset;
+			heapSizes[h] = std::max(heapSizes[h], offset + resource.size);
+			placed.push_back(r);
+		}
+
+		// whoever held the memory before has to be finished with it before the first use
+		for (ResourceId r : list)
+		{
+			Resource& resource = resources[r];
+			for (ResourceId p : list)
+			{
+				const Resource& other = resources[p];
+				if (p != r && other.lastUse < resource.firstUse && resource.offset < other.offset + other.size && other.offset < resource.offset + resource.size)
+				{
+					resource.aliases.push_back(p);
+				}
+			}
+		}
+		stats.aliasedBytes += heapSizes[h];
+	}
+}
+
+void VFrameGraph::allocateTransientMemory()
+{
+	if (vDevice == nullptr)
+	{
+		return;
+	}
+
+	heaps.assign(heapSizes.size(), VK_NULL_HANDLE);
+	for (uint32_t h = 0; h < heapSizes.size(); h++)
+	{
+		VkMemoryAllocateInfo allocInfo{};
+		allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+		allocInfo.allocationSize = heapSizes[h];
+		allocInfo.memoryTypeIndex = heapMemoryTypes[h];
+		if (vDevice->allocateMemory(allocInfo, heaps[h]) != VK_SUCCESS)
+		{
+			throw std::runtime_error("failed to allocate frame graph memory");
+		}
+	}
+
+	for (Resource& resource : resources)
+	{
+		if (resource.imported || resource.image == VK_NULL_HANDLE)
+		{
+			continue;
+		}
+		if (vkBindImageMemory(vDevice->device(), resource.image, heaps[resource.heap], resource.offset) != VK_SUCCESS)
+		{
+			throw std::runtime_error("failed to bind frame graph image " + resource.name);
+		}
+
+		VkImageViewCreateInfo viewInfo{};
+		viewInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+		viewInfo.image = resource.image;
+		viewInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
+		viewInfo.format = resource.desc.format;
+		viewInfo.subresourceRange.aspectMask = aspectFor(resource.desc.format);
+		viewInfo.subresourceRange.baseMipLevel = 0;
+		viewInfo.subresourceRange.levelCount = 1;
+		viewInfo.subresourceRange.baseArrayLayer = 0;
+		viewInfo.subresourceRange.layerCount = 1;
+		if (vkCreateImageView(vDevice->device(), &viewInfo, nullptr, &resource.view) != VK_SUCCESS)
+		{
+			throw std::runtime_error("failed to create frame graph image view " + resource.name);
+		}
+	}
+}
+
+void VFrameGraph::planBarriers()
+{
+	struct State {
+		VkImageLayout layout;
+		VkPipelineStageFlags stages;
+		VkAccessFlags access;
+		bool write;
+		bool touched;
+	};
+	std::vector<State> states(resources.size());
+	for (size_t r = 0; r < resources.size(); r++)
+	{
+		// imports arrive from outside the graph (a semaphore wait, another submit), so their first
+		// barrier waits on everything
+		states[r] = { resources[r].initialLayout, resources[r].imported ? VK_PIPELINE_STAGE_ALL_COMMANDS_BIT : VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, 0, false, resources[r].imported };
+	}
+
+	auto addBarrier = [this](BarrierBatch& batch, ResourceId r, VkImageLayout oldLayout, VkImageLayout newLayout, VkPipelineStageFlags srcStages, VkAccessFlags srcAccess, VkPipelineStageFlags dstStages, VkAccessFlags dstAccess) {
+		VkImageMemoryBarrier barrier{};
+		barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+		barrier.oldLayout = oldLayout;
+		barrier.newLayout = newLayout;
+		barrier.srcAccessMask = srcAccess;
+		barrier.dstAccessMask = dstAccess;
+		barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		barrier.subresourceRange.aspectMask = aspectFor(resources[r].desc.format);
+		barrier.subresourceRange.baseMipLevel = 0;
+		barrier.subresourceRange.levelCount = VK_REMAINING_MIP_LEVELS;
+		barrier.subresourceRange.baseArrayLayer = 0;
+		barrier.subresourceRange.layerCount = VK_REMAINING_ARRAY_LAYERS;
+		batch.barriers.push_back(barrier);
+		batch.barrierResources.push_back(r);
+		batch.srcStages |= srcStages;
+		batch.dstStages |= dstStages;
+	};
+
+	// where each transient's first barrier went, see below
+	struct FirstUse {
+		uint32_t batch;
+		size_t barrier;
+		ResourceId resource;
+	};
+	std::vector<FirstUse> firstUses;
+
+	barriers.assign(order.size() + 1, BarrierBatch{});
+	for (uint32_t i = 0; i < order.size(); i++)
+	{
+		BarrierBatch& batch = barriers[i];
+		for (const ResourceUse& use : passes[order[i]].uses)
+		{
+			AccessInfo info = accessInfo(use.access);
+			State& state = states[use.resource];
+
+			VkPipelineStageFlags srcStages;
+			VkAccessFlags srcAccess;
+			VkImageLayout oldLayout = state.layout;
+			if (!state.touched)
+			{
+				// first use of a transient, the contents are garbage so the old layout is undefined.
+				// if the memory was someone else's earlier this frame, wait on their last use
+				srcStages = 0;
+				srcAccess = 0;
+				for (ResourceId alias : resources[use.resource].aliases)
+				{
+					srcStages |= states[alias].stages;
+					srcAccess |= states[alias].write ? states[alias].access : 0;
+				}
+				oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+				firstUses.push_back({ i, batch.barriers.size(), use.resource });
+			}
+			else if (state.layout == info.layout && !state.write && !use.write)
+			{
+				// read after read in the same layout, nothing to wait for, later writers wait on both
+				state.stages |= info.stages;
+				state.access |= info.access;
+				continue;
+			}
+			else
+			{
+				srcStages = state.stages;
+				// only writes need making available, reads just need the execution dependency
+				srcAccess = state.write ? state.access : 0;
+			}
+
+			addBarrier(batch, use.resource, oldLayout, info.layout, srcStages != 0 ? srcStages : static_cast<VkPipelineStageFlags>(VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT), srcAccess, info.stages, info.access);
+			state = { info.layout, info.stages, info.access, use.write, true };
+		}
+	}
+
+	// the transients' memory is the same every frame and frames in flight overlap on the queue, so a
+	// first use also waits on the previous frame's last use of everything sharing its memory, itself
+	// included. states now holds exactly those last uses
+	for (const FirstUse& first : firstUses)
+	{
+		const Resource& resource = resources[first.resource];
+		BarrierBatch& batch = barriers[first.batch];
+		VkImageMemoryBarrier& barrier = batch.barriers[first.barrier];
+		for (ResourceId r = 0; r < resources.size(); r++)
+		{
+			const Resource& other = resources[r];
+			if (other.imported || other.firstUse == UINT32_MAX || other.heap != resource.heap ||
+				resource.offset >= other.offset + other.size || other.offset >= resource.offset + resource.size)
+			{
+				continue;
+			}
+			batch.srcStages |= states[r].stages;
+			barrier.srcAccessMask |= states[r].write ? states[r].access : 0;
+		}
+	}
+
+	BarrierBatch& last = barriers[order.size()];
+	for (ResourceId r = 0; r < resources.size(); r++)
+	{
+		const Resource& resource = resources[r];
+		if (!resource.imported)
+		{
+			continue;
+		}
+		AccessInfo info = accessInfo(resource.finalAccess);
+		const State& state = states[r];
+		// anything past a layout change is synchronized outside the graph (semaphores, fences)
+		if (state.layout != info.layout)
+		{
+			addBarrier(last, r, state.layout, info.layout, state.stages, state.write ? state.access : 0, info.stages, info.access);
+		}
+	}
+
+	for (const BarrierBatch& batch : barriers)
+	{
+		stats.barriers += static_cast<uint32_t>(batch.barriers.size());
+		stats.barrierBatches += batch.barriers.empty() ? 0 : 1;
+	}
+}
+
+void VFrameGraph::execute(VkCommandBuffer commandBuffer)
+{
+	assert(vDevice != nullptr && "a planning only frame graph can't execute");
+	if (!compiled)
+	{
+		compile();
+	}
+
+	auto recordBatch = [this, commandBuffer](BarrierBatch& batch) {
+		if (batch.barriers.empty())
+		{
+			return;
+		}
+		for (size_t b = 0; b < batch.barriers.size(); b++)
+		{
+			batch.barriers[b].image = resources[batch.barrierResources[b]].image;
+		}
+		vkCmdPipelineBarrier(commandBuffer, batch.srcStages, batch.dstStages, 0, 0, nullptr, 0, nullptr,
+			static_cast<uint32_t>(batch.barriers.size()), batch.barriers.data());
+	};
+
+	for (uint32_t i = 0; i < order.size(); i++)
+	{
+		recordBatch(barriers[i]);
+		const Pass& pass = passes[order[i]];
+		if (pass.execute)
+		{
+			pass.execute(commandBuffer, *this);
+		}
+	}
+	recordBatch(barriers[order.size()]);
+}
+
+std::vector<std::string> VFrameGraph::getPassOrder() const
+{
+	std::vector<std::string> names;
+	for (uint32_t p : order)
+	{
+		names.push_back(passes[p].name);
+	}
+	return names;
+}
+
+void VFrameGraph::reset()
+{
+	destroyTransients();
+	passes.clear();
+	resources.clear();
+	order.clear();
+	barriers.clear();
+	stats = Stats{};
+	compiled = false;
+}
+
+void VFrameGraph::destroyTransients()
+{
+	if (vDevice != nullptr)
+	{
+		for (Resource& resource : resources)
+		{
+			if (resource.imported)
+			{
+				continue;
+			}
+			vkDestroyImageView(vDevice->device(), resource.view, nullptr);
+			vkDestroyImage(vDevice->device(), resource.image, nullptr);
+			resource.view = VK_NULL_HANDLE;
+			resource.image = VK_NULL_HANDLE;
+		}
+		for (VkDeviceMemory heap : heaps)
+		{
+			vDevice->freeMemory(heap);
+		}
+	}
+	heaps.clear();
+}
+
+}
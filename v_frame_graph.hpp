@@ -0,0 +1,167 @@
+#pragma once
+
+#include "VDevice.hpp"
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace vwdw {
+
+	// declarative frame graph. passes say which images they read and write, compile() drops passes
+	// nothing consumes, plans every layout transition / barrier up front and packs transient images
+	// whose lifetimes don't overlap into the same memory. build and compile once (again on resize),
+	// then execute() every frame
+	class VFrameGraph {
+	public:
+		using ResourceId = uint32_t;
+		static constexpr ResourceId INVALID_RESOURCE = 0xFFFFFFFF;
+
+		// how a pass touches an image, decides the layout, stages and access masks of its barriers
+		enum class Access {
+			ColorAttachment,
+			DepthAttachment,
+			DepthRead,
+			Sampled,
+			StorageRead,
+			StorageWrite,
+			TransferSrc,
+			TransferDst,
+			Present,
+		};
+
+		struct TextureDesc {
+			uint32_t width = 0;
+			uint32_t height = 0;
+			VkFormat format = VK_FORMAT_UNDEFINED;
+		};
+
+		struct Stats {
+			uint32_t passes = 0;
+			uint32_t culledPasses = 0;
+			uint32_t transientImages = 0;
+			// image barriers per execute(), and the vkCmdPipelineBarrier calls they're batched into
+			uint32_t barriers = 0;
+			uint32_t barrierBatches = 0;
+			// transient memory if every image had its own allocation vs. after aliasing
+			VkDeviceSize transientBytes = 0;
+			VkDeviceSize aliasedBytes = 0;
+		};
+
+		class PassBuilder {
+		public:
+			void read(ResourceId resource, Access access);
+			void write(ResourceId resource, Access access);
+			// keeps the pass even if nothing reads what it writes (readbacks, queries...)
+			void sideEffect();
+
+		private:
+			friend class VFrameGraph;
+			PassBuilder(VFrameGraph& graph, uint32_t pass) : graph{ graph }, pass{ pass } {}
+
+			VFrameGraph& graph;
+			uint32_t pass;
+		};
+
+		// resources are already in the layout the pass declared and must be left in it, so passes using
+		// a VkRenderPass need initialLayout == finalLayout == that layout
+		using ExecuteFn = std::function<void(VkCommandBuffer commandBuffer, const VFrameGraph& graph)>;
+
+		// without a device the graph only plans: sizes are estimated from the format, nothing is
+		// allocated and execute() can't be called. used by the benchmark
+		explicit VFrameGraph(VDevice* device);
+		~VFrameGraph();
+
+		VFrameGraph(const VFrameGraph&) = delete;
+		VFrameGraph& operator=(const VFrameGraph&) = delete;
+
+		ResourceId createTexture(const std::string& name, const TextureDesc& desc);
+		// an image owned elsewhere (the swapchain image...), left in finalAccess's layout after execute()
+		ResourceId importImage(const std::string& name, const TextureDesc& desc, VkImageLayout initialLayout, Access finalAccess);
+		// swaps the image behind an import, no recompile needed as long as the desc is the same
+		void setImportedImage(ResourceId resource, VkImage image, VkImageView view);
+
+		void addPass(const std::string& name, const std::function<void(PassBuilder&)>& setup, ExecuteFn execute);
+
+		void compile();
+		void execute(VkCommandBuffer commandBuffer);
+		// drops every pass and resource and frees the transient memory
+		void reset();
+
+		VkImage getImage(ResourceId resource) const { return resources[resource].image; }
+		VkImageView getImageView(ResourceId resource) const { return resources[resource].view; }
+		const TextureDesc& getDesc(ResourceId resource) const { return resources[resource].desc; }
+		const Stats& getStats() const { return stats; }
+		// pass names in recording order, culled passes left out
+		std::vector<std::string> getPassOrder() const;
+
+	private:
+		struct ResourceUse {
+			ResourceId resource;
+			Access access;
+			bool write;
+		};
+
+		struct Pass {
+			std::string name;
+			std::vector<ResourceUse> uses;
+			ExecuteFn execute;
+			bool sideEffect = false;
+			bool alive = false;
+		};
+
+		struct Resource {
+			std::string name;
+			TextureDesc desc;
+			bool imported = false;
+			VkImageLayout initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+			Access finalAccess = Access::Sampled;
+			VkImageUsageFlags usage = 0;
+
+			// execution order indices of the first / last alive pass using it
+			uint32_t firstUse = UINT32_MAX;
+			uint32_t lastUse = 0;
+
+			VkImage image = VK_NULL_HANDLE;
+			VkImageView view = VK_NULL_HANDLE;
+			uint32_t heap = 0;
+			VkDeviceSize offset = 0;
+			VkDeviceSize size = 0;
+			VkDeviceSize alignment = 1;
+			uint32_t memoryTypeBits = ~0u;
+			// transients that had this memory before, the first use waits on them
+			std::vector<ResourceId> aliases;
+		};
+
+		// one planned vkCmdPipelineBarrier, images are filled in at execute() since imports can change
+		struct BarrierBatch {
+			VkPipelineStageFlags srcStages = 0;
+			VkPipelineStageFlags dstStages = 0;
+			std::vector<VkImageMemoryBarrier> barriers;
+			std::vector<ResourceId> barrierResources;
+		};
+
+		void planLifetimes();
+		void createTransientImages();
+		void planAliasing();
+		void allocateTransientMemory();
+		void planBarriers();
+		void destroyTransients();
+
+		VDevice* vDevice;
+		std::vector<Pass> passes;
+		std::vector<Resource> resources;
+		// alive passes in recording order
+		std::vector<uint32_t> order;
+		// barriers[i] goes before order[i], the last entry transitions imports to their final layout
+		std::vector<BarrierBatch> barriers;
+		// one allocation per memory type the transients need
+		std::vector<VkDeviceMemory> heaps;
+		std::vector<VkDeviceSize> heapSizes;
+		std::vector<uint32_t> heapMemoryTypes;
+		Stats stats;
+		bool compiled = false;
+	};
+
+}
@@ -0,0 +1,209 @@
+#pragma once
+
+#include <cassert>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+namespace vwdw {
+
+	// 32 bit reference into a VHandlePool<T>: slot index in the low bits, the slot's generation in
+	// the high bits. typed, so a mesh handle can't be passed where a pipeline is expected
+	template <typename T>
+	class VHandle {
+	public:
+		static constexpr uint32_t INDEX_BITS = 20;
+		static constexpr uint32_t GENERATION_BITS = 32 - INDEX_BITS;
+		static constexpr uint32_t INDEX_MASK = (1u << INDEX_BITS) - 1;
+		static constexpr uint32_t MAX_GENERATION = (1u << GENERATION_BITS) - 1;
+		// the all ones index is never handed out, so no real handle equals the invalid one
+		static constexpr uint32_t MAX_INDEX = INDEX_MASK - 1;
+
+		constexpr VHandle() = default;
+		constexpr VHandle(uint32_t index, uint32_t generation) : value{ (generation << INDEX_BITS) | (index & INDEX_MASK) } {}
+
+		uint32_t index() const { return value & INDEX_MASK; }
+		uint32_t generation() const { return value >> INDEX_BITS; }
+		uint32_t raw() const { return value; }
+		bool isValid() const { return value != INVALID; }
+
+		static constexpr VHandle fromRaw(uint32_t raw) { VHandle handle; handle.value = raw; return handle; }
+
+		bool operator==(VHandle other) const { return value == other.value; }
+		bool operator!=(VHandle other) const { return value != other.value; }
+
+	private:
+		static constexpr uint32_t INVALID = 0xFFFFFFFF;
+		uint32_t value = INVALID;
+	};
+
+	// owns objects of one type in fixed size chunks. objects are built in place and never move, so
+	// they don't have to be movable and pointers from get() stay good until release(). next to the
+	// chunks is a dense array holding each slot's live handle, so checking a handle is one compare
+	// against 4 bytes that stay in cache, and only a live one touches the object. released slots are
+	// reused newest first (still warm) with their generation bumped, which is what makes every old
+	// handle to them stale. a slot whose generation runs out is retired for good instead of wrapping,
+	// so a stale handle can never come back to life. not thread safe
+	template <typename T>
+	class VHandlePool {
+	public:
+		using Handle = VHandle<T>;
+
+		static constexpr uint32_t CHUNK_SIZE = 64;
+
+		VHandlePool() = default;
+		~VHandlePool()
+		{
+			for (uint32_t i = 0; i < slotCount(); i++)
+			{
+				if (isLive(i))
+				{
+					object(i)->~T();
+				}
+			}
+		}
+
+		VHandlePool(const VHandlePool&) = delete;
+		VHandlePool& operator=(const VHandlePool&) = delete;
+
+		template <typename... Args>
+		Handle emplace(Args&&... args)
+		{
+			uint32_t index;
+			if (!freeList.empty())
+			{
+				index = freeList.back();
+				freeList.pop_back();
+			}
+			else
+			{
+				if (slotCount() > Handle::MAX_INDEX)
+				{
+					throw std::runtime_error("handle pool is full");
+				}
+				if (slotCount() % CHUNK_SIZE == 0)
+				{
+					chunks.push_back(std::make_unique<Slot[]>(CHUNK_SIZE));
+				}
+				index = slotCount();
+				live.push_back(deadHandle(0));
+			}
+
+			try
+			{
+				new (object(index)) T(std::forward<Args>(args)...);
+			}
+			catch (...)
+			{
+				// nothing was handed out, the slot goes back as it was
+				freeList.push_back(index);
+				throw;
+			}
+			Handle handle{ index, Handle::fromRaw(live[index]).generation() };
+			live[index] = handle.raw();
+			count++;
+			return handle;
+		}
+
+		// destroys the object, every copy of handle is stale from here on
+		void release(Handle handle)
+		{
+			if (!contains(handle))
+			{
+				assert(false && "releasing a stale handle");
+				return;
+			}
+			uint32_t index = handle.index();
+			object(index)->~T();
+			count--;
+			if (handle.generation() < Handle::MAX_GENERATION)
+			{
+				live[index] = deadHandle(handle.generation() + 1);
+				freeList.push_back(index);
+			}
+			else
+			{
+				live[index] = deadHandle(handle.generation());
+			}
+		}
+
+		// the invalid handle's index is past any slot, so it needs no check of its own
+		bool contains(Handle handle) const { return handle.index() < slotCount() && live[handle.index()] == handle.raw(); }
+
+		// null for stale or invalid handles
+		T* get(Handle handle) { return contains(handle) ? object(handle.index()) : nullptr; }
+		const T* get(Handle handle) const { return contains(handle) ? object(handle.index()) : nullptr; }
+
+		// for handles the caller knows are live, the check is only an assert
+		T& operator[](Handle handle)
+		{
+			assert(contains(handle) && "stale handle");
+			return *object(handle.index());
+		}
+		const T& operator[](Handle handle) const
+		{
+			assert(contains(handle) && "stale handle");
+			return *object(handle.index());
+		}
+
+		void clear()
+		{
+			for (uint32_t i = 0; i < slotCount(); i++)
+			{
+				if (isLive(i))
+				{
+					release(Handle::fromRaw(live[i]));
+				}
+			}
+		}
+
+		// fn(Handle, T&) for every live object, in slot order
+		template <typename F>
+		void forEach(F&& fn)
+		{
+			for (uint32_t i = 0; i < slotCount(); i++)
+			{
+				if (isLive(i))
+				{
+					fn(Handle::fromRaw(live[i]), *object(i));
+				}
+			}
+		}
+
+		uint32_t size() const { return count; }
+		bool empty() const { return count == 0; }
+
+	private:
+		struct Slot {
+			alignas(T) unsigned char storage[sizeof(T)];
+		};
+
+		// a free slot keeps the generation its next object gets, under an index no live handle has
+		static uint32_t deadHandle(uint32_t generation) { return Handle{ Handle::INDEX_MASK, generation }.raw(); }
+
+		uint32_t slotCount() const { return static_cast<uint32_t>(live.size()); }
+		bool isLive(uint32_t index) const { return Handle::fromRaw(live[index]).index() == index; }
+		T* object(uint32_t index) { return std::launder(reinterpret_cast<T*>(chunks[index / CHUNK_SIZE][index % CHUNK_SIZE].storage)); }
+		const T* object(uint32_t index) const { return std::launder(reinterpret_cast<const T*>(chunks[index / CHUNK_SIZE][index % CHUNK_SIZE].storage)); }
+
+		std::vector<std::unique_ptr<Slot[]>> chunks;
+		// by slot: the live handle, or deadHandle()
+		std::vector<uint32_t> live;
+		std::vector<uint32_t> freeList;
+		uint32_t count = 0;
+	};
+
+	class VModel;
+	class VwdwPipeline;
+	class VTexture;
+	class VBuffer;
+
+	using VMeshHandle = VHandle<VModel>;
+	using VPipelineHandle = VHandle<VwdwPipeline>;
+	using VImageHandle = VHandle<VTexture>;
+	using VBufferHandle = VHandle<VBuffer>;
+
+}
@@ -0,0 +1,707 @@
+#include "v_image.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cctype>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+namespace vwdw {
+
+static bool decodeTga(const std::vector<uint8_t>& file, VImageData& image, std::string& error)
+{
+	if (file.size() < 18)
+	{
+		error = "truncated tga header";
+		return false;
+	}
+
+	uint8_t idLength = file[0];
+	uint8_t colorMapType = file[1];
+	uint8_t imageType = file[2];
+	uint32_t width = file[12] | (file[13] << 8);
+	uint32_t height = file[14] | (file[15] << 8);
+	uint8_t bitsPerPixel = file[16];
+	bool topLeft = (file[17] & 0x20) != 0;
+
+	bool rle = imageType == 10 || imageType == 11;
+	bool gray = imageType == 3 || imageType == 11;
+	if (colorMapType != 0 || !(imageType == 2 || imageType == 3 || rle))
+	{
+		error = "unsupported tga type";
+		return false;
+	}
+	if ((gray && bitsPerPixel != 8) || (!gray && bitsPerPixel != 24 && bitsPerPixel != 32) || width == 0 || height == 0)
+	{
+		error = "unsupported tga pixel format";
+		return false;
+	}
+
+	uint32_t bytesPerPixel = bitsPerPixel / 8;
+	size_t pos = 18 + idLength;
+	size_t pixelCount = static_cast<size_t>(width) * height;
+	std::vector<uint8_t> raw(pixelCount * bytesPerPixel);
+
+	if (rle)
+	{
+		size_t out = 0;
+		while (out < raw.size())
+		{
+			if (pos >= file.size())
+			{
+				error = "truncated tga rle data";
+				return false;
+			}
+			uint8_t packet = file[pos++];
+			size_t run = (packet & 0x7F) + 1;
+			if (out + run * bytesPerPixel > raw.size())
+			{
+				error = "tga rle run past the end of the image";
+				return false;
+			}
+			if (packet & 0x80)
+			{
+				if (pos + bytesPerPixel > file.size())
+				{
+					error = "truncated tga rle data";
+					return false;
+				}
+				for (size_t i = 0; i < run; i++)
+				{
+					std::copy(file.begin() + pos, file.begin() + pos + bytesPerPixel, raw.begin() + out);
+					out += bytesPerPixel;
+				}
+				pos += bytesPerPixel;
+			}
+			else
+			{
+				size_t bytes = run * bytesPerPixel;
+				if (pos + bytes > file.size())
+				{
+					error = "truncated tga rle data";
+					return false;
+				}
+				std::copy(file.begin() + pos, file.begin() + pos + bytes, raw.begin() + out);
+				out += bytes;
+				pos += bytes;
+			}
+		}
+	}
+	else
+	{
+		if (pos + raw.size() > file.size())
+		{
+			error = "truncated tga pixel data";
+			return false;
+		}
+		std::copy(file.begin() + pos, file.begin() + pos + raw.size(), raw.begin());
+	}
+
+	// bgr(a), bottom up unless the descriptor says otherwise
+	image.width = width;
+	image.height = height;
+	image.pixels.resize(pixelCount * 4);
+	for (uint32_t y = 0; y < height; y++)
+	{
+		uint32_t srcRow = topLeft ? y : height - 1 - y;
+		const uint8_t* src = raw.data() + static_cast<size_t>(srcRow) * width * bytesPerPixel;
+		uint8_t* dst = image.pixels.data() + static_cast<size_t>(y) * width * 4;
+		for (uint32_t x = 0; x < width; x++, src += bytesPerPixel, dst += 4)
+		{
+			if (gray)
+			{
+				dst[0] = dst[1] = dst[2] = src[0];
+				dst[3] = 255;
+			}
+			else
+			{
+				dst[0] = src[2];
+				dst[1] = src[1];
+				dst[2] = src[0];
+				dst[3] = bytesPerPixel == 4 ? src[3] : 255;
+			}
+		}
+	}
+	return true;
+}
+
+static bool readPpmNumber(const std::vector<uint8_t>& file, size_t& pos, uint32_t& value)
+{
+	// whitespace and # comments can sit between header fields
+	while (pos < file.size())
+	{
+		if (file[pos] == '#')
+		{
+			while (pos < file.size() && file[pos] != '\n')
+			{
+				pos++;
+			}
+		}
+		else if (std::isspace(file[pos]))
+		{
+			pos++;
+		}
+		else
+		{
+			break;
+		}
+	}
+
+	if (pos >= file.size() || !std::isdigit(file[pos]))
+	{
+		return false;
+	}
+	value = 0;
+	while (pos < file.size() && std::isdigit(file[pos]))
+	{
+		value = value * 10 + (file[pos++] - '0');
+	}
+	return true;
+}
+
+static bool decodePpm(const std::vector<uint8_t>& file, VImageData& image, std::string& error)
+{
+	size_t pos = 2;
+	uint32_t width, height, maxValue;
+	if (!readPpmNumber(file, pos, width) || !readPpmNumber(file, pos, height) || !readPpmNumber(file, pos, maxValue))
+	{
+		error = "malformed ppm header";
+		return false;
+	}
+	if (maxValue != 255 || width == 0 || height == 0)
+	{
+		error = "only 8 bit ppm is supported";
+		return false;
+	}
+	// exactly one whitespace byte separates the header from the pixels
+	pos++;
+
+	size_t pixelCount = static_cast<size_t>(width) * height;
+	if (pos + pixelCount * 3 > file.size())
+	{
+		error = "truncated ppm pixel data";
+		return false;
+	}
+
+	image.width = width;
+	image.height = height;
+	image.pixels.resize(pixelCount * 4);
+	const uint8_t* src = file.data() + pos;
+	uint8_t* dst = image.pixels.data();
+	for (size_t i = 0; i < pixelCount; i++, src += 3, dst += 4)
+	{
+		dst[0] = src[0];
+		dst[1] = src[1];
+		dst[2] = src[2];
+		dst[3] = 255;
+	}
+	return true;
+}
+
+bool decodeImage(const std::vector<uint8_t>& file, VImageData& image, std::string& error)
+{
+	if (file.size() >= 2 && file[0] == 'P' && file[1] == '6')
+	{
+		return decodePpm(file, image, error);
+	}
+	// tga has no magic number, its header gets validated instead
+	return decodeTga(file, image, error);
+}
+
+bool loadImageFile(const std::string& path, VImageData& image, std::string& error)
+{
+	std::ifstream file{ path, std::ios::binary };
+	if (!file.is_open())
+	{
+		error = "failed to open file: " + path;
+		return false;
+	}
+	std::vector<uint8_t> bytes((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+	if (!decodeImage(bytes, image, error))
+	{
+		error = path + ": " + error;
+		return false;
+	}
+	return true;
+}
+
+void downsampleImage(const VImageData& src, VImageData& dst)
+{
+	dst.width = src.width > 1 ? src.width / 2 : 1;
+	dst.height = src.height > 1 ? src.height / 2 : 1;
+	dst.pixels.resize(static_cast<size_t>(dst.width) * dst.height * 4);
+
+	for (uint32_t y = 0; y < dst.height; y++)
+	{
+		uint32_t y0 = y * 2 < src.height ? y * 2 : src.height - 1;
+		uint32_t y1 = y0 + 1 < src.height ? y0 + 1 : y0;
+		for (uint32_t x = 0; x < dst.width; x++)
+		{
+			uint32_t x0 = x * 2 < src.width ? x * 2 : src.width - 1;
+			uint32_t x1 = x0 + 1 < src.width ? x0 + 1 : x0;
+			const uint8_t* a = &src.pixels[(static_cast<size_t>(y0) * src.width + x0) * 4];
+			const uint8_t* b = &src.pixels[(static_cast<size_t>(y0) * src.width + x1) * 4];
+			const uint8_t* c = &src.pixels[(static_cast<size_t>(y1) * src.width + x0) * 4];
+			const uint8_t* d = &src.pixels[(static_cast<size_t>(y1) * src.width + x1) * 4];
+			uint8_t* out = &dst.pixels[(static_cast<size_t>(y) * dst.width + x) * 4];
+			for (int ch = 0; ch < 4; ch++)
+			{
+				out[ch] = static_cast<uint8_t>((a[ch] + b[ch] + c[ch] + d[ch] + 2) / 4);
+			}
+		}
+	}
+}
+
+static uint16_t packRgb565(const int c[3])
+{
+	return static_cast<uint16_t>(((c[0] * 31 + 127) / 255) << 11 | ((c[1] * 63 + 127) / 255) << 5 | ((c[2] * 31 + 127) / 255));
+}
+
+static void unpackRgb565(uint16_t v, int c[3])
+{
+	int r = (v >> 11) & 31;
+	int g = (v >> 5) & 63;
+	int b = v & 31;
+	c[0] = (r << 3) | (r >> 2);
+	c[1] = (g << 2) | (g >> 4);
+	c[2] = (b << 3) | (b >> 2);
+}
+
+static void compressBlockBC1(const uint8_t texels[16][4], uint8_t out[8])
+{
+	// endpoints are the two texels furthest apart along the block's bounding box diagonal
+	int lo[3] = { 255, 255, 255 };
+	int hi[3] = { 0, 0, 0 };
+	for (int i = 0; i < 16; i++)
+	{
+		for (int ch = 0; ch < 3; ch++)
+		{
+			lo[ch] = texels[i][ch] < lo[ch] ? texels[i][ch] : lo[ch];
+			hi[ch] = texels[i][ch] > hi[ch] ? texels[i][ch] : hi[ch];
+		}
+	}
+	int axis[3] = { hi[0] - lo[0], hi[1] - lo[1], hi[2] - lo[2] };
+	int minProj = 0x7FFFFFFF, maxProj = -0x7FFFFFFF;
+	int minIndex = 0, maxIndex = 0;
+	for (int i = 0; i < 16; i++)
+	{
+		int proj = texels[i][0] * axis[0] + texels[i][1] * axis[1] + texels[i][2] * axis[2];
+		if (proj < minProj)
+		{
+			minProj = proj;
+			minIndex = i;
+		}
+		if (proj > maxProj)
+		{
+			maxProj = proj;
+			maxIndex = i;
+		}
+	}
+
+	int c0[3] = { texels[maxIndex][0], texels[maxIndex][1], texels[maxIndex][2] };
+	int c1[3] = { texels[minIndex][0], texels[minIndex][1], texels[minIndex][2] };
+	uint16_t e0 = packRgb565(c0);
+	uint16_t e1 = packRgb565(c1);
+	// four colour mode needs e0 > e1
+	if (e0 < e1)
+	{
+		uint16_t tmp = e0;
+		e0 = e1;
+		e1 = tmp;
+	}
+
+	uint32_t indices = 0;
+	if (e0 != e1)
+	{
+		int palette[4][3];
+		unpackRgb565(e0, palette[0]);
+		unpackRgb565(e1, palette[1]);
+		for (int ch = 0; ch < 3; ch++)
+		{
+			palette[2][ch] = (2 * palette[0][ch] + palette[1][ch]) / 3;
+			palette[3][ch] = (palette[0][ch] + 2 * palette[1][ch]) / 3;
+		}
+		for (int i = 0; i < 16; i++)
+		{
+			int best = 0;
+			int bestDistance = 0x7FFFFFFF;
+			for (int p = 0; p < 4; p++)
+			{
+				int dr = texels[i][0] - palette[p][0];
+				int dg = texels[i][1] - palette[p][1];
+				int db = texels[i][2] - palette[p][2];
+				int distance = dr * dr + dg * dg + db * db;
+				if (distance < bestDistance)
+				{
+					bestDistance = distance;
+					best = p;
+				}
+			}
+			indices |= static_cast<uint32_t>(best) << (i * 2);
+		}
+	}
+
+	out[0] = static_cast<uint8_t>(e0 & 0xFF);
+	out[1] = static_cast<uint8_t>(e0 >> 8);
+	out[2] = static_cast<uint8_t>(e1 & 0xFF);
+	out[3] = static_cast<uint8_t>(e1 >> 8);
+	out[4] = static_cast<uint8_t>(indices & 0xFF);
+	out[5] = static_cast<uint8_t>((indices >> 8) & 0xFF);
+	out[6] = static_cast<uint8_t>((indices >> 16) & 0xFF);
+	out[7] = static_cast<uint8_t>(indices >> 24);
+}
+
+void compressBC1(const VImageData& image, std::vector<uint8_t>& blocks)
+{
+	uint32_t blocksX = (image.width + 3) / 4;
+	uint32_t blocksY = (image.height + 3) / 4;
+	blocks.resize(static_cast<size_t>(blocksX) * blocksY * 8);
+
+	uint8_t texels[16][4];
+	for (uint32_t by = 0; by < blocksY; by++)
+	{
+		for (uint32_t bx = 0; bx < blocksX; bx++)
+		{
+			for (uint32_t i = 0; i < 16; i++)
+			{
+				uint32_t x = bx * 4 + (i & 3);
+				uint32_t y = by * 4 + (i >> 2);
+				x = x < image.width ? x : image.width - 1;
+				y = y < image.height ? y : image.height - 1;
+				std::memcpy(texels[i], &image.pixels[(static_cast<size_t>(y) * image.width + x) * 4], 4);
+			}
+			compressBlockBC1(texels, &blocks[(static_cast<size_t>(by) * blocksX + bx) * 8]);
+		}
+	}
+}
+
+// deflate with the fixed huffman codes and a single probe hash match finder, the speed of zlib's
+// lowest levels without building trees. codes go out lsb first, so every huffman code is stored bit reversed
+struct FixedCodes {
+	uint16_t literal[288];
+	uint8_t literalBits[288];
+	uint8_t distance[30];
+	// by match length 3..258
+	uint16_t lengthSymbol[259];
+
+	static uint32_t reverse(uint32_t code, uint32_t bits)
+	{
+		uint32_t reversed = 0;
+		for (uint32_t i = 0; i < bits; i++)
+		{
+			reversed = (reversed << 1) | ((code >> i) & 1);
+		}
+		return reversed;
+	}
+
+	FixedCodes()
+	{
+		for (uint32_t s = 0; s < 288; s++)
+		{
+			uint32_t code, bits;
+			if (s < 144) { code = 0x30 + s; bits = 8; }
+			else if (s < 256) { code = 0x190 + s - 144; bits = 9; }
+			else if (s < 280) { code = s - 256; bits = 7; }
+			else { code = 0xC0 + s - 280; bits = 8; }
+			literal[s] = static_cast<uint16_t>(reverse(code, bits));
+			literalBits[s] = static_cast<uint8_t>(bits);
+		}
+		for (uint32_t s = 0; s < 30; s++)
+		{
+			distance[s] = static_cast<uint8_t>(reverse(s, 5));
+		}
+		for (uint32_t s = 0; s < 29; s++)
+		{
+			for (uint32_t length = LENGTH_BASE[s]; length < (s + 1 < 29 ? LENGTH_BASE[s + 1] : 259u); length++)
+			{
+				lengthSymbol[length] = static_cast<uint16_t>(s);
+			}
+		}
+	}
+
+	static constexpr uint16_t LENGTH_BASE[29] = { 3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31, 35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258 };
+	static constexpr uint8_t LENGTH_EXTRA[29] = { 0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0 };
+	static constexpr uint16_t DISTANCE_BASE[30] = { 1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193, 257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577 };
+};
+
+// writes into room reserved up front, deflate's worst case is known
+class BitWriter {
+public:
+	BitWriter(std::vector<uint8_t>& out, size_t maxBytes) : out{ out }, start{ out.size() }
+	{
+		// the stores below can run up to 7 bytes past the last one kept. the bit buffer is copied out as
+		// it sits in memory, which is the stream's byte order on the little endian targets we build for
+		out.resize(start + maxBytes + 8);
+		next = out.data() + start;
+	}
+
+	void put(uint32_t bits, uint32_t count)
+	{
+		buffer |= static_cast<uint64_t>(bits) << used;
+		used += count;
+		if (used >= 32)
+		{
+			std::memcpy(next, &buffer, 4);
+			next += 4;
+			buffer >>= 32;
+			used -= 32;
+		}
+	}
+
+	void finish()
+	{
+		std::memcpy(next, &buffer, 8);
+		next += (used + 7) / 8;
+		out.resize(static_cast<size_t>(next - out.data()));
+	}
+
+private:
+	std::vector<uint8_t>& out;
+	size_t start;
+	uint8_t* next;
+	uint64_t buffer = 0;
+	uint32_t used = 0;
+};
+
+static uint32_t countTrailingZeros(uint64_t v)
+{
+#ifdef _MSC_VER
+	unsigned long index;
+	_BitScanForward64(&index, v);
+	return static_cast<uint32_t>(index);
+#else
+	return static_cast<uint32_t>(__builtin_ctzll(v));
+#endif
+}
+
+static void deflateFixed(const uint8_t* data, size_t size, std::vector<uint8_t>& out)
+{
+	static const FixedCodes codes;
+	constexpr uint32_t HASH_BITS = 15;
+	constexpr size_t WINDOW = 32768;
+	constexpr size_t MIN_MATCH = 4;
+	constexpr size_t MAX_MATCH = 258;
+	constexpr size_t SHORT_MATCH = 32;
+
+	// 9 bits for the widest literal, and no match is longer than the bytes it covers
+	BitWriter bits{ out, size * 9 / 8 + 16 };
+	// one final block with the fixed codes
+	bits.put(1, 1);
+	bits.put(1, 2);
+
+	auto load = [&](size_t i) {
+		uint32_t v;
+		std::memcpy(&v, data + i, 4);
+		return v;
+	};
+	auto hashOf = [](uint32_t v) { return (v * 2654435761u) >> (32 - HASH_BITS); };
+	auto literal = [&](uint8_t value) { bits.put(codes.literal[value], codes.literalBits[value]); };
+
+	std::vector<int32_t> head(size_t(1) << HASH_BITS, -1);
+	size_t i = 0;
+	size_t misses = 0;
+	while (i + MIN_MATCH <= size)
+	{
+		uint32_t bytes = load(i);
+		uint32_t h = hashOf(bytes);
+		int64_t candidate = head[h];
+		head[h] = static_cast<int32_t>(i);
+		size_t distance = i - static_cast<size_t>(candidate);
+		if (candidate < 0 || distance > WINDOW || load(static_cast<size_t>(candidate)) != bytes)
+		{
+			// noisy stretches find nothing, the longer the misses go on the fewer positions are tried
+			size_t step = 1 + (misses++ >> 5);
+			for (size_t k = 0; k < step && i < size; k++)
+			{
+				literal(data[i++]);
+			}
+			continue;
+		}
+		misses = 0;
+
+		// eight bytes at a time, the first differing byte is the lowest set bit of the xor
+		size_t limit = std::min(MAX_MATCH, size - i);
+		size_t length = MIN_MATCH;
+		while (length + 8 <= limit)
+		{
+			uint64_t x, y;
+			std::memcpy(&x, data + candidate + length, 8);
+			std::memcpy(&y, data + i + length, 8);
+			if (x != y)
+			{
+				length += countTrailingZeros(x ^ y) / 8;
+				break;
+			}
+			length += 8;
+		}
+		if (length + 8 > limit)
+		{
+			while (length < limit && data[candidate + length] == data[i + length])
+			{
+				length++;
+			}
+		}
+
+		uint32_t ls = codes.lengthSymbol[length];
+		bits.put(codes.literal[257 + ls], codes.literalBits[257 + ls]);
+		bits.put(static_cast<uint32_t>(length - FixedCodes::LENGTH_BASE[ls]), FixedCodes::LENGTH_EXTRA[ls]);
+
+		uint32_t ds;
+		uint32_t v = static_cast<uint32_t>(distance - 1);
+		if (v < 4)
+		{
+			ds = v;
+		}
+		else
+		{
+			uint32_t top = 31;
+			while ((v >> top) == 0)
+			{
+				top--;
+			}
+			ds = 2 * top + ((v >> (top - 1)) & 1);
+		}
+		bits.put(codes.distance[ds], 5);
+		bits.put(static_cast<uint32_t>(distance - FixedCodes::DISTANCE_BASE[ds]), ds < 4 ? 0 : ds / 2 - 1);
+
+		// short matches put their positions in the table too. long ones are runs of the same few
+		// bytes, their start is all a later match needs
+		size_t end = i + length;
+		if (length <= SHORT_MATCH)
+		{
+			for (i++; i < end && i + MIN_MATCH <= size; i++)
+			{
+				head[hashOf(load(i))] = static_cast<int32_t>(i);
+			}
+		}
+		i = end;
+	}
+	while (i < size)
+	{
+		literal(data[i++]);
+	}
+	bits.put(codes.literal[256], codes.literalBits[256]);
+	bits.finish();
+}
+
+static uint32_t adler32(const uint8_t* data, size_t size)
+{
+	uint32_t a = 1;
+	uint32_t b = 0;
+	while (size > 0)
+	{
+		// the largest run that can't overflow b before the modulo
+		size_t run = std::min<size_t>(size, 5552);
+		for (size_t i = 0; i < run; i++)
+		{
+			a += data[i];
+			b += a;
+		}
+		a %= 65521;
+		b %= 65521;
+		data += run;
+		size -= run;
+	}
+	return (b << 16) | a;
+}
+
+static uint32_t crc32(const uint8_t* data, size_t size, uint32_t crc = 0)
+{
+	static const auto table = []() {
+		std::array<uint32_t, 256> t{};
+		for (uint32_t n = 0; n < 256; n++)
+		{
+			uint32_t c = n;
+			for (int k = 0; k < 8; k++)
+			{
+				c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+			}
+			t[n] = c;
+		}
+		return t;
+	}();
+	crc = ~crc;
+	for (size_t i = 0; i < size; i++)
+	{
+		crc = table[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+	}
+	return ~crc;
+}
+
+static void putBigEndian(std::vector<uint8_t>& out, uint32_t value)
+{
+	for (int shift = 24; shift >= 0; shift -= 8)
+	{
+		out.push_back(static_cast<uint8_t>(value >> shift));
+	}
+}
+
+static void beginPngChunk(std::vector<uint8_t>& file, const char type[4])
+{
+	// length patched in by endPngChunk
+	putBigEndian(file, 0);
+	file.insert(file.end(), type, type + 4);
+}
+
+static void endPngChunk(std::vector<uint8_t>& file, size_t chunkStart)
+{
+	size_t dataStart = chunkStart + 8;
+	uint32_t length = static_cast<uint32_t>(file.size() - dataStart);
+	for (int i = 0; i < 4; i++)
+	{
+		file[chunkStart + i] = static_cast<uint8_t>(length >> (24 - i * 8));
+	}
+	putBigEndian(file, crc32(file.data() + chunkStart + 4, length + 4));
+}
+
+void encodePng(const VImageData& image, std::vector<uint8_t>& file)
+{
+	// every row gets the sub filter, flat and gradient areas turn into runs the match finder eats
+	size_t rowBytes = static_cast<size_t>(image.width) * 4;
+	std::vector<uint8_t> filtered((rowBytes + 1) * image.height);
+	for (uint32_t y = 0; y < image.height; y++)
+	{
+		const uint8_t* src = image.pixels.data() + y * rowBytes;
+		uint8_t* dst = filtered.data() + y * (rowBytes + 1);
+		dst[0] = 1;
+		std::memcpy(dst + 1, src, std::min<size_t>(4, rowBytes));
+		for (size_t x = 4; x < rowBytes; x++)
+		{
+			dst[1 + x] = static_cast<uint8_t>(src[x] - src[x - 4]);
+		}
+	}
+
+	file.clear();
+	file.reserve(filtered.size() / 2);
+	static const uint8_t signature[8] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+	file.insert(file.end(), signature, signature + 8);
+
+	size_t chunk = file.size();
+	beginPngChunk(file, "IHDR");
+	putBigEndian(file, image.width);
+	putBigEndian(file, image.height);
+	// 8 bit rgba, deflate, adaptive filtering, not interlaced
+	const uint8_t header[5] = { 8, 6, 0, 0, 0 };
+	file.insert(file.end(), header, header + 5);
+	endPngChunk(file, chunk);
+
+	chunk = file.size();
+	beginPngChunk(file, "IDAT");
+	// zlib stream: 32k window, no dictionary, fastest
+	file.push_back(0x78);
+	file.push_back(0x01);
+	deflateFixed(filtered.data(), filtered.size(), file);
+	putBigEndian(file, adler32(filtered.data(), filtered.size()));
+	endPngChunk(file, chunk);
+
+	chunk = file.size();
+	beginPngChunk(file, "IEND");
+	endPngChunk(file, chunk);
+}
+
+}
\ No newline at end of file
@@ -0,0 +1,28 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace vwdw {
+
+	// decoded image, always tightly packed rgba8 with the first row at the top
+	struct VImageData {
+		uint32_t width = 0;
+		uint32_t height = 0;
+		std::vector<uint8_t> pixels;
+	};
+
+	// tga (uncompressed / rle, 8, 24 or 32 bit) and binary ppm, picked by the file's header.
+	// returns false with a reason in error instead of throwing so it's safe on worker threads
+	bool decodeImage(const std::vector<uint8_t>& file, VImageData& image, std::string& error);
+	bool loadImageFile(const std::string& path, VImageData& image, std::string& error);
+
+	// box filters down to the next mip level, odd edges fold into the last texel
+	void downsampleImage(const VImageData& src, VImageData& dst);
+	// bc1 (4 colour mode, alpha dropped), 8 bytes per 4x4 block, partial edge blocks repeat the edge texels
+	void compressBC1(const VImageData& image, std::vector<uint8_t>& blocks);
+	// 8 bit rgba png, compressed for speed over size so frames can be written as fast as they render
+	void encodePng(const VImageData& image, std::vector<uint8_t>& file);
+
+}
@@ -0,0 +1,340 @@
+#include "v_jobs.hpp"
+#include "v_frame_arena.hpp"
+
+#include <algorithm>
+
+namespace vwdw {
+
+// which system a background worker belongs to, and its index in it
+static thread_local const VJobSystem* tlsSystem = nullptr;
+static thread_local uint32_t tlsWorker = VJobSystem::NOT_A_WORKER;
+
+// failed lookups before an idle worker goes to sleep
+static constexpr uint32_t IDLE_SPINS = 64;
+
+VJobSystem::WorkDeque::WorkDeque() : jobs{ new std::atomic<Job*>[DEQUE_CAPACITY] }
+{
+	for (uint32_t i = 0; i < DEQUE_CAPACITY; i++)
+	{
+		jobs[i].store(nullptr, std::memory_order_relaxed);
+	}
+}
+
+bool VJobSystem::WorkDeque::push(Job* job)
+{
+	int64_t b = bottom.load(std::memory_order_relaxed);
+	int64_t t = top.load(std::memory_order_acquire);
+	if (b - t >= static_cast<int64_t>(DEQUE_CAPACITY))
+	{
+		return false;
+	}
+	jobs[b & (DEQUE_CAPACITY - 1)].store(job, std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_release);
+	bottom.store(b + 1, std::memory_order_relaxed);
+	return true;
+}
+
+VJobSystem::Job* VJobSystem::WorkDeque::pop()
+{
+	int64_t b = bottom.load(std::memory_order_relaxed) - 1;
+	bottom.store(b, std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_seq_cst);
+	int64_t t = top.load(std::memory_order_relaxed);
+
+	if (t > b)
+	{
+		// empty
+		bottom.store(b + 1, std::memory_order_relaxed);
+		return nullptr;
+	}
+	Job* job = jobs[b & (DEQUE_CAPACITY - 1)].load(std::memory_order_relaxed);
+	if (t == b)
+	{
+		// last job, race the thieves for it
+		if (!top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+		{
+			job = nullptr;
+		}
+		bottom.store(b + 1, std::memory_order_relaxed);
+	}
+	return job;
+}
+
+VJobSystem::Job* VJobSystem::WorkDeque::steal()
+{
+	int64_t t = top.load(std::memory_order_acquire);
+	std::atomic_thread_fence(std::memory_order_seq_cst);
+	int64_t b = bottom.load(std::memory_order_acquire);
+	if (t >= b)
+	{
+		return nullptr;
+	}
+	Job* job = jobs[t & (DEQUE_CAPACITY - 1)].load(std::memory_order_relaxed);
+	if (!top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+	{
+		return nullptr;
+	}
+	return job;
+}
+
+VJobSystem::VJobSystem(uint32_t workers) : ownerThread{ std::this_thread::get_id() }
+{
+	if (workers == 0)
+	{
+		workers = std::thread::hardware_concurrency();
+		workers = workers == 0 ? 1 : workers;
+	}
+	for (uint32_t i = 0; i < workers; i++)
+	{
+		deques.push_back(std::make_unique<WorkDeque>());
+	}
+	// worker 0 is the creating thread
+	for (uint32_t i = 1; i < workers; i++)
+	{
+		threads.emplace_back([this, i]() { workerLoop(i); });
+	}
+}
+
+VJobSystem::~VJobSystem()
+{
+	{
+		std::lock_guard<std::mutex> lock{ sleepMutex };
+		stopping = true;
+	}
+	wake.notify_all();
+	for (auto& thread : threads)
+	{
+		thread.join();
+	}
+	// anything still queued was never waited on, drop it
+	for (auto& deque : deques)
+	{
+		while (Job* job = deque->steal())
+		{
+			if (job->heapAllocated)
+			{
+				delete job;
+			}
+		}
+	}
+	for (Job* job : injected)
+	{
+		if (job->heapAllocated)
+		{
+			delete job;
+		}
+	}
+}
+
+uint32_t VJobSystem::currentWorker() const
+{
+	if (std::this_thread::get_id() == ownerThread)
+	{
+		return 0;
+	}
+	return tlsSystem == this ? tlsWorker : NOT_A_WORKER;
+}
+
+void VJobSystem::run(JobFn job, Counter* counter)
+{
+	if (counter != nullptr)
+	{
+		counter->pending.fetch_add(1, std::memory_order_relaxed);
+	}
+	push(new Job{ std::move(job), counter });
+}
+
+void VJobSystem::runAfter(Counter& dependency, JobFn job, Counter* counter)
+{
+	if (counter != nullptr)
+	{
+		counter->pending.fetch_add(1, std::memory_order_relaxed);
+	}
+	Job* next = new Job{ std::move(job), counter };
+	{
+		std::lock_guard<std::mutex> lock{ dependency.mutex };
+		if (dependency.pending.load(std::memory_order_acquire) != 0)
+		{
+			dependency.continuations.push_back(next);
+			return;
+		}
+	}
+	push(next);
+}
+
+void VJobSystem::wait(Counter& counter)
+{
+	uint32_t worker = currentWorker();
+	while (!counter.done())
+	{
+		if (Job* job = findJob(worker))
+		{
+			execute(job);
+		}
+		else
+		{
+			std::this_thread::yield();
+		}
+	}
+	// the last job may still be inside finish(), it lets go of the mutex after the count hits zero
+	std::lock_guard<std::mutex> lock{ counter.mutex };
+}
+
+void VJobSystem::parallelForRange(uint32_t count, uint32_t minBatch, const RangeRef& range)
+{
+	if (count == 0)
+	{
+		return;
+	}
+	// a few batches per worker so stealing can even out uneven batches
+	uint32_t batches = workerCount() * 4;
+	uint32_t batchSize = (count + batches - 1) / batches;
+	batchSize = std::max(batchSize, std::max(minBatch, 1u));
+	if (batchSize >= count)
+	{
+		range.invoke(range.body, 0, count);
+		return;
+	}
+
+	// wait() doesn't return before every batch finished, so the jobs can live on this stack frame
+	// instead of the heap. the lambdas are two words, small enough for std::function's inline storage
+	VScratchArena<4096> scratch;
+	std::pmr::vector<Job> batchJobs{ &scratch };
+	batchJobs.reserve((count + batchSize - 1) / batchSize);
+	Counter counter;
+	for (uint32_t begin = 0; begin < count; begin += batchSize)
+	{
+		uint32_t end = std::min(begin + batchSize, count);
+		batchJobs.push_back(Job{ [&range, begin, end]() { range.invoke(range.body, begin, end); }, &counter, false });
+	}
+	counter.pending.fetch_add(static_cast<uint32_t>(batchJobs.size()), std::memory_order_relaxed);
+	for (Job& job : batchJobs)
+	{
+		push(&job);
+	}
+	wait(counter);
+}
+
+void VJobSystem::push(Job* job)
+{
+	queued.fetch_add(1);
+	uint32_t worker = currentWorker();
+	if (worker != NOT_A_WORKER)
+	{
+		if (!deques[worker]->push(job))
+		{
+			queued.fetch_sub(1);
+			execute(job);
+			return;
+		}
+	}
+	else
+	{
+		std::lock_guard<std::mutex> lock{ injectedMutex };
+		injected.push_back(job);
+	}
+
+	if (sleeping.load() > 0)
+	{
+		std::lock_guard<std::mutex> lock{ sleepMutex };
+		wake.notify_one();
+	}
+}
+
+VJobSystem::Job* VJobSystem::findJob(uint32_t worker)
+{
+	Job* job = nullptr;
+	if (worker != NOT_A_WORKER)
+	{
+		job = deques[worker]->pop();
+	}
+	if (job == nullptr && queued.load(std::memory_order_relaxed) > 0)
+	{
+		{
+			std::lock_guard<std::mutex> lock{ injectedMutex };
+			if (!injected.empty())
+			{
+				job = injected.front();
+				injected.pop_front();
+			}
+		}
+		// start at the next worker over so thieves spread out instead of all hitting deque 0
+		uint32_t workers = workerCount();
+		uint32_t start = worker == NOT_A_WORKER ? 0 : worker + 1;
+		for (uint32_t i = 0; job == nullptr && i < workers; i++)
+		{
+			uint32_t victim = (start + i) % workers;
+			if (victim != worker)
+			{
+				job = deques[victim]->steal();
+			}
+		}
+	}
+	if (job != nullptr)
+	{
+		queued.fetch_sub(1);
+	}
+	return job;
+}
+
+void VJobSystem::execute(Job* job)
+{
+	// a job that isn't ours may be gone as soon as its counter drops, don't touch it after finish()
+	Counter* counter = job->counter;
+	bool heapAllocated = job->heapAllocated;
+	job->fn();
+	if (counter != nullptr)
+	{
+		finish(counter);
+	}
+	if (heapAllocated)
+	{
+		delete job;
+	}
+}
+
+void VJobSystem::finish(Counter* counter)
+{
+	std::vector<Job*> ready;
+	{
+		std::lock_guard<std::mutex> lock{ counter->mutex };
+		if (counter->pending.fetch_sub(1, std::memory_order_acq_rel) == 1)
+		{
+			ready.swap(counter->continuations);
+		}
+	}
+	for (Job* job : ready)
+	{
+		push(job);
+	}
+}
+
+void VJobSystem::workerLoop(uint32_t worker)
+{
+	tlsSystem = this;
+	tlsWorker = worker;
+
+	uint32_t idle = 0;
+	while (!stopping.load(std::memory_order_relaxed))
+	{
+		if (Job* job = findJob(worker))
+		{
+			execute(job);
+			idle = 0;
+			continue;
+		}
+		if (++idle < IDLE_SPINS)
+		{
+			std::this_thread::yield();
+			continue;
+		}
+
+		std::unique_lock<std::mutex> lock{ sleepMutex };
+		sleeping.fetch_add(1);
+		wake.wait(lock, [this]() { return queued.load() > 0 || stopping.load(); });
+		sleeping.fetch_sub(1);
+		idle = 0;
+	}
+}
+
+}
@@ -0,0 +1,126 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace vwdw {
+
+	// engine wide job system, one worker per hardware thread. the thread that creates it counts as
+	// worker 0 and only runs jobs while it waits, the rest are background threads. every worker has its
+	// own lock free deque: it pushes and pops at the bottom, idle workers steal from the top of the
+	// others'. jobs queued from threads outside the system go through a shared locked queue instead.
+	// waiting never blocks, the waiting thread runs jobs until the thing it waits on is done
+	class VJobSystem {
+	public:
+		static constexpr uint32_t NOT_A_WORKER = 0xFFFFFFFF;
+		// per worker deque size, a push past it runs the job inline
+		static constexpr uint32_t DEQUE_CAPACITY = 4096;
+
+		struct Job;
+
+		// counts jobs that haven't finished. jobs queued with runAfter() start once it drops to zero.
+		// has to outlive every job that counts against it, wait() on it before it goes out of scope
+		class Counter {
+		public:
+			Counter() = default;
+			Counter(const Counter&) = delete;
+			Counter& operator=(const Counter&) = delete;
+
+			bool done() const { return pending.load(std::memory_order_acquire) == 0; }
+
+		private:
+			friend class VJobSystem;
+			std::atomic<uint32_t> pending{ 0 };
+			// also held while pending is decremented, so a waiter can't free the counter under a finishing job
+			std::mutex mutex;
+			std::vector<Job*> continuations;
+		};
+
+		using JobFn = std::function<void()>;
+
+		struct Job {
+			JobFn fn;
+			Counter* counter;
+			// false for jobs that live in the caller's frame, like parallelFor's batches
+			bool heapAllocated = true;
+		};
+
+		// 0 sizes it to std::thread::hardware_concurrency()
+		explicit VJobSystem(uint32_t workers = 0);
+		~VJobSystem();
+
+		VJobSystem(const VJobSystem&) = delete;
+		VJobSystem& operator=(const VJobSystem&) = delete;
+
+		void run(JobFn job, Counter* counter = nullptr);
+		// job is queued once dependency reaches zero, counter counts it from now
+		void runAfter(Counter& dependency, JobFn job, Counter* counter = nullptr);
+		// runs jobs on the calling thread until counter reaches zero
+		void wait(Counter& counter);
+		// body(begin, end) over [0, count) split into batches of at least minBatch, returns once all ran.
+		// batches are contiguous and ascending but run in any order. body is only referenced, never
+		// copied into a std::function, so big captures don't cost an allocation
+		template<typename Body>
+		void parallelFor(uint32_t count, uint32_t minBatch, const Body& body)
+		{
+			RangeRef range{ &body, [](const void* b, uint32_t begin, uint32_t end) { (*static_cast<const Body*>(b))(begin, end); } };
+			parallelForRange(count, minBatch, range);
+		}
+
+		uint32_t workerCount() const { return static_cast<uint32_t>(deques.size()); }
+		// index of the calling thread in this system, NOT_A_WORKER for outside threads
+		uint32_t currentWorker() const;
+
+	private:
+		// chase-lev work stealing deque of fixed size (le, pop, cohen, nardelli 2013 memory orders)
+		class WorkDeque {
+		public:
+			WorkDeque();
+			// owner only
+			bool push(Job* job);
+			Job* pop();
+			// any thread
+			Job* steal();
+
+		private:
+			alignas(64) std::atomic<int64_t> top{ 0 };
+			alignas(64) std::atomic<int64_t> bottom{ 0 };
+			std::unique_ptr<std::atomic<Job*>[]> jobs;
+		};
+
+		// type erased parallelFor body
+		struct RangeRef {
+			const void* body;
+			void (*invoke)(const void* body, uint32_t begin, uint32_t end);
+		};
+
+		void parallelForRange(uint32_t count, uint32_t minBatch, const RangeRef& range);
+		void workerLoop(uint32_t worker);
+		void push(Job* job);
+		Job* findJob(uint32_t worker);
+		void execute(Job* job);
+		void finish(Counter* counter);
+
+		std::thread::id ownerThread;
+		std::vector<std::unique_ptr<WorkDeque>> deques;
+		std::vector<std::thread> threads;
+
+		std::mutex injectedMutex;
+		std::deque<Job*> injected;
+
+		// jobs sitting in a queue, idle workers sleep while it's zero
+		std::atomic<uint32_t> queued{ 0 };
+		std::atomic<uint32_t> sleeping{ 0 };
+		std::mutex sleepMutex;
+		std::condition_variable wake;
+		std::atomic<bool> stopping{ false };
+	};
+
+}
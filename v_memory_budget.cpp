@@ -0,0 +1,187 @@
+#include "v_memory_budget.hpp"
+
+#include <algorithm>
+
+namespace vwdw {
+
+void VMemoryBudget::init(VkPhysicalDevice device, bool extension, uint32_t frames)
+{
+	VkPhysicalDeviceMemoryProperties memoryProperties;
+	vkGetPhysicalDeviceMemoryProperties(device, &memoryProperties);
+	init(memoryProperties, frames);
+	physicalDevice = device;
+	extensionEnabled = extension;
+	query();
+}
+
+void VMemoryBudget::init(const VkPhysicalDeviceMemoryProperties& memoryProperties, uint32_t frames)
+{
+	framesInFlight = frames;
+	heaps.assign(memoryProperties.memoryHeapCount, Heap{});
+	for (uint32_t h = 0; h < memoryProperties.memoryHeapCount; h++)
+	{
+		heaps[h].size = memoryProperties.memoryHeaps[h].size;
+		heaps[h].budget = share(heaps[h].size, FALLBACK_BUDGET);
+		heaps[h].deviceLocal = (memoryProperties.memoryHeaps[h].flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT) != 0;
+	}
+	applyLimit();
+	typeHeaps.resize(memoryProperties.memoryTypeCount);
+	for (uint32_t t = 0; t < memoryProperties.memoryTypeCount; t++)
+	{
+		typeHeaps[t] = memoryProperties.memoryTypes[t].heapIndex;
+	}
+}
+
+void VMemoryBudget::query()
+{
+	if (!extensionEnabled)
+	{
+		return;
+	}
+	VkPhysicalDeviceMemoryBudgetPropertiesEXT budgetProperties{};
+	budgetProperties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MEMORY_BUDGET_PROPERTIES_EXT;
+	VkPhysicalDeviceMemoryProperties2 properties2{};
+	properties2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MEMORY_PROPERTIES_2;
+	properties2.pNext = &budgetProperties;
+	vkGetPhysicalDeviceMemoryProperties2(physicalDevice, &properties2);
+
+	for (uint32_t h = 0; h < heaps.size(); h++)
+	{
+		// some drivers leave a heap's budget at 0, keep the fallback for those
+		if (budgetProperties.heapBudget[h] > 0)
+		{
+			heaps[h].budget = budgetProperties.heapBudget[h];
+		}
+		heaps[h].usage = budgetProperties.heapUsage[h];
+	}
+	applyLimit();
+	lastQuery = currentFrame;
+}
+
+void VMemoryBudget::limitBudget(VkDeviceSize limit)
+{
+	budgetLimit = limit;
+	applyLimit();
+}
+
+void VMemoryBudget::applyLimit()
+{
+	for (Heap& heap : heaps)
+	{
+		if (budgetLimit > 0 && heap.deviceLocal)
+		{
+			heap.budget = std::min(heap.budget, budgetLimit);
+		}
+	}
+}
+
+void VMemoryBudget::beginFrame(uint64_t frame)
+{
+	currentFrame = frame;
+	if (extensionEnabled && currentFrame - lastQuery >= QUERY_INTERVAL)
+	{
+		query();
+	}
+	for (uint32_t h = 0; h < heaps.size(); h++)
+	{
+		if (heaps[h].usage > share(heaps[h].budget, EVICT_THRESHOLD))
+		{
+			evictDownTo(h, share(heaps[h].budget, EVICT_TARGET));
+		}
+	}
+}
+
+bool VMemoryBudget::makeRoom(uint32_t memoryType, VkDeviceSize size)
+{
+	uint32_t heap = typeHeaps[memoryType];
+	if (heaps[heap].usage + size <= heaps[heap].budget)
+	{
+		return true;
+	}
+	VkDeviceSize target = share(heaps[heap].budget, EVICT_TARGET);
+	return evictDownTo(heap, target > size ? target - size : 0);
+}
+
+bool VMemoryBudget::evictAll(uint32_t memoryType)
+{
+	uint32_t heap = typeHeaps[memoryType];
+	uint32_t before = heaps[heap].evictions;
+	evictDownTo(heap, 0);
+	return heaps[heap].evictions > before;
+}
+
+bool VMemoryBudget::evictDownTo(uint32_t heap, VkDeviceSize target)
+{
+	// oldest first, and only what no frame in flight can still be reading
+	candidates.clear();
+	for (const auto& entry : allocations)
+	{
+		const Allocation& allocation = entry.second;
+		if (allocation.heap == heap && allocation.evict && allocation.lastUse + framesInFlight <= currentFrame)
+		{
+			candidates.emplace_back(allocation.lastUse, entry.first);
+		}
+	}
+	std::sort(candidates.begin(), candidates.end(), [](const auto& a, const auto& b) { return a.first < b.first; });
+
+	for (const auto& candidate : candidates)
+	{
+		if (heaps[heap].usage <= target)
+		{
+			break;
+		}
+		// an earlier callback may have freed more than its own memory
+		auto it = allocations.find(candidate.second);
+		if (it == allocations.end() || !it->second.evict)
+		{
+			continue;
+		}
+		heaps[heap].evictions++;
+		heaps[heap].evictedBytes += it->second.size;
+		// the callback frees the memory, which erases the entry it came from
+		std::function<void()> evict = std::move(it->second.evict);
+		it->second.evict = nullptr;
+		evict();
+	}
+	return heaps[heap].usage <= target;
+}
+
+void VMemoryBudget::allocated(VkDeviceMemory memory, uint32_t memoryType, VkDeviceSize size)
+{
+	uint32_t heap = typeHeaps[memoryType];
+	allocations[memory] = Allocation{ heap, size, currentFrame, nullptr };
+	heaps[heap].usage += size;
+}
+
+void VMemoryBudget::freed(VkDeviceMemory memory)
+{
+	auto it = allocations.find(memory);
+	if (it == allocations.end())
+	{
+		return;
+	}
+	uint32_t heap = it->second.heap;
+	heaps[heap].usage -= std::min(heaps[heap].usage, it->second.size);
+	allocations.erase(it);
+}
+
+void VMemoryBudget::markStreamable(VkDeviceMemory memory, std::function<void()> evict)
+{
+	auto it = allocations.find(memory);
+	if (it != allocations.end())
+	{
+		it->second.evict = std::move(evict);
+		it->second.lastUse = currentFrame;
+	}
+}
+
+void VMemoryBudget::touch(VkDeviceMemory memory, uint64_t frame)
+{
+	auto it = allocations.find(memory);
+	if (it != allocations.end())
+	{
+		it->second.lastUse = frame;
+	}
+}
+
+}
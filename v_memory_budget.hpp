@@ -0,0 +1,107 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+
+#include <cstdint>
+#include <functional>
+#include <unordered_map>
+#include <vector>
+
+namespace vwdw {
+
+	// how much of each memory heap is in use against how much the process should use. with
+	// VK_EXT_memory_budget the driver's numbers are read every few frames (they count other processes
+	// and driver internals too) and what was allocated or freed since is added on top; without it the
+	// usage is everything allocated through VDevice and the budget a fixed share of the heap.
+	// allocations can be marked streamable with a callback that frees them, and when a heap gets close
+	// to its budget the ones used least recently are evicted until it's back under. nothing used in the
+	// last framesInFlight frames is evicted, the gpu may still be reading it. not thread safe, every
+	// allocation goes through the render thread
+	class VMemoryBudget {
+	public:
+		// a heap above this share of its budget starts evicting, down to the target
+		static constexpr float EVICT_THRESHOLD = 0.9f;
+		static constexpr float EVICT_TARGET = 0.8f;
+		// without the extension, the share of a heap taken as its budget
+		static constexpr float FALLBACK_BUDGET = 0.8f;
+		// the driver query isn't free, the tracked deltas cover the frames in between
+		static constexpr uint32_t QUERY_INTERVAL = 30;
+
+		struct Heap {
+			VkDeviceSize size = 0;
+			VkDeviceSize budget = 0;
+			VkDeviceSize usage = 0;
+			bool deviceLocal = false;
+			// since startup
+			uint32_t evictions = 0;
+			VkDeviceSize evictedBytes = 0;
+		};
+
+		VMemoryBudget() = default;
+
+		VMemoryBudget(const VMemoryBudget&) = delete;
+		VMemoryBudget& operator=(const VMemoryBudget&) = delete;
+
+		// extensionEnabled: VK_EXT_memory_budget is enabled on the device
+		void init(VkPhysicalDevice physicalDevice, bool extensionEnabled, uint32_t framesInFlight);
+		// without a device, for the benchmarks: the heaps and memory types as given, fallback budgets
+		void init(const VkPhysicalDeviceMemoryProperties& memoryProperties, uint32_t framesInFlight);
+
+		// caps every device local heap's budget, whatever the driver reports. 0 means no cap
+		void limitBudget(VkDeviceSize limit);
+
+		// once a frame after its fence was waited on, evicts from every heap over the threshold
+		void beginFrame(uint64_t frame);
+
+		// before an allocation of size from memoryType, evicts until it fits under the budget.
+		// false when there wasn't enough to evict, the allocation may still succeed
+		bool makeRoom(uint32_t memoryType, VkDeviceSize size);
+		// evicts everything it can from memoryType's heap after an allocation failed anyway, false when
+		// nothing could go
+		bool evictAll(uint32_t memoryType);
+
+		void allocated(VkDeviceMemory memory, uint32_t memoryType, VkDeviceSize size);
+		// also forgets a streamable on memory
+		void freed(VkDeviceMemory memory);
+
+		// evict frees memory (and whatever uses it), the resource has to be loaded again to come back.
+		// it's forgotten once evicted or freed, so a reloaded resource is marked again
+		void markStreamable(VkDeviceMemory memory, std::function<void()> evict);
+		// this frame reads memory, not evicted for another framesInFlight frames
+		void touch(VkDeviceMemory memory, uint64_t frame);
+
+		const std::vector<Heap>& getHeaps() const { return heaps; }
+		uint32_t heapOf(uint32_t memoryType) const { return typeHeaps[memoryType]; }
+		bool usesMemoryBudgetExtension() const { return extensionEnabled; }
+
+	private:
+		struct Allocation {
+			uint32_t heap;
+			VkDeviceSize size;
+			uint64_t lastUse;
+			// empty unless streamable
+			std::function<void()> evict;
+		};
+
+		void query();
+		void applyLimit();
+		// frees least recently used streamables in heap until its usage is at most target
+		bool evictDownTo(uint32_t heap, VkDeviceSize target);
+		static VkDeviceSize share(VkDeviceSize size, float fraction) { return static_cast<VkDeviceSize>(static_cast<double>(size) * fraction); }
+
+		VkPhysicalDevice physicalDevice = VK_NULL_HANDLE;
+		bool extensionEnabled = false;
+		uint32_t framesInFlight = 1;
+		uint64_t currentFrame = 0;
+		uint64_t lastQuery = 0;
+		VkDeviceSize budgetLimit = 0;
+
+		std::vector<Heap> heaps;
+		// by memory type
+		std::vector<uint32_t> typeHeaps;
+		std::unordered_map<VkDeviceMemory, Allocation> allocations;
+		// kept around so evicting doesn't allocate a fresh list every time
+		std::vector<std::pair<uint64_t, VkDeviceMemory>> candidates;
+	};
+
+}
@@ -0,0 +1,294 @@
+#include "v_particles.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <numeric>
+#include <stdexcept>
+
+namespace vwdw {
+
+// 3 vec4 per particle, see the Particle struct in the shaders
+static constexpr VkDeviceSize PARTICLE_SIZE = 3 * sizeof(glm::vec4);
+// particle.vert expands every instance into two triangles
+static constexpr uint32_t QUAD_VERTICES = 6;
+// a long stall would otherwise throw everything alive halfway across the screen in one step
+static constexpr float MAX_STEP = 0.1f;
+
+static_assert(sizeof(VParticleSystem::PushConstants) <= 128, "particle push constants over the guaranteed minimum");
+
+// everything the previous dispatch wrote is visible to the next one, as shader data or indirect arguments
+static void computeBarrier(VkCommandBuffer commandBuffer)
+{
+	VkMemoryBarrier barrier{};
+	barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+	barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+	barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT | VK_ACCESS_INDIRECT_COMMAND_READ_BIT;
+	vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+		VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT | VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT, 0, 1, &barrier, 0, nullptr, 0, nullptr);
+}
+
+VParticleSystem::VParticleSystem(VDevice& device, uint32_t capacity, const std::string& shaderDir, const std::string& shaderSuffix, VUniformRing& frameRing, uint32_t framesInFlight)
+	: vDevice{ device }, frameRing{ frameRing }, capacity{ capacity }, shaderDir{ shaderDir }, shaderSuffix{ shaderSuffix }, compute{ device, framesInFlight },
+	dynamicOffsets(frameRing.bindingCount(), 0)
+{
+	createBuffers();
+	createDescriptors();
+	createPipelineLayouts(frameRing.getDescriptorSetLayout());
+	createComputePipelines();
+}
+
+VParticleSystem::~VParticleSystem()
+{
+	compute.waitIdle();
+	vkDestroyPipelineLayout(vDevice.device(), computeLayout, nullptr);
+	vkDestroyPipelineLayout(vDevice.device(), renderLayout, nullptr);
+	vkDestroyDescriptorPool(vDevice.device(), descriptorPool, nullptr);
+	vkDestroyDescriptorSetLayout(vDevice.device(), setLayout, nullptr);
+}
+
+void VParticleSystem::createBuffers()
+{
+	// read and written by both queues, so shared when compute has its own family
+	VkBufferUsageFlags storage = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT;
+	particleBuffer = std::make_unique<VBuffer>(vDevice, PARTICLE_SIZE * capacity * 2, storage, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, true);
+	aliveBuffer = std::make_unique<VBuffer>(vDevice, sizeof(uint32_t) * capacity * 2, storage, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, true);
+	deadBuffer = std::make_unique<VBuffer>(vDevice, sizeof(uint32_t) * capacity,
+		storage | VK_BUFFER_USAGE_TRANSFER_DST_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, true);
+	counterBuffer = std::make_unique<VBuffer>(vDevice, sizeof(Counters),
+		storage | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, true);
+
+	// every slot starts out dead, this is the only time the cpu writes any of it
+	std::vector<uint32_t> dead(capacity);
+	std::iota(dead.begin(), dead.end(), 0u);
+	VBuffer deadStaging{ vDevice, deadBuffer->getSize(), VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT };
+	deadStaging.write(dead.data());
+	vDevice.copyBuffer(deadStaging.getBuffer(), deadBuffer->getBuffer(), deadBuffer->getSize());
+
+	Counters counters{};
+	counters.deadCount = static_cast<int32_t>(capacity);
+	for (VkDrawIndirectCommand& draw : counters.draw)
+	{
+		draw.vertexCount = QUAD_VERTICES;
+	}
+	VBuffer counterStaging{ vDevice, sizeof(Counters), VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT };
+	counterStaging.write(&counters);
+	vDevice.copyBuffer(counterStaging.getBuffer(), counterBuffer->getBuffer(), sizeof(Counters));
+}
+
+void VParticleSystem::createDescriptors()
+{
+	VkBuffer buffers[] = { particleBuffer->getBuffer(), aliveBuffer->getBuffer(), deadBuffer->getBuffer(), counterBuffer->getBuffer() };
+	constexpr uint32_t BINDINGS = 4;
+
+	VkDescriptorSetLayoutBinding bindings[BINDINGS]{};
+	for (uint32_t i = 0; i < BINDINGS; i++)
+	{
+		bindings[i].binding = i;
+		bindings[i].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+		bindings[i].descriptorCount = 1;
+		bindings[i].stageFlags = VK_SHADER_STAGE_COMPUTE_BIT | VK_SHADER_STAGE_VERTEX_BIT;
+	}
+
+	VkDescriptorSetLayoutCreateInfo layoutInfo{};
+	layoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+	layoutInfo.bindingCount = BINDINGS;
+	layoutInfo.pBindings = bindings;
+	if (vkCreateDescriptorSetLayout(vDevice.device(), &layoutInfo, nullptr, &setLayout) != VK_SUCCESS)
+	{
+		throw std::runtime_error("failed to create particle descriptor set layout");
+	}
+
+	VkDescriptorPoolSize poolSize{};
+	poolSize.type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+	poolSize.descriptorCount = BINDINGS;
+
+	VkDescriptorPoolCreateInfo poolInfo{};
+	poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+	poolInfo.maxSets = 1;
+	poolInfo.poolSizeCount = 1;
+	poolInfo.pPoolSizes = &poolSize;
+	if (vkCreateDescriptorPool(vDevice.device(), &poolInfo, nullptr, &descriptorPool) != VK_SUCCESS)
+	{
+		throw std::runtime_error("failed to create particle descriptor pool");
+	}
+
+	VkDescriptorSetAllocateInfo allocInfo{};
+	allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+	allocInfo.descriptorPool = descriptorPool;
+	allocInfo.descriptorSetCount = 1;
+	allocInfo.pSetLayouts = &setLayout;
+	if (vkAllocateDescriptorSets(vDevice.device(), &allocInfo, &descriptorSet) != VK_SUCCESS)
+	{
+		throw std::runtime_error("failed to allocate particle descriptor set");
+	}
+
+	VkDescriptorBufferInfo bufferInfos[BINDINGS]{};
+	VkWriteDescriptorSet writes[BINDINGS]{};
+	for (uint32_t i = 0; i < BINDINGS; i++)
+	{
+		bufferInfos[i].buffer = buffers[i];
+		bufferInfos[i].offset = 0;
+		bufferInfos[i].range = VK_WHOLE_SIZE;
+
+		writes[i].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+		writes[i].dstSet = descriptorSet;
+		writes[i].dstBinding = i;
+		writes[i].descriptorCount = 1;
+		writes[i].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+		writes[i].pBufferInfo = &bufferInfos[i];
+	}
+	vkUpdateDescriptorSets(vDevice.device(), BINDINGS, writes, 0, nullptr);
+}
+
+void VParticleSystem::createPipelineLayouts(VkDescriptorSetLayout frameSetLayout)
+{
+	VkPushConstantRange pushConstantRange{};
+	pushConstantRange.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+	pushConstantRange.offset = 0;
+	pushConstantRange.size = sizeof(PushConstants);
+
+	VkPipelineLayoutCreateInfo layoutInfo{};
+	layoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+	layoutInfo.setLayoutCount = 1;
+	layoutInfo.pSetLayouts = &setLayout;
+	layoutInfo.pushConstantRangeCount = 1;
+	layoutInfo.pPushConstantRanges = &pushConstantRange;
+	if (vkCreatePipelineLayout(vDevice.device(), &layoutInfo, nullptr, &computeLayout) != VK_SUCCESS)
+	{
+		throw std::runtime_error("failed to create particle compute pipeline layout");
+	}
+
+	// the particle set stays at set 0 so the shaders share one declaration, the frame uniforms go after it
+	VkDescriptorSetLayout renderSets[] = { setLayout, frameSetLayout };
+	pushConstantRange.stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
+	layoutInfo.setLayoutCount = 2;
+	layoutInfo.pSetLayouts = renderSets;
+	if (vkCreatePipelineLayout(vDevice.device(), &layoutInfo, nullptr, &renderLayout) != VK_SUCCESS)
+	{
+		throw std::runtime_error("failed to create particle render pipeline layout");
+	}
+}
+
+void VParticleSystem::createComputePipelines()
+{
+	VSpecializationConstants prepare{};
+	prepare.set(SPEC_FINALIZE, false);
+	VSpecializationConstants finalize{};
+	finalize.set(SPEC_FINALIZE, true);
+
+	preparePipeline = std::make_unique<VComputePipeline>(vDevice, shaderPath("particle_indirect.comp"), computeLayout, prepare);
+	emitPipeline = std::make_unique<VComputePipeline>(vDevice, shaderPath("particle_emit.comp"), computeLayout);
+	simulatePipeline = std::make_unique<VComputePipeline>(vDevice, shaderPath("particle_simulate.comp"), computeLayout);
+	finalizePipeline = std::make_unique<VComputePipeline>(vDevice, shaderPath("particle_indirect.comp"), computeLayout, finalize);
+}
+
+void VParticleSystem::createRenderPipeline(const PipelineConfigInfo& target)
+{
+	PipelineConfigInfo config{};
+	VwdwPipeline::defaultConfig(config);
+	config.renderPass = target.renderPass;
+	config.subpass = target.subpass;
+	config.colorFormat = target.colorFormat;
+	config.depthFormat = target.depthFormat;
+	config.pipelineLayout = renderLayout;
+	config.vertexPulling = true;
+
+	// tested against the scene's depth but never written, additive so draw order doesn't matter
+	config.depthStencilInfo.depthWriteEnable = VK_FALSE;
+	config.colorBlendAttachment.blendEnable = VK_TRUE;
+	config.colorBlendAttachment.srcColorBlendFactor = VK_BLEND_FACTOR_SRC_ALPHA;
+	config.colorBlendAttachment.dstColorBlendFactor = VK_BLEND_FACTOR_ONE;
+	config.colorBlendAttachment.srcAlphaBlendFactor = VK_BLEND_FACTOR_ZERO;
+	config.colorBlendAttachment.dstAlphaBlendFactor = VK_BLEND_FACTOR_ONE;
+
+	renderPipeline.reset();
+	renderPipeline = std::make_unique<VwdwPipeline>(vDevice, config, shaderPath("particle.vert"), shaderPath("particle.frag"));
+}
+
+uint32_t VParticleSystem::addEmitter(const VParticleEmitter& emitter)
+{
+	emitters.push_back(Emitter{ emitter, 0.0f });
+	return static_cast<uint32_t>(emitters.size() - 1);
+}
+
+VParticleSystem::PushConstants VParticleSystem::basePushConstants(float dt) const
+{
+	PushConstants push{};
+	push.gravityDt = glm::vec4{ gravity, dt };
+	push.size = particleSize;
+	push.seed = frameNumber * 0x9E3779B9u;
+	push.srcList = currentList;
+	push.capacity = capacity;
+	return push;
+}
+
+VkSemaphore VParticleSystem::simulate(uint32_t frameIndex, float dt)
+{
+	dt = std::min(dt, MAX_STEP);
+	VkCommandBuffer commandBuffer = compute.begin(frameIndex);
+
+	// the last submission on this queue may still be running, nothing orders separate submits otherwise
+	computeBarrier(commandBuffer);
+	vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, computeLayout, 0, 1, &descriptorSet, 0, nullptr);
+
+	PushConstants push = basePushConstants(dt);
+	vkCmdPushConstants(commandBuffer, computeLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(PushConstants), &push);
+	preparePipeline->bind(commandBuffer);
+	vkCmdDispatch(commandBuffer, 1, 1, 1);
+	computeBarrier(commandBuffer);
+
+	// one dispatch per emitter, they only meet on the dead list's atomic counter
+	emitPipeline->bind(commandBuffer);
+	for (uint32_t i = 0; i < emitters.size(); i++)
+	{
+		Emitter& emitter = emitters[i];
+		float wanted = emitter.params.rate * dt + emitter.carry;
+		uint32_t emitCount = static_cast<uint32_t>(std::min(wanted, static_cast<float>(capacity)));
+		emitter.carry = wanted - static_cast<float>(emitCount);
+		if (emitCount == 0)
+		{
+			continue;
+		}
+
+		PushConstants emit = push;
+		emit.positionRadius = glm::vec4{ emitter.params.position, emitter.params.radius };
+		emit.velocitySpread = glm::vec4{ emitter.params.velocity, emitter.params.spread };
+		emit.color = emitter.params.color;
+		emit.lifetime = emitter.params.lifetime;
+		emit.emitCount = emitCount;
+		emit.seed = push.seed + i * 0x85EBCA6Bu;
+		vkCmdPushConstants(commandBuffer, computeLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(PushConstants), &emit);
+		vkCmdDispatch(commandBuffer, VComputePipeline::groupCount(emitCount, EMIT_GROUP_SIZE), 1, 1);
+	}
+	computeBarrier(commandBuffer);
+
+	vkCmdPushConstants(commandBuffer, computeLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(PushConstants), &push);
+	simulatePipeline->bind(commandBuffer);
+	vkCmdDispatchIndirect(commandBuffer, counterBuffer->getBuffer(), offsetof(Counters, simulateDispatch));
+	computeBarrier(commandBuffer);
+
+	finalizePipeline->bind(commandBuffer);
+	vkCmdDispatch(commandBuffer, 1, 1, 1);
+
+	currentList ^= 1;
+	frameNumber++;
+	return compute.submit(frameIndex);
+}
+
+void VParticleSystem::draw(VkCommandBuffer commandBuffer, uint32_t frameUniformOffset)
+{
+	renderPipeline->bind(commandBuffer);
+
+	// the frame block is the only one particle.vert reads, every binding of the ring gets the same offset
+	std::fill(dynamicOffsets.begin(), dynamicOffsets.end(), frameUniformOffset);
+	VkDescriptorSet frameSet = frameRing.getDescriptorSet();
+	vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, renderLayout, 0, 1, &descriptorSet, 0, nullptr);
+	vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, renderLayout, 1, 1, &frameSet,
+		static_cast<uint32_t>(dynamicOffsets.size()), dynamicOffsets.data());
+
+	PushConstants push = basePushConstants(0.0f);
+	vkCmdPushConstants(commandBuffer, renderLayout, VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(PushConstants), &push);
+	vkCmdDrawIndirect(commandBuffer, counterBuffer->getBuffer(), offsetof(Counters, draw) + currentList * sizeof(VkDrawIndirectCommand), 1, sizeof(VkDrawIndirectCommand));
+}
+
+}
@@ -0,0 +1,139 @@
+#pragma once
+
+#include "v_compute.hpp"
+#include "v_buffer.hpp"
+#include "v_uniform_ring.hpp"
+
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace vwdw {
+
+	struct VParticleEmitter {
+		glm::vec3 position{ 0.0f };
+		// particles spawn inside this sphere
+		float radius = 0.0f;
+		glm::vec3 velocity{ 0.0f };
+		// random extra velocity in any direction, up to this length
+		float spread = 0.0f;
+		glm::vec4 color{ 1.0f };
+		// particles per second
+		float rate = 0.0f;
+		float lifetime = 1.0f;
+	};
+
+	// gpu particles. all state lives in device local storage buffers: emission, integration and
+	// compaction of the alive list run as compute on the async compute queue, and the draw is an
+	// indirect instanced draw whose instance count the gpu wrote itself. the only per frame upload
+	// is the emitter parameters, as push constants.
+	// particles and alive lists are double buffered, each frame simulates one half into the other
+	// while the previous frame may still be drawing from it
+	class VParticleSystem {
+	public:
+		// the Push block of Shaders/particle_*.comp and particle.vert
+		struct PushConstants {
+			glm::vec4 positionRadius;
+			glm::vec4 velocitySpread;
+			glm::vec4 color;
+			glm::vec4 gravityDt;
+			float lifetime;
+			float size;
+			uint32_t emitCount;
+			uint32_t seed;
+			uint32_t srcList;
+			uint32_t capacity;
+		};
+
+		// the graphics submit has to wait on simulate()'s semaphore at these stages
+		static constexpr VkPipelineStageFlags CONSUMER_STAGES = VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT | VK_PIPELINE_STAGE_VERTEX_SHADER_BIT;
+		// constant_id in particle_indirect.comp
+		static constexpr uint32_t SPEC_FINALIZE = 0;
+		// local_size_x of particle_emit.comp
+		static constexpr uint32_t EMIT_GROUP_SIZE = 64;
+
+		// frameRing's set is bound as set 1 of the draw for the view projection. shaders are loaded from
+		// shaderDir/<name><shaderSuffix>, ".spv" for cooked modules and "" for glsl sources
+		VParticleSystem(VDevice& device, uint32_t capacity, const std::string& shaderDir, const std::string& shaderSuffix, VUniformRing& frameRing, uint32_t framesInFlight);
+		~VParticleSystem();
+
+		VParticleSystem(const VParticleSystem&) = delete;
+		VParticleSystem& operator=(const VParticleSystem&) = delete;
+
+		uint32_t addEmitter(const VParticleEmitter& emitter);
+		VParticleEmitter& getEmitter(uint32_t emitter) { return emitters[emitter].params; }
+		uint32_t getCapacity() const { return capacity; }
+
+		// takes the render pass / attachment formats from target, everything else is the particle's own state
+		void createRenderPipeline(const PipelineConfigInfo& target);
+
+		// records and submits this frame's emission and simulation. call once the frame slot's fence has
+		// been waited on, and make the graphics submit wait on the returned semaphore at CONSUMER_STAGES
+		VkSemaphore simulate(uint32_t frameIndex, float dt);
+		// inside the main pass after the opaque draws, draws what the last simulate() produced
+		void draw(VkCommandBuffer commandBuffer, uint32_t frameUniformOffset);
+
+		glm::vec3 gravity{ 0.0f, 1.5f, 0.0f };
+		// quad half size in clip space
+		float particleSize = 0.004f;
+
+	private:
+		// the Counters block, written only by the gpu after the initial upload
+		struct Counters {
+			uint32_t aliveCount[2];
+			int32_t deadCount;
+			uint32_t pad0;
+			VkDispatchIndirectCommand simulateDispatch;
+			uint32_t pad1;
+			VkDrawIndirectCommand draw[2];
+		};
+
+		struct Emitter {
+			VParticleEmitter params;
+			// fractional particles left over from earlier frames
+			float carry = 0.0f;
+		};
+
+		void createBuffers();
+		void createDescriptors();
+		void createPipelineLayouts(VkDescriptorSetLayout frameSetLayout);
+		void createComputePipelines();
+		std::string shaderPath(const char* name) const { return shaderDir + "/" + name + shaderSuffix; }
+		PushConstants basePushConstants(float dt) const;
+
+		VDevice& vDevice;
+		VUniformRing& frameRing;
+		uint32_t capacity;
+		std::string shaderDir;
+		std::string shaderSuffix;
+
+		std::unique_ptr<VBuffer> particleBuffer;
+		std::unique_ptr<VBuffer> aliveBuffer;
+		std::unique_ptr<VBuffer> deadBuffer;
+		std::unique_ptr<VBuffer> counterBuffer;
+
+		VkDescriptorSetLayout setLayout = VK_NULL_HANDLE;
+		VkDescriptorPool descriptorPool = VK_NULL_HANDLE;
+		VkDescriptorSet descriptorSet = VK_NULL_HANDLE;
+		VkPipelineLayout computeLayout = VK_NULL_HANDLE;
+		VkPipelineLayout renderLayout = VK_NULL_HANDLE;
+
+		std::unique_ptr<VComputePipeline> preparePipeline;
+		std::unique_ptr<VComputePipeline> emitPipeline;
+		std::unique_ptr<VComputePipeline> simulatePipeline;
+		std::unique_ptr<VComputePipeline> finalizePipeline;
+		std::unique_ptr<VwdwPipeline> renderPipeline;
+
+		VAsyncCompute compute;
+		std::vector<Emitter> emitters;
+		// the list the last simulate() wrote, which draw() reads
+		uint32_t currentList = 0;
+		uint32_t frameNumber = 0;
+		// one per binding of frameRing's set, refilled by every draw()
+		std::vector<uint32_t> dynamicOffsets;
+	};
+
+}
@@ -0,0 +1,217 @@
+#include "v_render_queue.hpp"
+
+#include <cstring>
+
+namespace vwdw {
+
+uint64_t VRenderQueue::makeKey(uint32_t pass, uint32_t pipeline, uint32_t descriptorSet, uint32_t mesh, float depth)
+{
+	float clamped = depth < 0.0f ? 0.0f : (depth > 1.0f ? 1.0f : depth);
+	uint64_t depthBits = static_cast<uint64_t>(clamped * static_cast<float>((1u << DEPTH_BITS) - 1));
+
+	uint64_t key = static_cast<uint64_t>(pass & ((1u << PASS_BITS) - 1));
+	key = (key << PIPELINE_BITS) | (pipeline & ((1u << PIPELINE_BITS) - 1));
+	key = (key << DESCRIPTOR_SET_BITS) | (descriptorSet & ((1u << DESCRIPTOR_SET_BITS) - 1));
+	key = (key << MESH_BITS) | (mesh & ((1u << MESH_BITS) - 1));
+	key = (key << DEPTH_BITS) | depthBits;
+	return key;
+}
+
+void VRenderQueue::reserve(uint32_t draws)
+{
+	entries.reserve(draws);
+	scratch.reserve(draws);
+	items.reserve(draws);
+}
+
+void VRenderQueue::clear()
+{
+	entries.clear();
+	items.clear();
+}
+
+void VRenderQueue::push(uint64_t key, const VDrawItem& item)
+{
+	entries.push_back({ key, static_cast<uint32_t>(items.size()) });
+	items.push_back(item);
+}
+
+void VRenderQueue::sort()
+{
+	size_t count = entries.size();
+	if (count < 2)
+	{
+		return;
+	}
+	scratch.resize(count);
+
+	// one pass builds all eight byte histograms
+	uint32_t histograms[8][256];
+	std::memset(histograms, 0, sizeof(histograms));
+	for (const Entry& e : entries)
+	{
+		for (int b = 0; b < 8; b++)
+		{
+			histograms[b][(e.key >> (b * 8)) & 0xFF]++;
+		}
+	}
+
+	// lsd radix, a byte every key shares (unused pipeline bits, a single pass...) is skipped outright
+	Entry* src = entries.data();
+	Entry* dst = scratch.data();
+	for (int b = 0; b < 8; b++)
+	{
+		uint32_t* hist = histograms[b];
+		if (hist[(src[0].key >> (b * 8)) & 0xFF] == count)
+		{
+			continue;
+		}
+
+		uint32_t offset = 0;
+		for (int i = 0; i < 256; i++)
+		{
+			uint32_t c = hist[i];
+			hist[i] = offset;
+			offset += c;
+		}
+		for (size_t i = 0; i < count; i++)
+		{
+			dst[hist[(src[i].key >> (b * 8)) & 0xFF]++] = src[i];
+		}
+
+		Entry* tmp = src;
+		src = dst;
+		dst = tmp;
+	}
+
+	if (src != entries.data())
+	{
+		entries.swap(scratch);
+	}
+}
+
+void VRenderQueue::record(VkCommandBuffer commandBuffer, const VDrawBindings& bindings)
+{
+	stats = Stats{};
+	VHandlePool<VwdwPipeline>& pipelines = *bindings.pipelines;
+	VHandlePool<VModel>& meshes = *bindings.meshes;
+	VPipelineHandle boundPipeline;
+	VMeshHandle boundMesh;
+	bool setBound = false;
+	uint32_t boundUniformOffset = 0;
+
+	// every material shares the layout, so the bindless set survives pipeline changes
+	if (bindings.bindlessSet != VK_NULL_HANDLE)
+	{
+		vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, bindings.pipelineLayout, 1, 1, &bindings.bindlessSet, 0, nullptr);
+	}
+
+	for (const Entry& e : entries)
+	{
+		const VDrawItem& item = items[e.item];
+		if (item.pipeline != boundPipeline)
+		{
+			pipelines[item.pipeline].bind(commandBuffer);
+			boundPipeline = item.pipeline;
+			stats.pipelineBinds++;
+		}
+		else
+		{
+			stats.pipelineBindsSkipped++;
+		}
+
+		VModel& mesh = meshes[item.mesh];
+		if (item.mesh != boundMesh)
+		{
+			mesh.bind(commandBuffer);
+			boundMesh = item.mesh;
+			stats.vertexBinds++;
+		}
+		else
+		{
+			stats.vertexBindsSkipped++;
+		}
+
+		// only the dynamic offset changes between draws, objects sharing a block skip the rebind
+		if (!setBound || item.uniformOffset != boundUniformOffset)
+		{
+			uint32_t offsets[2] = { bindings.frameUniformOffset, item.uniformOffset };
+			vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, bindings.pipelineLayout, 0, 1, &bindings.uniformSet, 2, offsets);
+			setBound = true;
+			boundUniformOffset = item.uniformOffset;
+			stats.descriptorBinds++;
+		}
+		else
+		{
+			stats.descriptorBindsSkipped++;
+		}
+
+		VObjectPushConstants push{};
+		if (item.transform != nullptr)
+		{
+			push.model = *item.transform;
+		}
+		push.texture = item.texture;
+		push.materialBuffer = item.materialBuffer;
+		vkCmdPushConstants(commandBuffer, bindings.pipelineLayout, VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT, 0, sizeof(VObjectPushConstants), &push);
+
+		mesh.draw(commandBuffer);
+		stats.draws++;
+	}
+
+	totals.draws += stats.draws;
+	totals.pipelineBinds += stats.pipelineBinds;
+	totals.pipelineBindsSkipped += stats.pipelineBindsSkipped;
+	totals.vertexBinds += stats.vertexBinds;
+	totals.vertexBindsSkipped += stats.vertexBindsSkipped;
+	totals.descriptorBinds += stats.descriptorBinds;
+	totals.descriptorBindsSkipped += stats.descriptorBindsSkipped;
+}
+
+VRenderQueue::Stats VRenderQueue::simulate() const
+{
+	Stats result{};
+	VPipelineHandle boundPipeline;
+	VMeshHandle boundMesh;
+	bool setBound = false;
+	uint32_t boundUniformOffset = 0;
+
+	for (const Entry& e : entries)
+	{
+		const VDrawItem& item = items[e.item];
+		if (item.pipeline != boundPipeline)
+		{
+			boundPipeline = item.pipeline;
+			result.pipelineBinds++;
+		}
+		else
+		{
+			result.pipelineBindsSkipped++;
+		}
+
+		if (item.mesh != boundMesh)
+		{
+			boundMesh = item.mesh;
+			result.vertexBinds++;
+		}
+		else
+		{
+			result.vertexBindsSkipped++;
+		}
+
+		if (!setBound || item.uniformOffset != boundUniformOffset)
+		{
+			setBound = true;
+			boundUniformOffset = item.uniformOffset;
+			result.descriptorBinds++;
+		}
+		else
+		{
+			result.descriptorBindsSkipped++;
+		}
+		result.draws++;
+	}
+	return result;
+}
+
+}
@@ -0,0 +1,112 @@
+#pragma once
+
+#include "vwdw_pipeline.hpp"
+#include "model.hpp"
+#include "v_bindless.hpp"
+#include "v_handle_pool.hpp"
+
+#include <cstdint>
+#include <vector>
+
+namespace vwdw {
+
+	// small per draw data that goes through vkCmdPushConstants instead of the uniform ring,
+	// the handles index the bindless table's arrays
+	struct VObjectPushConstants {
+		glm::mat4 model{ 1.0f };
+		uint32_t texture = VBindlessTable::INVALID_HANDLE;
+		uint32_t materialBuffer = VBindlessTable::INVALID_HANDLE;
+		uint32_t padding[2] = { 0, 0 };
+	};
+
+	// what a sorted draw actually needs at record time. pipeline and mesh are handles into the
+	// pools in VDrawBindings, they only have to stay live until record()
+	struct VDrawItem {
+		VPipelineHandle pipeline;
+		VMeshHandle mesh;
+		// pushed as VObjectPushConstants, must stay valid until record()
+		const glm::mat4* transform = nullptr;
+		// dynamic offset of the draw's block in the uniform ring
+		uint32_t uniformOffset = 0;
+		VBindlessTable::Handle texture = VBindlessTable::INVALID_HANDLE;
+		VBindlessTable::Handle materialBuffer = VBindlessTable::INVALID_HANDLE;
+		uint32_t object = 0;
+	};
+
+	// state shared by every draw in the queue
+	struct VDrawBindings {
+		VHandlePool<VwdwPipeline>* pipelines = nullptr;
+		VHandlePool<VModel>* meshes = nullptr;
+		VkPipelineLayout pipelineLayout = VK_NULL_HANDLE;
+		// set 0, binding 0 is per frame data and binding 1 per draw data, both dynamic
+		VkDescriptorSet uniformSet = VK_NULL_HANDLE;
+		uint32_t frameUniformOffset = 0;
+		// set 1, bound once up front, null when the device has no descriptor indexing
+		VkDescriptorSet bindlessSet = VK_NULL_HANDLE;
+	};
+
+	// draws are queued as a packed 64 bit key plus a payload, radix sorted by key, then recorded
+	// in that order so draws sharing a pipeline / mesh end up next to each other
+	class VRenderQueue {
+	public:
+		// key layout, most significant first:
+		// pass 4 | pipeline 12 | descriptor set 12 | mesh 16 | depth 20
+		static constexpr uint32_t PASS_BITS = 4;
+		static constexpr uint32_t PIPELINE_BITS = 12;
+		static constexpr uint32_t DESCRIPTOR_SET_BITS = 12;
+		static constexpr uint32_t MESH_BITS = 16;
+		static constexpr uint32_t DEPTH_BITS = 20;
+
+		// pass ids, the pre-pass sorts ahead of everything it fills depth for
+		static constexpr uint32_t PASS_DEPTH_PREPASS = 0;
+		static constexpr uint32_t PASS_OPAQUE = 1;
+
+		struct Stats {
+			uint32_t draws = 0;
+			uint32_t pipelineBinds = 0;
+			uint32_t pipelineBindsSkipped = 0;
+			uint32_t vertexBinds = 0;
+			uint32_t vertexBindsSkipped = 0;
+			uint32_t descriptorBinds = 0;
+			uint32_t descriptorBindsSkipped = 0;
+		};
+
+		VRenderQueue() = default;
+		~VRenderQueue() = default;
+
+		VRenderQueue(const VRenderQueue&) = delete;
+		VRenderQueue& operator=(const VRenderQueue&) = delete;
+
+		// depth is 0..1 (near..far), values outside are clamped
+		static uint64_t makeKey(uint32_t pass, uint32_t pipeline, uint32_t descriptorSet, uint32_t mesh, float depth);
+
+		void reserve(uint32_t draws);
+		void clear();
+		void push(uint64_t key, const VDrawItem& item);
+		uint32_t size() const { return static_cast<uint32_t>(entries.size()); }
+
+		void sort();
+		// binds and draws in sorted order, skipping binds that match what's already bound
+		void record(VkCommandBuffer commandBuffer, const VDrawBindings& bindings);
+
+		// walks the sorted order and counts the binds record() would issue, without touching vulkan
+		Stats simulate() const;
+		const Stats& getStats() const { return stats; }
+		// running totals over every record() call
+		const Stats& getTotals() const { return totals; }
+		const VDrawItem& itemAt(uint32_t sortedIndex) const { return items[entries[sortedIndex].item]; }
+
+	private:
+		struct Entry {
+			uint64_t key;
+			uint32_t item;
+		};
+
+		std::vector<Entry> entries;
+		std::vector<Entry> scratch;
+		std::vector<VDrawItem> items;
+		Stats stats;
+		Stats totals;
+	};
+
+}
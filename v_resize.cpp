@@ -0,0 +1,45 @@
+#include "v_resize.hpp"
+
+#include <algorithm>
+
+namespace vwdw {
+
+void VResizeCoalescer::request(Clock::time_point now)
+{
+	pending = true;
+	lastRequest = now;
+}
+
+bool VResizeCoalescer::shouldRecreate(Clock::time_point now, bool outOfDate) const
+{
+	return outOfDate || (pending && now - lastRequest >= SETTLE_TIME);
+}
+
+void VResizeCoalescer::recreated()
+{
+	pending = false;
+}
+
+static uint32_t withHeadroom(uint32_t size, uint32_t maxDimension)
+{
+	uint32_t grown = size + size / 4;
+	grown = (grown + ATTACHMENT_GRANULARITY - 1) / ATTACHMENT_GRANULARITY * ATTACHMENT_GRANULARITY;
+	return std::max(std::min(grown, maxDimension), size);
+}
+
+VkExtent2D attachmentCapacityFor(VkExtent2D extent, uint32_t maxDimension)
+{
+	return { withHeadroom(extent.width, maxDimension), withHeadroom(extent.height, maxDimension) };
+}
+
+bool attachmentCapacityFits(VkExtent2D capacity, VkExtent2D extent)
+{
+	if (extent.width > capacity.width || extent.height > capacity.height)
+	{
+		return false;
+	}
+	uint64_t needed = std::max<uint64_t>(uint64_t(extent.width) * extent.height, 1);
+	return uint64_t(capacity.width) * capacity.height <= needed * ATTACHMENT_MAX_WASTE;
+}
+
+}
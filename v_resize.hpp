@@ -0,0 +1,45 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+
+#include <chrono>
+#include <cstdint>
+
+namespace vwdw {
+
+	// decides when a window resize is worth a swapchain rebuild. dragging a window edge fires size
+	// events far faster than frames, and every rebuild waits for the device. a swapchain that is only
+	// suboptimal can keep presenting (stretched), so its rebuild waits until the size has held still
+	// for SETTLE_TIME. one that is out of date can't be presented to and is rebuilt on the next frame,
+	// which still means at most one rebuild per frame however many events came in between
+	class VResizeCoalescer {
+	public:
+		using Clock = std::chrono::steady_clock;
+
+		static constexpr Clock::duration SETTLE_TIME = std::chrono::milliseconds(100);
+
+		// a size event, or a present that came back suboptimal
+		void request(Clock::time_point now);
+		// call once per frame before acquiring. outOfDate is the last acquire / present's verdict
+		bool shouldRecreate(Clock::time_point now, bool outOfDate) const;
+		void recreated();
+
+		bool isPending() const { return pending; }
+
+	private:
+		bool pending = false;
+		Clock::time_point lastRequest{};
+	};
+
+	// size dependent attachments (depth...) are allocated with headroom so a shrink, or growing by
+	// less than the headroom, reuses them. callers render into the top left extent of the attachment
+
+	// what to allocate for extent: a quarter bigger, rounded up to ATTACHMENT_GRANULARITY, clamped to maxDimension
+	VkExtent2D attachmentCapacityFor(VkExtent2D extent, uint32_t maxDimension);
+	// true while capacity still covers extent without wasting more than ATTACHMENT_MAX_WASTE times its area
+	bool attachmentCapacityFits(VkExtent2D capacity, VkExtent2D extent);
+
+	constexpr uint32_t ATTACHMENT_GRANULARITY = 64;
+	constexpr uint32_t ATTACHMENT_MAX_WASTE = 4;
+
+}
@@ -0,0 +1,234 @@
+#include "v_scene.hpp"
+
+#include <algorithm>
+#include <cassert>
+
+#if defined(__SSE2__) || defined(_M_X64) || defined(_M_IX86)
+#define VWDW_SCENE_SIMD
+#include <immintrin.h>
+#endif
+
+namespace vwdw {
+
+VScene::NodeId VScene::createNode(NodeId parent, const glm::mat4& localTransform, uint32_t meshId)
+{
+	assert((parent == NO_NODE || parent < nodeSlot.size()) && "parent node does not exist");
+
+	// new nodes go on the end, the breadth first order is rebuilt on the next update
+	NodeId node = static_cast<NodeId>(nodeSlot.size());
+	uint32_t slot = static_cast<uint32_t>(local.size());
+	nodeSlot.push_back(slot);
+
+	local.push_back(localTransform);
+	world.push_back(localTransform);
+	parentSlot.push_back(parent == NO_NODE ? NO_NODE : nodeSlot[parent]);
+	firstChild.push_back(0);
+	childCount.push_back(0);
+	mesh.push_back(meshId);
+	slotNode.push_back(node);
+	dirty.push_back(1);
+
+	orderDirty = true;
+	return node;
+}
+
+void VScene::reserve(uint32_t nodes)
+{
+	nodeSlot.reserve(nodes);
+	local.reserve(nodes);
+	world.reserve(nodes);
+	parentSlot.reserve(nodes);
+	firstChild.reserve(nodes);
+	childCount.reserve(nodes);
+	mesh.reserve(nodes);
+	slotNode.reserve(nodes);
+	dirty.reserve(nodes);
+	changed.reserve(nodes);
+}
+
+void VScene::setLocalTransform(NodeId node, const glm::mat4& localTransform)
+{
+	uint32_t slot = nodeSlot[node];
+	local[slot] = localTransform;
+	if (!dirty[slot])
+	{
+		dirty[slot] = 1;
+		dirtyRoots.push_back(slot);
+	}
+}
+
+void VScene::rebuildOrder()
+{
+	uint32_t count = static_cast<uint32_t>(local.size());
+
+	// children lists by old slot
+	std::vector<uint32_t> childStart(count + 1, 0);
+	for (uint32_t s = 0; s < count; s++)
+	{
+		if (parentSlot[s] != NO_NODE)
+		{
+			childStart[parentSlot[s] + 1]++;
+		}
+	}
+	for (uint32_t s = 0; s < count; s++)
+	{
+		childStart[s + 1] += childStart[s];
+	}
+	std::vector<uint32_t> children(childStart[count]);
+	std::vector<uint32_t> fill(childStart.begin(), childStart.end() - 1);
+	for (uint32_t s = 0; s < count; s++)
+	{
+		if (parentSlot[s] != NO_NODE)
+		{
+			children[fill[parentSlot[s]]++] = s;
+		}
+	}
+
+	// breadth first walk, appending a node's children as it's visited keeps sibling lists contiguous
+	std::vector<uint32_t> order;
+	order.reserve(count);
+	for (uint32_t s = 0; s < count; s++)
+	{
+		if (parentSlot[s] == NO_NODE)
+		{
+			order.push_back(s);
+		}
+	}
+	std::vector<uint32_t> newFirstChild(count);
+	std::vector<uint32_t> newChildCount(count);
+	for (uint32_t i = 0; i < order.size(); i++)
+	{
+		uint32_t s = order[i];
+		newFirstChild[i] = static_cast<uint32_t>(order.size());
+		order.insert(order.end(), children.begin() + childStart[s], children.begin() + childStart[s + 1]);
+		newChildCount[i] = static_cast<uint32_t>(order.size()) - newFirstChild[i];
+	}
+	assert(order.size() == count && "scene hierarchy has a cycle");
+
+	std::vector<uint32_t> oldToNew(count);
+	for (uint32_t i = 0; i < count; i++)
+	{
+		oldToNew[order[i]] = i;
+	}
+
+	std::vector<glm::mat4> newLocal(count);
+	std::vector<uint32_t> newParent(count);
+	std::vector<uint32_t> newMesh(count);
+	std::vector<NodeId> newSlotNode(count);
+	for (uint32_t i = 0; i < count; i++)
+	{
+		uint32_t s = order[i];
+		newLocal[i] = local[s];
+		newParent[i] = parentSlot[s] == NO_NODE ? NO_NODE : oldToNew[parentSlot[s]];
+		newMesh[i] = mesh[s];
+		newSlotNode[i] = slotNode[s];
+		nodeSlot[slotNode[s]] = i;
+	}
+
+	local.swap(newLocal);
+	parentSlot.swap(newParent);
+	mesh.swap(newMesh);
+	slotNode.swap(newSlotNode);
+	firstChild.swap(newFirstChild);
+	childCount.swap(newChildCount);
+
+	orderDirty = false;
+}
+
+#ifdef VWDW_SCENE_SIMD
+// out = parent * child for column major 4x4, parent columns already loaded
+static inline void multiplyColumns(const __m128 p[4], const glm::mat4& child, glm::mat4& out)
+{
+	for (int c = 0; c < 4; c++)
+	{
+		const float* col = &child[c][0];
+		__m128 r = _mm_mul_ps(p[0], _mm_set1_ps(col[0]));
+		r = _mm_add_ps(r, _mm_mul_ps(p[1], _mm_set1_ps(col[1])));
+		r = _mm_add_ps(r, _mm_mul_ps(p[2], _mm_set1_ps(col[2])));
+		r = _mm_add_ps(r, _mm_mul_ps(p[3], _mm_set1_ps(col[3])));
+		_mm_storeu_ps(&out[c][0], r);
+	}
+}
+#endif
+
+void VScene::updateRange(uint32_t first, uint32_t last)
+{
+#ifdef VWDW_SCENE_SIMD
+	// siblings are adjacent, so the parent's columns only get reloaded when the parent changes
+	uint32_t loadedParent = NO_NODE;
+	__m128 p[4];
+	for (uint32_t s = first; s < last; s++)
+	{
+		uint32_t parent = parentSlot[s];
+		if (parent == NO_NODE)
+		{
+			world[s] = local[s];
+		}
+		else
+		{
+			if (parent != loadedParent)
+			{
+				const float* pw = &world[parent][0][0];
+				p[0] = _mm_loadu_ps(pw);
+				p[1] = _mm_loadu_ps(pw + 4);
+				p[2] = _mm_loadu_ps(pw + 8);
+				p[3] = _mm_loadu_ps(pw + 12);
+				loadedParent = parent;
+			}
+			multiplyColumns(p, local[s], world[s]);
+		}
+		dirty[s] = 0;
+		changed.push_back(slotNode[s]);
+	}
+#else
+	for (uint32_t s = first; s < last; s++)
+	{
+		world[s] = parentSlot[s] == NO_NODE ? local[s] : world[parentSlot[s]] * local[s];
+		dirty[s] = 0;
+		changed.push_back(slotNode[s]);
+	}
+#endif
+}
+
+const std::vector<VScene::NodeId>& VScene::update()
+{
+	changed.clear();
+
+	if (orderDirty)
+	{
+		// structure changed, recompute everything once in the new order
+		rebuildOrder();
+		dirtyRoots.clear();
+		updateRange(0, static_cast<uint32_t>(local.size()));
+		return changed;
+	}
+
+	if (dirtyRoots.empty())
+	{
+		return changed;
+	}
+
+	// ancestors sort before descendants, so a subtree that's already been covered is skipped
+	std::sort(dirtyRoots.begin(), dirtyRoots.end());
+	for (uint32_t root : dirtyRoots)
+	{
+		if (!dirty[root])
+		{
+			continue;
+		}
+
+		uint32_t first = root;
+		uint32_t last = root + 1;
+		while (first < last)
+		{
+			updateRange(first, last);
+			uint32_t nextFirst = firstChild[first];
+			last = firstChild[last - 1] + childCount[last - 1];
+			first = nextFirst;
+		}
+	}
+	dirtyRoots.clear();
+	return changed;
+}
+
+}
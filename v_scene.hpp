@@ -0,0 +1,63 @@
+#pragma once
+
+#define GLM_FORCE_RADIANS
+#define GLM_FORCE_DEPTH_ZERO_TO_ONE
+#include<glm/glm.hpp>
+
+#include <cstdint>
+#include <vector>
+
+namespace vwdw {
+
+	// transform hierarchy stored as structure of arrays in breadth first order.
+	// every depth level is contiguous and so is each node's list of children, which means
+	// a dirty subtree is just one contiguous range per level below it
+	class VScene {
+	public:
+		using NodeId = uint32_t;
+		static constexpr NodeId NO_NODE = 0xFFFFFFFF;
+		static constexpr uint32_t NO_MESH = 0xFFFFFFFF;
+
+		VScene() = default;
+		~VScene() = default;
+
+		VScene(const VScene&) = delete;
+		VScene& operator=(const VScene&) = delete;
+
+		NodeId createNode(NodeId parent = NO_NODE, const glm::mat4& localTransform = glm::mat4{ 1.0f }, uint32_t mesh = NO_MESH);
+		void reserve(uint32_t nodes);
+
+		void setLocalTransform(NodeId node, const glm::mat4& localTransform);
+		const glm::mat4& getLocalTransform(NodeId node) const { return local[nodeSlot[node]]; }
+		const glm::mat4& getWorldTransform(NodeId node) const { return world[nodeSlot[node]]; }
+		uint32_t getMesh(NodeId node) const { return mesh[nodeSlot[node]]; }
+		uint32_t nodeCount() const { return static_cast<uint32_t>(nodeSlot.size()); }
+
+		// recomputes world transforms of dirty subtrees only, returns the nodes whose world transform changed.
+		// a frame where nothing moved costs nothing
+		const std::vector<NodeId>& update();
+		const std::vector<NodeId>& changedNodes() const { return changed; }
+
+	private:
+		void rebuildOrder();
+		void updateRange(uint32_t first, uint32_t last);
+
+		// indexed by NodeId
+		std::vector<uint32_t> nodeSlot;
+
+		// indexed by slot (breadth first position)
+		std::vector<glm::mat4> local;
+		std::vector<glm::mat4> world;
+		std::vector<uint32_t> parentSlot;
+		std::vector<uint32_t> firstChild;
+		std::vector<uint32_t> childCount;
+		std::vector<uint32_t> mesh;
+		std::vector<NodeId> slotNode;
+		std::vector<uint8_t> dirty;
+
+		std::vector<uint32_t> dirtyRoots;
+		std::vector<NodeId> changed;
+		bool orderDirty = false;
+	};
+
+}
@@ -0,0 +1,241 @@
+#include "v_shader_compiler.hpp"
+#include "v_cooker.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <stdexcept>
+
+namespace fs = std::filesystem;
+
+namespace vwdw {
+
+// bump when anything about how modules are compiled changes without showing up in the key
+static constexpr uint32_t SHADER_CACHE_VERSION = 1;
+
+static bool shaderKindFor(const std::string& path, shaderc_shader_kind& kind)
+{
+	std::string extension = fs::path(path).extension().string();
+	std::transform(extension.begin(), extension.end(), extension.begin(), [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+	if (extension == ".vert") { kind = shaderc_vertex_shader; return true; }
+	if (extension == ".frag") { kind = shaderc_fragment_shader; return true; }
+	if (extension == ".comp") { kind = shaderc_compute_shader; return true; }
+	if (extension == ".geom") { kind = shaderc_geometry_shader; return true; }
+	if (extension == ".tesc") { kind = shaderc_tess_control_shader; return true; }
+	if (extension == ".tese") { kind = shaderc_tess_evaluation_shader; return true; }
+	return false;
+}
+
+bool VShaderCompiler::isShaderSource(const std::string& path)
+{
+	shaderc_shader_kind kind;
+	return shaderKindFor(path, kind);
+}
+
+VShaderCompiler::VShaderCompiler(const std::string& cacheDir, ShaderOptimization optimization)
+	: compiler{ shaderc_compiler_initialize() }, cacheDir{ cacheDir }, optimization{ optimization }
+{
+	if (compiler == nullptr)
+	{
+		throw std::runtime_error("failed to initialize shader compiler");
+	}
+	unsigned int version = 0;
+	unsigned int revision = 0;
+	shaderc_get_spv_version(&version, &revision);
+	spirvVersion = version;
+
+	if (!cacheDir.empty())
+	{
+		std::error_code ec;
+		fs::create_directories(cacheDir, ec);
+	}
+}
+
+VShaderCompiler::~VShaderCompiler()
+{
+	shaderc_compiler_release(compiler);
+}
+
+uint64_t VShaderCompiler::cacheKey(const std::string& source, shaderc_shader_kind kind, const std::vector<ShaderDefine>& defines) const
+{
+	uint64_t h = hashBytes(&SHADER_CACHE_VERSION, sizeof(SHADER_CACHE_VERSION));
+	h = hashBytes(&spirvVersion, sizeof(spirvVersion), h);
+	h = hashBytes(&kind, sizeof(kind), h);
+	h = hashBytes(&optimization, sizeof(optimization), h);
+	for (const ShaderDefine& define : defines)
+	{
+		// the terminators keep "AB"="" and "A"="B" apart
+		h = hashBytes(define.name.c_str(), define.name.size() + 1, h);
+		h = hashBytes(define.value.c_str(), define.value.size() + 1, h);
+	}
+	return hashBytes(source.data(), source.size(), h);
+}
+
+bool VShaderCompiler::readCached(const std::string& path, std::vector<uint32_t>& spirv)
+{
+	if (cacheDir.empty())
+	{
+		return false;
+	}
+	std::ifstream file{ path, std::ios::binary | std::ios::ate };
+	if (!file.is_open())
+	{
+		return false;
+	}
+	size_t size = static_cast<size_t>(file.tellg());
+	if (size < 20 || size % 4 != 0)
+	{
+		return false;
+	}
+	spirv.resize(size / 4);
+	file.seekg(0);
+	file.read(reinterpret_cast<char*>(spirv.data()), static_cast<std::streamsize>(size));
+	return file.good() && spirv[0] == 0x07230203;
+}
+
+// written next to the entry then renamed over it, a reader never sees half a module
+void VShaderCompiler::writeCached(const std::string& path, const std::vector<uint32_t>& spirv)
+{
+	if (cacheDir.empty())
+	{
+		return;
+	}
+	std::lock_guard<std::mutex> lock{ mutex };
+	std::string temp = path + ".tmp";
+	{
+		std::ofstream file{ temp, std::ios::binary | std::ios::trunc };
+		if (!file.is_open())
+		{
+			return;
+		}
+		file.write(reinterpret_cast<const char*>(spirv.data()), static_cast<std::streamsize>(spirv.size() * sizeof(uint32_t)));
+		if (!file.good())
+		{
+			return;
+		}
+	}
+	std::error_code ec;
+	fs::rename(temp, path, ec);
+	if (ec)
+	{
+		fs::remove(temp, ec);
+	}
+}
+
+void VShaderCompiler::rememberDefines(const std::string& sourcePath, const std::vector<ShaderDefine>& defines)
+{
+	std::lock_guard<std::mutex> lock{ mutex };
+	auto& sets = usedDefines[fs::path(sourcePath).lexically_normal().generic_string()];
+	if (std::find(sets.begin(), sets.end(), defines) == sets.end())
+	{
+		sets.push_back(defines);
+	}
+}
+
+std::vector<std::vector<ShaderDefine>> VShaderCompiler::definesUsedWith(const std::string& sourcePath)
+{
+	std::lock_guard<std::mutex> lock{ mutex };
+	auto it = usedDefines.find(fs::path(sourcePath).lexically_normal().generic_string());
+	if (it == usedDefines.end())
+	{
+		return {};
+	}
+	return it->second;
+}
+
+bool VShaderCompiler::compile(const std::string& sourcePath, const std::vector<ShaderDefine>& defines, std::vector<uint32_t>& spirv, std::string& error)
+{
+	std::ifstream file{ sourcePath, std::ios::binary };
+	if (!file.is_open())
+	{
+		error = "failed to open file: " + sourcePath;
+		return false;
+	}
+	std::string source{ std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>() };
+	rememberDefines(sourcePath, defines);
+	return compileSource(source, sourcePath, defines, spirv, error);
+}
+
+bool VShaderCompiler::compileSource(const std::string& source, const std::string& sourcePath, const std::vector<ShaderDefine>& defines, std::vector<uint32_t>& spirv, std::string& error)
+{
+	shaderc_shader_kind kind;
+	if (!shaderKindFor(sourcePath, kind))
+	{
+		error = sourcePath + ": unknown shader stage";
+		return false;
+	}
+
+	char name[17];
+	std::snprintf(name, sizeof(name), "%016llx", static_cast<unsigned long long>(cacheKey(source, kind, defines)));
+	std::string cachePath = (fs::path(cacheDir) / (std::string(name) + ".spv")).string();
+	if (readCached(cachePath, spirv))
+	{
+		hits.fetch_add(1, std::memory_order_relaxed);
+		return true;
+	}
+
+	shaderc_compile_options_t options = shaderc_compile_options_initialize();
+	shaderc_compile_options_set_target_env(options, shaderc_target_env_vulkan, shaderc_env_version_vulkan_1_2);
+	switch (optimization)
+	{
+	case ShaderOptimization::None: shaderc_compile_options_set_optimization_level(options, shaderc_optimization_level_zero); break;
+	case ShaderOptimization::Size: shaderc_compile_options_set_optimization_level(options, shaderc_optimization_level_size); break;
+	case ShaderOptimization::Performance: shaderc_compile_options_set_optimization_level(options, shaderc_optimization_level_performance); break;
+	}
+	for (const ShaderDefine& define : defines)
+	{
+		shaderc_compile_options_add_macro_definition(options, define.name.data(), define.name.size(), define.value.data(), define.value.size());
+	}
+
+	shaderc_compilation_result_t result = shaderc_compile_into_spv(compiler, source.data(), source.size(), kind, sourcePath.c_str(), "main", options);
+	bool ok = shaderc_result_get_compilation_status(result) == shaderc_compilation_status_success;
+	if (ok)
+	{
+		size_t size = shaderc_result_get_length(result);
+		spirv.resize(size / 4);
+		std::memcpy(spirv.data(), shaderc_result_get_bytes(result), size);
+	}
+	else
+	{
+		error = shaderc_result_get_error_message(result);
+	}
+	shaderc_result_release(result);
+	shaderc_compile_options_release(options);
+	if (!ok)
+	{
+		return false;
+	}
+
+	compiled.fetch_add(1, std::memory_order_relaxed);
+	writeCached(cachePath, spirv);
+	return true;
+}
+
+std::vector<char> VShaderCompiler::load(const std::string& path, const std::vector<ShaderDefine>& defines)
+{
+	if (fs::path(path).extension() == ".spv")
+	{
+		std::ifstream file{ path, std::ios::binary };
+		if (!file.is_open())
+		{
+			throw std::runtime_error("failed to open file: " + path);
+		}
+		return std::vector<char>{ std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>() };
+	}
+
+	std::vector<uint32_t> spirv;
+	std::string error;
+	if (!compile(path, defines, spirv, error))
+	{
+		throw std::runtime_error("failed to compile shader " + path + ":\n" + error);
+	}
+	std::vector<char> code(spirv.size() * sizeof(uint32_t));
+	std::memcpy(code.data(), spirv.data(), code.size());
+	return code;
+}
+
+}
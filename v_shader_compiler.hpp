@@ -0,0 +1,69 @@
+#pragma once
+
+#include <shaderc/shaderc.h>
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace vwdw {
+
+	enum class ShaderOptimization { None, Size, Performance };
+
+	struct ShaderDefine {
+		std::string name;
+		std::string value;
+
+		bool operator==(const ShaderDefine& other) const { return name == other.name && value == other.value; }
+	};
+
+	// glsl -> spir-v in process (shaderc), with its optimizer run over the result. every module is
+	// kept in cacheDir under a hash of the source, stage, defines and optimization level, so a shader
+	// that hasn't changed is read back instead of compiled again, also across runs. #include isn't
+	// supported, the hash only covers the file itself. compile() can be called from any thread
+	class VShaderCompiler {
+	public:
+		// an empty cacheDir keeps nothing on disk
+		VShaderCompiler(const std::string& cacheDir, ShaderOptimization optimization = ShaderOptimization::Performance);
+		~VShaderCompiler();
+
+		VShaderCompiler(const VShaderCompiler&) = delete;
+		VShaderCompiler& operator=(const VShaderCompiler&) = delete;
+
+		// the stage comes from the extension: .vert .frag .comp .geom .tesc .tese
+		bool compile(const std::string& sourcePath, const std::vector<ShaderDefine>& defines, std::vector<uint32_t>& spirv, std::string& error);
+		// source already in memory, sourcePath only names it and picks the stage
+		bool compileSource(const std::string& source, const std::string& sourcePath, const std::vector<ShaderDefine>& defines, std::vector<uint32_t>& spirv, std::string& error);
+		// for the pipelines: .spv files are read as they are, glsl goes through compile(). throws on failure
+		std::vector<char> load(const std::string& path, const std::vector<ShaderDefine>& defines = {});
+
+		// every define set sourcePath has been compiled with, a changed file is rebuilt with each of them
+		std::vector<std::vector<ShaderDefine>> definesUsedWith(const std::string& sourcePath);
+
+		static bool isShaderSource(const std::string& path);
+
+		uint32_t cacheHits() const { return hits.load(std::memory_order_relaxed); }
+		uint32_t compileCount() const { return compiled.load(std::memory_order_relaxed); }
+
+	private:
+		uint64_t cacheKey(const std::string& source, shaderc_shader_kind kind, const std::vector<ShaderDefine>& defines) const;
+		bool readCached(const std::string& path, std::vector<uint32_t>& spirv);
+		void writeCached(const std::string& path, const std::vector<uint32_t>& spirv);
+		void rememberDefines(const std::string& sourcePath, const std::vector<ShaderDefine>& defines);
+
+		shaderc_compiler_t compiler;
+		std::string cacheDir;
+		ShaderOptimization optimization;
+		// the spir-v version shaderc targets, part of every key so a compiler update misses the cache
+		uint32_t spirvVersion = 0;
+
+		std::mutex mutex;
+		std::unordered_map<std::string, std::vector<std::vector<ShaderDefine>>> usedDefines;
+		std::atomic<uint32_t> hits{ 0 };
+		std::atomic<uint32_t> compiled{ 0 };
+	};
+
+}
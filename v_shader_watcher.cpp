@@ -0,0 +1,176 @@
+#include "v_shader_watcher.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+
+#ifdef __linux__
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+namespace fs = std::filesystem;
+
+namespace vwdw {
+
+VShaderWatcher::VShaderWatcher(VShaderCompiler& compiler, const std::string& dir)
+	: compiler{ compiler }, dir{ dir }
+{
+#ifdef __linux__
+	// close_write for editors that save in place, moved_to for the ones that write a temp file and rename it
+	inotifyFd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+	if (inotifyFd < 0 || inotify_add_watch(inotifyFd, dir.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO) < 0)
+	{
+		if (inotifyFd >= 0)
+		{
+			close(inotifyFd);
+		}
+		throw std::runtime_error("failed to watch " + dir);
+	}
+#else
+	std::vector<std::string> unused;
+	waitForChanges(unused, Clock::duration::zero());
+#endif
+	thread = std::thread([this]() { watch(); });
+}
+
+VShaderWatcher::~VShaderWatcher()
+{
+	running.store(false, std::memory_order_release);
+	thread.join();
+#ifdef __linux__
+	close(inotifyFd);
+#endif
+}
+
+std::vector<VShaderWatcher::Reload> VShaderWatcher::takeReloads()
+{
+	std::vector<Reload> taken;
+	std::lock_guard<std::mutex> lock{ mutex };
+	taken.swap(finished);
+	return taken;
+}
+
+void VShaderWatcher::watch()
+{
+	std::vector<std::string> changed;
+	Clock::time_point lastChange{};
+	while (running.load(std::memory_order_acquire))
+	{
+		if (waitForChanges(changed, changed.empty() ? POLL_INTERVAL : SETTLE_TIME))
+		{
+			lastChange = Clock::now();
+		}
+		else if (!changed.empty() && Clock::now() - lastChange >= SETTLE_TIME)
+		{
+			recompile(changed);
+			changed.clear();
+		}
+	}
+}
+
+bool VShaderWatcher::noteChange(std::vector<std::string>& changed, const std::string& name)
+{
+	if (!VShaderCompiler::isShaderSource(name))
+	{
+		return false;
+	}
+	std::string path = (fs::path(dir) / name).generic_string();
+	if (std::find(changed.begin(), changed.end(), path) == changed.end())
+	{
+		changed.push_back(path);
+	}
+	return true;
+}
+
+#ifdef __linux__
+
+bool VShaderWatcher::waitForChanges(std::vector<std::string>& changed, Clock::duration timeout)
+{
+	pollfd pfd{ inotifyFd, POLLIN, 0 };
+	int ms = static_cast<int>(std::chrono::duration_cast<std::chrono::milliseconds>(timeout).count());
+	if (poll(&pfd, 1, ms) <= 0)
+	{
+		return false;
+	}
+
+	bool any = false;
+	alignas(inotify_event) char buffer[4096];
+	ssize_t length;
+	while ((length = read(inotifyFd, buffer, sizeof(buffer))) > 0)
+	{
+		for (char* p = buffer; p < buffer + length; )
+		{
+			const inotify_event* event = reinterpret_cast<const inotify_event*>(p);
+			if (event->len > 0)
+			{
+				any |= noteChange(changed, event->name);
+			}
+			p += sizeof(inotify_event) + event->len;
+		}
+	}
+	return any;
+}
+
+#else
+
+bool VShaderWatcher::waitForChanges(std::vector<std::string>& changed, Clock::duration timeout)
+{
+	std::this_thread::sleep_for(timeout);
+
+	bool any = false;
+	std::error_code ec;
+	for (const auto& entry : fs::directory_iterator(dir, ec))
+	{
+		std::string name = entry.path().filename().string();
+		fs::file_time_type time = entry.last_write_time(ec);
+		if (ec || !VShaderCompiler::isShaderSource(name))
+		{
+			continue;
+		}
+		auto known = std::find_if(writeTimes.begin(), writeTimes.end(), [&](const auto& entry) { return entry.first == name; });
+		if (known == writeTimes.end())
+		{
+			// the first scan only records what's there
+			writeTimes.emplace_back(name, time);
+			continue;
+		}
+		if (known->second != time)
+		{
+			known->second = time;
+			any |= noteChange(changed, name);
+		}
+	}
+	return any;
+}
+
+#endif
+
+void VShaderWatcher::recompile(const std::vector<std::string>& changed)
+{
+	std::vector<uint32_t> spirv;
+	for (const std::string& path : changed)
+	{
+		// never loaded, so no pipeline to rebuild either
+		auto defineSets = compiler.definesUsedWith(path);
+		if (defineSets.empty())
+		{
+			continue;
+		}
+		Reload reload{ path, true, {} };
+		for (const auto& defines : defineSets)
+		{
+			std::string error;
+			if (!compiler.compile(path, defines, spirv, error))
+			{
+				reload.compiled = false;
+				reload.error += error;
+			}
+		}
+
+		std::lock_guard<std::mutex> lock{ mutex };
+		finished.push_back(std::move(reload));
+	}
+}
+
+}
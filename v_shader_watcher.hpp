@@ -0,0 +1,64 @@
+#pragma once
+
+#include "v_shader_compiler.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <filesystem>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace vwdw {
+
+	// recompiles shader sources in a directory on a thread of its own as they're saved (inotify on
+	// linux, polling the write times elsewhere). only files that changed are compiled, once for each
+	// define set they were compiled with before, and the results land in the compiler's cache, so
+	// rebuilding the pipelines afterwards on the render thread doesn't compile anything
+	class VShaderWatcher {
+	public:
+		using Clock = std::chrono::steady_clock;
+
+		// a burst of saves (editors write more than once) is compiled once it has been quiet this long
+		static constexpr Clock::duration SETTLE_TIME = std::chrono::milliseconds(50);
+		static constexpr Clock::duration POLL_INTERVAL = std::chrono::milliseconds(250);
+
+		struct Reload {
+			std::string path;
+			bool compiled;
+			std::string error;
+		};
+
+		VShaderWatcher(VShaderCompiler& compiler, const std::string& dir);
+		~VShaderWatcher();
+
+		VShaderWatcher(const VShaderWatcher&) = delete;
+		VShaderWatcher& operator=(const VShaderWatcher&) = delete;
+
+		// render thread, everything finished since the last call. paths are dir/name with forward slashes
+		std::vector<Reload> takeReloads();
+
+	private:
+		void watch();
+		// blocks for up to timeout, false when nothing was saved in the meantime
+		bool waitForChanges(std::vector<std::string>& changed, Clock::duration timeout);
+		bool noteChange(std::vector<std::string>& changed, const std::string& name);
+		void recompile(const std::vector<std::string>& changed);
+
+		VShaderCompiler& compiler;
+		std::string dir;
+#ifdef __linux__
+		int inotifyFd = -1;
+#else
+		std::vector<std::pair<std::string, std::filesystem::file_time_type>> writeTimes;
+#endif
+
+		std::mutex mutex;
+		std::vector<Reload> finished;
+
+		std::thread thread;
+		std::atomic<bool> running{ true };
+	};
+
+}
@@ -0,0 +1,119 @@
+#include "v_simulation.hpp"
+
+#include <glm/gtc/matrix_transform.hpp>
+
+namespace vwdw {
+
+VSimulation::VSimulation(double stepsPerSecond)
+	: stepDuration{ std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(1.0 / stepsPerSecond)) },
+	stepSeconds{ static_cast<float>(1.0 / stepsPerSecond) }
+{
+}
+
+VSimulation::~VSimulation()
+{
+	stop();
+}
+
+uint32_t VSimulation::addBody(const VBody& body)
+{
+	bodies.push_back(body);
+	return static_cast<uint32_t>(bodies.size() - 1);
+}
+
+void VSimulation::reset(Clock::time_point now)
+{
+	simTime = now;
+	previousBodies = bodies;
+	publish();
+}
+
+void VSimulation::start()
+{
+	reset(Clock::now());
+	running = true;
+	thread = std::thread([this]() {
+		while (running.load(std::memory_order_relaxed))
+		{
+			advance(Clock::now());
+			std::this_thread::sleep_until(simTime + stepDuration);
+		}
+	});
+}
+
+void VSimulation::stop()
+{
+	running = false;
+	if (thread.joinable())
+	{
+		thread.join();
+	}
+}
+
+void VSimulation::advance(Clock::time_point now)
+{
+	uint32_t due = 0;
+	while (simTime + stepDuration <= now)
+	{
+		if (++due > MAX_CATCH_UP_STEPS)
+		{
+			// hopelessly behind, a slower world beats a spiral of ever longer catch ups
+			simTime = now;
+			break;
+		}
+		previousBodies = bodies;
+		step(stepSeconds);
+		simTime += stepDuration;
+	}
+	if (due > 0)
+	{
+		publish();
+	}
+}
+
+void VSimulation::step(float dt)
+{
+	for (auto& body : bodies)
+	{
+		body.position += body.velocity * dt;
+		body.angle += body.spin * dt;
+	}
+	steps.fetch_add(1, std::memory_order_relaxed);
+}
+
+void VSimulation::publish()
+{
+	// assignment reuses the slot's storage, nothing allocates once every slot has been written
+	VSimSnapshot& snapshot = snapshots.writeSlot();
+	snapshot.step = steps.load(std::memory_order_relaxed);
+	snapshot.previousTime = simTime - stepDuration;
+	snapshot.currentTime = simTime;
+	snapshot.previous = previousBodies;
+	snapshot.current = bodies;
+	snapshots.publish();
+}
+
+void VSimulation::interpolate(Clock::time_point now, std::vector<glm::mat4>& transforms)
+{
+	if (snapshots.acquire())
+	{
+		consumed++;
+	}
+	const VSimSnapshot& snapshot = snapshots.readSlot();
+
+	// one step behind, so now - step lands between the two states unless the simulation is late
+	float alpha = std::chrono::duration<float>(now - stepDuration - snapshot.previousTime).count() / stepSeconds;
+	alpha = glm::clamp(alpha, 0.0f, 1.0f);
+
+	transforms.resize(snapshot.current.size());
+	for (size_t i = 0; i < snapshot.current.size(); i++)
+	{
+		const VBody& from = i < snapshot.previous.size() ? snapshot.previous[i] : snapshot.current[i];
+		const VBody& to = snapshot.current[i];
+		glm::vec3 position = glm::mix(from.position, to.position, alpha);
+		float angle = glm::mix(from.angle, to.angle, alpha);
+		transforms[i] = glm::rotate(glm::translate(glm::mat4{ 1.0f }, position), angle, to.axis);
+	}
+}
+
+}
@@ -0,0 +1,96 @@
+#pragma once
+
+#define GLM_FORCE_RADIANS
+#define GLM_FORCE_DEPTH_ZERO_TO_ONE
+#include<glm/glm.hpp>
+
+#include "v_triple_buffer.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+namespace vwdw {
+
+	// a rigid body moving at constant velocity and spinning about a fixed axis
+	struct VBody {
+		glm::vec3 position{ 0.0f };
+		glm::vec3 velocity{ 0.0f };
+		glm::vec3 axis{ 0.0f, 0.0f, 1.0f };
+		// radians, kept unwrapped so interpolating between two steps never goes the long way round
+		float angle = 0.0f;
+		// radians per second
+		float spin = 0.0f;
+	};
+
+	// the last two simulation states, published together so the reader can blend between them
+	struct VSimSnapshot {
+		uint64_t step = 0;
+		std::chrono::steady_clock::time_point previousTime;
+		std::chrono::steady_clock::time_point currentTime;
+		std::vector<VBody> previous;
+		std::vector<VBody> current;
+	};
+
+	// fixed timestep simulation. advance() runs every step that is due and publishes the result into a
+	// triple buffer, interpolate() picks up the newest snapshot and blends its two states at the time
+	// being rendered. both can run on the same thread, or advance() on a thread of its own via start()
+	// so simulation cost overlaps with recording and submission instead of adding to it.
+	// rendering runs one step behind the simulation so there is always a state on either side
+	class VSimulation {
+	public:
+		using Clock = std::chrono::steady_clock;
+
+		// steps falling further behind than this are dropped instead of caught up
+		static constexpr uint32_t MAX_CATCH_UP_STEPS = 8;
+
+		explicit VSimulation(double stepsPerSecond = 60.0);
+		~VSimulation();
+
+		VSimulation(const VSimulation&) = delete;
+		VSimulation& operator=(const VSimulation&) = delete;
+
+		// only before start(), the simulation thread owns the bodies from then on
+		uint32_t addBody(const VBody& body);
+		uint32_t bodyCount() const { return static_cast<uint32_t>(bodies.size()); }
+
+		// starts the clock and publishes the initial state
+		void reset(Clock::time_point now);
+		// reset() and keep calling advance() on a simulation thread until stop()
+		void start();
+		void stop();
+		bool isThreaded() const { return thread.joinable(); }
+
+		// simulation side
+		void advance(Clock::time_point now);
+
+		// render side, writes one world transform per body
+		void interpolate(Clock::time_point now, std::vector<glm::mat4>& transforms);
+
+		uint64_t stepCount() const { return steps.load(std::memory_order_relaxed); }
+		// snapshots the render side actually picked up, the rest were overwritten unseen
+		uint64_t snapshotsConsumed() const { return consumed; }
+
+	private:
+		void step(float dt);
+		void publish();
+
+		Clock::duration stepDuration;
+		float stepSeconds;
+
+		// simulation side only
+		std::vector<VBody> bodies;
+		std::vector<VBody> previousBodies;
+		Clock::time_point simTime;
+
+		VTripleBuffer<VSimSnapshot> snapshots;
+		std::atomic<uint64_t> steps{ 0 };
+		uint64_t consumed = 0;
+
+		std::thread thread;
+		std::atomic<bool> running{ false };
+	};
+
+}
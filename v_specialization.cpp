@@ -0,0 +1,211 @@
+#include "v_specialization.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+
+namespace vwdw {
+
+static uint64_t fnv1a(const void* bytes, size_t size, uint64_t hash)
+{
+	const uint8_t* p = static_cast<const uint8_t*>(bytes);
+	for (size_t i = 0; i < size; i++)
+	{
+		hash ^= p[i];
+		hash *= 0x100000001b3ull;
+	}
+	return hash;
+}
+
+VSpecializationConstants& VSpecializationConstants::set(uint32_t constantId, uint32_t value)
+{
+	setBytes(constantId, &value);
+	return *this;
+}
+
+VSpecializationConstants& VSpecializationConstants::set(uint32_t constantId, int32_t value)
+{
+	setBytes(constantId, &value);
+	return *this;
+}
+
+VSpecializationConstants& VSpecializationConstants::set(uint32_t constantId, float value)
+{
+	setBytes(constantId, &value);
+	return *this;
+}
+
+VSpecializationConstants& VSpecializationConstants::set(uint32_t constantId, bool value)
+{
+	VkBool32 b = value ? VK_TRUE : VK_FALSE;
+	setBytes(constantId, &b);
+	return *this;
+}
+
+void VSpecializationConstants::setBytes(uint32_t constantId, const void* value)
+{
+	constexpr uint32_t SIZE = 4;
+	auto it = std::lower_bound(entries.begin(), entries.end(), constantId,
+		[](const VkSpecializationMapEntry& entry, uint32_t id) { return entry.constantID < id; });
+	size_t index = static_cast<size_t>(it - entries.begin());
+
+	if (it == entries.end() || it->constantID != constantId)
+	{
+		entries.insert(it, VkSpecializationMapEntry{ constantId, 0, SIZE });
+		data.insert(data.begin() + index * SIZE, SIZE, 0);
+		for (size_t i = 0; i < entries.size(); i++)
+		{
+			entries[i].offset = static_cast<uint32_t>(i * SIZE);
+		}
+	}
+	std::memcpy(data.data() + index * SIZE, value, SIZE);
+}
+
+VkSpecializationInfo VSpecializationConstants::getInfo() const
+{
+	VkSpecializationInfo info{};
+	info.mapEntryCount = static_cast<uint32_t>(entries.size());
+	info.pMapEntries = entries.data();
+	info.dataSize = data.size();
+	info.pData = data.data();
+	return info;
+}
+
+uint64_t VSpecializationConstants::hash() const
+{
+	uint64_t h = 0xcbf29ce484222325ull;
+	for (const VkSpecializationMapEntry& entry : entries)
+	{
+		h = fnv1a(&entry.constantID, sizeof(entry.constantID), h);
+	}
+	return fnv1a(data.data(), data.size(), h);
+}
+
+bool VSpecializationConstants::operator==(const VSpecializationConstants& other) const
+{
+	if (entries.size() != other.entries.size() || data != other.data)
+	{
+		return false;
+	}
+	for (size_t i = 0; i < entries.size(); i++)
+	{
+		if (entries[i].constantID != other.entries[i].constantID)
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+bool VPipelineVariants::FixedState::operator==(const FixedState& other) const
+{
+	return cullMode == other.cullMode && frontFace == other.frontFace && polygonMode == other.polygonMode
+		&& depthTest == other.depthTest && depthWrite == other.depthWrite && depthCompare == other.depthCompare
+		&& blend == other.blend && colorWriteMask == other.colorWriteMask && positionOnly == other.positionOnly
+		&& vertexPulling == other.vertexPulling && renderPass == other.renderPass && colorFormat == other.colorFormat && depthFormat == other.depthFormat
+		&& pipelineLayout == other.pipelineLayout;
+}
+
+VPipelineVariants::FixedState VPipelineVariants::fixedStateOf(const PipelineConfigInfo& config)
+{
+	FixedState state{};
+	state.cullMode = config.rasterizationInfo.cullMode;
+	state.frontFace = config.rasterizationInfo.frontFace;
+	state.polygonMode = config.rasterizationInfo.polygonMode;
+	state.depthTest = config.depthStencilInfo.depthTestEnable;
+	state.depthWrite = config.depthStencilInfo.depthWriteEnable;
+	state.depthCompare = config.depthStencilInfo.depthCompareOp;
+	state.blend = config.colorBlendAttachment.blendEnable;
+	state.colorWriteMask = config.colorBlendAttachment.colorWriteMask;
+	state.positionOnly = config.positionOnly;
+	state.vertexPulling = config.vertexPulling;
+	state.renderPass = config.renderPass;
+	state.colorFormat = config.colorFormat;
+	state.depthFormat = config.depthFormat;
+	state.pipelineLayout = config.pipelineLayout;
+	return state;
+}
+
+VPipelineVariants::VPipelineVariants(VDevice& device, VHandlePool<VwdwPipeline>& pool, const std::string& vertPath, const std::string& fragPath)
+	: vDevice{ device }, pool{ pool }, vertPath{ vertPath }, fragPath{ fragPath }
+{
+}
+
+VPipelineVariants::~VPipelineVariants()
+{
+	clear();
+}
+
+uint32_t VPipelineVariants::getVariant(const PipelineConfigInfo& config, const VSpecializationConstants& constants)
+{
+	FixedState state = fixedStateOf(config);
+	// hashed field by field, the struct has padding
+	uint64_t h = constants.hash();
+	h = fnv1a(&state.cullMode, sizeof(state.cullMode), h);
+	h = fnv1a(&state.frontFace, sizeof(state.frontFace), h);
+	h = fnv1a(&state.polygonMode, sizeof(state.polygonMode), h);
+	h = fnv1a(&state.depthWrite, sizeof(state.depthWrite), h);
+	h = fnv1a(&state.depthCompare, sizeof(state.depthCompare), h);
+	h = fnv1a(&state.colorWriteMask, sizeof(state.colorWriteMask), h);
+	h = fnv1a(&state.renderPass, sizeof(state.renderPass), h);
+	h = fnv1a(&state.colorFormat, sizeof(state.colorFormat), h);
+
+	std::vector<uint32_t>& candidates = lookup[h];
+	for (uint32_t index : candidates)
+	{
+		if (variants[index].state == state && variants[index].constants == constants)
+		{
+			return index;
+		}
+	}
+
+	// the copy's pointers still lead back into config, moved over to its own members here
+	auto variantConfig = std::make_unique<PipelineConfigInfo>(config);
+	variantConfig->colorBlendInfo.pAttachments = config.colorBlendInfo.pAttachments != nullptr ? &variantConfig->colorBlendAttachment : nullptr;
+	variantConfig->dynamicStateInfo.pDynamicStates = variantConfig->dynamicStateEnables.data();
+	Variant variant{ state, constants, VPipelineHandle{}, std::move(variantConfig) };
+	variant.config->specializationInfo = variant.constants.getInfo();
+	variant.pipeline = pool.emplace(vDevice, *variant.config, vertPath, fragPath);
+	variants.push_back(std::move(variant));
+	uint32_t index = static_cast<uint32_t>(variants.size() - 1);
+	candidates.push_back(index);
+	return index;
+}
+
+void VPipelineVariants::clear()
+{
+	for (const Variant& variant : variants)
+	{
+		pool.release(variant.pipeline);
+	}
+	variants.clear();
+	lookup.clear();
+}
+
+bool VPipelineVariants::usesShader(const std::string& path) const
+{
+	auto normal = [](const std::string& p) { return std::filesystem::path(p).lexically_normal(); };
+	return normal(path) == normal(vertPath) || (!fragPath.empty() && normal(path) == normal(fragPath));
+}
+
+void VPipelineVariants::rebuild(std::vector<VPipelineHandle>& retired)
+{
+	for (Variant& variant : variants)
+	{
+		VPipelineHandle pipeline;
+		try
+		{
+			pipeline = pool.emplace(vDevice, *variant.config, vertPath, fragPath);
+		}
+		catch (const std::exception& e)
+		{
+			std::cerr << e.what() << std::endl;
+			continue;
+		}
+		retired.push_back(variant.pipeline);
+		variant.pipeline = pipeline;
+	}
+}
+
+}
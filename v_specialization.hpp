@@ -0,0 +1,105 @@
+#pragma once
+
+#include "vwdw_pipeline.hpp"
+#include "v_handle_pool.hpp"
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace vwdw {
+
+	// typed values for a shader's layout(constant_id = N) constants. the driver folds them in when the
+	// pipeline is built, so branches and loop counts on them cost nothing at run time. every type here is
+	// 4 bytes, bools go in as VkBool32 like the spec wants
+	class VSpecializationConstants {
+	public:
+		VSpecializationConstants& set(uint32_t constantId, uint32_t value);
+		VSpecializationConstants& set(uint32_t constantId, int32_t value);
+		VSpecializationConstants& set(uint32_t constantId, float value);
+		VSpecializationConstants& set(uint32_t constantId, bool value);
+
+		bool empty() const { return entries.empty(); }
+		// points into this object, keep it alive until the pipeline is created
+		VkSpecializationInfo getInfo() const;
+
+		// entries are kept sorted by id, so the order constants were set in doesn't matter
+		uint64_t hash() const;
+		bool operator==(const VSpecializationConstants& other) const;
+
+	private:
+		void setBytes(uint32_t constantId, const void* value);
+
+		std::vector<VkSpecializationMapEntry> entries;
+		std::vector<uint8_t> data;
+	};
+
+	// every pipeline built from one pair of shaders, one per distinct set of constant values and the
+	// fixed function state that differs between variants (cull mode, depth state...). asking for a
+	// variant that already exists hands back the existing one. the pipelines live in pool
+	class VPipelineVariants {
+	public:
+		VPipelineVariants(VDevice& device, VHandlePool<VwdwPipeline>& pool, const std::string& vertPath, const std::string& fragPath);
+		~VPipelineVariants();
+
+		VPipelineVariants(const VPipelineVariants&) = delete;
+		VPipelineVariants& operator=(const VPipelineVariants&) = delete;
+
+		// stable index, small enough to go straight into a render queue key
+		uint32_t getVariant(const PipelineConfigInfo& config, const VSpecializationConstants& constants = {});
+		VPipelineHandle getPipeline(uint32_t variant) const { return variants[variant].pipeline; }
+		uint32_t variantCount() const { return static_cast<uint32_t>(variants.size()); }
+		// every pipeline has to go when the render pass or layout they were built against does. pipelines
+		// made for dynamic rendering only depend on formats and can be kept across swapchain recreation
+		void clear();
+
+		// true when vertPath or fragPath names path
+		bool usesShader(const std::string& path) const;
+		// builds every variant again from the current shader code, for hot reload. frames in flight may
+		// still be using the old pipelines, their handles go to retired for the caller to release once
+		// those frames are done. a variant that fails to build keeps its old pipeline
+		void rebuild(std::vector<VPipelineHandle>& retired);
+
+	private:
+		// the parts of PipelineConfigInfo variants are allowed to differ in
+		struct FixedState {
+			VkCullModeFlags cullMode;
+			VkFrontFace frontFace;
+			VkPolygonMode polygonMode;
+			VkBool32 depthTest;
+			VkBool32 depthWrite;
+			VkCompareOp depthCompare;
+			VkBool32 blend;
+			VkColorComponentFlags colorWriteMask;
+			bool positionOnly;
+			bool vertexPulling;
+			VkRenderPass renderPass;
+			VkFormat colorFormat;
+			VkFormat depthFormat;
+			VkPipelineLayout pipelineLayout;
+
+			bool operator==(const FixedState& other) const;
+		};
+
+		struct Variant {
+			FixedState state;
+			VSpecializationConstants constants;
+			VPipelineHandle pipeline;
+			// what it was built from, kept for rebuild(). on the heap because it points into itself
+			std::unique_ptr<PipelineConfigInfo> config;
+		};
+
+		static FixedState fixedStateOf(const PipelineConfigInfo& config);
+
+		VDevice& vDevice;
+		VHandlePool<VwdwPipeline>& pool;
+		std::string vertPath;
+		std::string fragPath;
+		std::vector<Variant> variants;
+		// hash of state + constants -> indices into variants sharing it
+		std::unordered_map<uint64_t, std::vector<uint32_t>> lookup;
+	};
+
+}
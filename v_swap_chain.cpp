@@ -2,6 +2,8 @@
 // The following lines have been changed by Jordan henstrom: Function starting at 217 and 280
 
 #include "v_swap_chain.hpp"
+#include "v_frame_arena.hpp"
+#include "v_resize.hpp"
 
 #include <array>
 #include <cstdlib>
@@ -13,22 +15,27 @@
 
 namespace vwdw {
 
-VSwapChain::VSwapChain(VDevice &deviceRef, VkExtent2D extent)
-    : device{deviceRef}, windowExtent{extent} {
+VSwapChain::VSwapChain(VDevice &deviceRef, VkExtent2D extent, bool dynamicRendering, bool uncapped)
+    : device{deviceRef}, windowExtent{extent}, dynamicRendering{dynamicRendering}, uncapped{uncapped} {
 init();
 }
 
 void VSwapChain::init() {
   createSwapChain();
   createImageViews();
-  createRenderPass();
+  if (!dynamicRendering) {
+    createRenderPass();
+  }
   createDepthResources();
-  createFramebuffers();
+  if (!dynamicRendering) {
+    createFramebuffers();
+  }
   createSyncObjects();
 }
 
 VSwapChain::VSwapChain(VDevice &deviceRef, VkExtent2D extent, std::shared_ptr<VSwapChain> previous)
-    : device{deviceRef}, windowExtent{extent}, oldSwapChain{previous} {
+    : device{deviceRef}, windowExtent{extent}, dynamicRendering{previous->dynamicRendering}, uncapped{previous->uncapped}, oldSwapChain{previous} {
+  depthAllocations = previous->depthAllocations;
   init();
 
 
@@ -50,14 +57,16 @@ VSwapChain::~VSwapChain() {
   for (int i = 0; i < depthImages.size(); i++) {
     vkDestroyImageView(device.device(), depthImageViews[i], nullptr);
     vkDestroyImage(device.device(), depthImages[i], nullptr);
-    vkFreeMemory(device.device(), depthImageMemorys[i], nullptr);
   }
+  device.freeMemory(depthMemory);
 
   for (auto framebuffer : swapChainFramebuffers) {
     vkDestroyFramebuffer(device.device(), framebuffer, nullptr);
   }
 
-  vkDestroyRenderPass(device.device(), renderPass, nullptr);
+  if (renderPass != VK_NULL_HANDLE) {
+    vkDestroyRenderPass(device.device(), renderPass, nullptr);
+  }
 
   // cleanup synchronization objects
   for (size_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++) {
@@ -87,7 +96,7 @@ VkResult VSwapChain::acquireNextImage(uint32_t *imageIndex) {
 }
 
 VkResult VSwapChain::submitCommandBuffers(
-    const VkCommandBuffer *buffers, uint32_t *imageIndex) {
+    const VkCommandBuffer *buffers, uint32_t *imageIndex, std::pmr::memory_resource *scratch) {
   if (imagesInFlight[*imageIndex] != VK_NULL_HANDLE) {
     vkWaitForFences(device.device(), 1, &imagesInFlight[*imageIndex], VK_TRUE, UINT64_MAX);
   }
@@ -96,8 +105,13 @@ VkResult VSwapChain::submitCommandBuffers(
   VkSubmitInfo submitInfo = {};
   submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
 
-  VkSemaphore waitSemaphores[] = {imageAvailableSemaphores[currentFrame]};
-  
+  std::pmr::vector<VkSemaphore> waitSemaphores{{imageAvailableSemaphores[currentFrame]}, scratch};
+  std::pmr::vector<VkPipelineStageFlags> waitStages{{VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT}, scratch};
+  waitSemaphores.insert(waitSemaphores.end(), extraWaitSemaphores.begin(), extraWaitSemaphores.end());
+  waitStages.insert(waitStages.end(), extraWaitStages.begin(), extraWaitStages.end());
+  extraWaitSemaphores.clear();
+  extraWaitStages.clear();
+
   submitInfo.commandBufferCount = 1;
   submitInfo.pCommandBuffers = buffers;
 
@@ -105,10 +119,9 @@ VkResult VSwapChain::submitCommandBuffers(
   submitInfo.signalSemaphoreCount = 1;
   submitInfo.pSignalSemaphores = signalSemaphores;
 
-  VkPipelineStageFlags waitStages[] = { VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT };
-  submitInfo.waitSemaphoreCount = 1;
-  submitInfo.pWaitSemaphores = waitSemaphores;
-  submitInfo.pWaitDstStageMask = waitStages;
+  submitInfo.waitSemaphoreCount = static_cast<uint32_t>(waitSemaphores.size());
+  submitInfo.pWaitSemaphores = waitSemaphores.data();
+  submitInfo.pWaitDstStageMask = waitStages.data();
 
   vkResetFences(device.device(), 1, &inFlightFences[currentFrame]);
   if (vkQueueSubmit(device.graphicsQueue(), 1, &submitInfo, inFlightFences[currentFrame]) !=
@@ -135,8 +148,14 @@ VkResult VSwapChain::submitCommandBuffers(
   return result;
 }
 
+void VSwapChain::addWaitSemaphore(VkSemaphore semaphore, VkPipelineStageFlags stage) {
+  extraWaitSemaphores.push_back(semaphore);
+  extraWaitStages.push_back(stage);
+}
+
 void VSwapChain::createSwapChain() {
-  SwapChainSupportDetails swapChainSupport = device.getSwapChainSupport();
+  VScratchArena<1024> scratch;
+  SwapChainSupportDetails swapChainSupport = device.getSwapChainSupport(&scratch);
 
   VkSurfaceFormatKHR surfaceFormat = chooseSwapSurfaceFormat(swapChainSupport.formats);
   VkPresentModeKHR presentMode = chooseSwapPresentMode(swapChainSupport.presentModes);
@@ -158,6 +177,11 @@ void VSwapChain::createSwapChain() {
   createInfo.imageExtent = extent;
   createInfo.imageArrayLayers = 1;
   createInfo.imageUsage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT;
+  // so finished frames can be copied out for capture, where the surface allows it
+  readbackSupported = (swapChainSupport.capabilities.supportedUsageFlags & VK_IMAGE_USAGE_TRANSFER_SRC_BIT) != 0;
+  if (readbackSupported) {
+    createInfo.imageUsage |= VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
+  }
 
   QueueFamilyIndices indices = device.findPhysicalQueueFamilies();
   uint32_t queueFamilyIndices[] = {indices.graphicsFamily, indices.presentFamily};
@@ -214,7 +238,14 @@ void VSwapChain::createImageViews() {
 }
 
 void VSwapChain::createRenderPass() {
-
+  // a render pass only depends on the formats, a resize that keeps them keeps the previous one and
+  // every pipeline built against it
+  if (oldSwapChain != nullptr && oldSwapChain->renderPass != VK_NULL_HANDLE &&
+      oldSwapChain->swapChainImageFormat == swapChainImageFormat) {
+    renderPass = oldSwapChain->renderPass;
+    oldSwapChain->renderPass = VK_NULL_HANDLE;
+    return;
+  }
 
   VkAttachmentReference depthAttachmentRef{};
   depthAttachmentRef.attachment = 1;
@@ -251,14 +282,16 @@ void VSwapChain::createRenderPass() {
   subpass.pColorAttachments = &colorAttachmentRef;
   subpass.pDepthStencilAttachment = &depthAttachmentRef;
 
+  // depth images are reused across frames, so the clear has to wait for the last frame's
+  // depth writes (write after write), not just for the color output
   VkSubpassDependency dependency = {};
   dependency.srcSubpass = VK_SUBPASS_EXTERNAL;
-  dependency.srcAccessMask = 0;
-  dependency.srcStageMask =
-      VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT;
+  dependency.srcAccessMask = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+  dependency.srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT |
+      VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT;
   dependency.dstSubpass = 0;
-  dependency.dstStageMask =
-      VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT;
+  dependency.dstStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT |
+      VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT;
   dependency.dstAccessMask =
       VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
 
@@ -278,9 +311,11 @@ void VSwapChain::createRenderPass() {
 }
 
 void VSwapChain::createFramebuffers() {
-  swapChainFramebuffers.resize(imageCount());
-  for (size_t i = 0; i < imageCount(); i++) {
-    std::array<VkImageView, 2> attachments = {swapChainImageViews[i], depthImageViews[i]};
+  swapChainFramebuffers.resize(MAX_FRAMES_IN_FLIGHT * imageCount());
+  for (size_t i = 0; i < swapChainFramebuffers.size(); i++) {
+    size_t frame = i / imageCount();
+    size_t image = i % imageCount();
+    std::array<VkImageView, 2> attachments = {swapChainImageViews[image], depthImageViews[frame]};
 
     VkExtent2D swapChainExtent = getSwapChainExtent();
     VkFramebufferCreateInfo framebufferInfo = {};
@@ -304,34 +339,84 @@ void VSwapChain::createFramebuffers() {
 
 void VSwapChain::createDepthResources() {
   VkFormat depthFormat = findDepthFormat();
-  VkExtent2D swapChainExtent = getSwapChainExtent();
 
-  depthImages.resize(imageCount());
-  depthImageMemorys.resize(imageCount());
-  depthImageViews.resize(imageCount());
+  // depth is sized with headroom, while the new extent still fits the previous swapchain's images
+  // are taken over as they are and rendering just covers less of them
+  if (oldSwapChain != nullptr && oldSwapChain->depthMemory != VK_NULL_HANDLE &&
+      attachmentCapacityFits(oldSwapChain->depthExtent, swapChainExtent)) {
+    depthImages.swap(oldSwapChain->depthImages);
+    depthImageViews.swap(oldSwapChain->depthImageViews);
+    depthMemory = oldSwapChain->depthMemory;
+    depthExtent = oldSwapChain->depthExtent;
+    oldSwapChain->depthMemory = VK_NULL_HANDLE;
+    return;
+  }
+  depthExtent = attachmentCapacityFor(swapChainExtent, device.properties.limits.maxImageDimension2D);
+  depthAllocations++;
+
+  // only frames in flight can be rendering at once, and depth is never stored, so it doesn't need
+  // one image per swapchain image. transient usage lets tilers keep it in on chip memory
+  depthImages.resize(MAX_FRAMES_IN_FLIGHT);
+  depthImageViews.resize(MAX_FRAMES_IN_FLIGHT);
 
+  std::vector<VkDeviceSize> offsets(depthImages.size());
+  VkDeviceSize totalSize = 0;
+  uint32_t memoryTypeBits = ~0u;
   for (int i = 0; i < depthImages.size(); i++) {
     VkImageCreateInfo imageInfo{};
     imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
     imageInfo.imageType = VK_IMAGE_TYPE_2D;
-    imageInfo.extent.width = swapChainExtent.width;
-    imageInfo.extent.height = swapChainExtent.height;
+    imageInfo.extent.width = depthExtent.width;
+    imageInfo.extent.height = depthExtent.height;
     imageInfo.extent.depth = 1;
     imageInfo.mipLevels = 1;
     imageInfo.arrayLayers = 1;
     imageInfo.format = depthFormat;
     imageInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
     imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-    imageInfo.usage = VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT;
+    imageInfo.usage = VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSIENT_ATTACHMENT_BIT;
     imageInfo.samples = VK_SAMPLE_COUNT_1_BIT;
     imageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
     imageInfo.flags = 0;
 
-    device.createImageWithInfo(
-        imageInfo,
-        VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
-        depthImages[i],
-        depthImageMemorys[i]);
+    if (vkCreateImage(device.device(), &imageInfo, nullptr, &depthImages[i]) != VK_SUCCESS) {
+      throw std::runtime_error("failed to create depth image!");
+    }
+
+    VkMemoryRequirements memRequirements;
+    vkGetImageMemoryRequirements(device.device(), depthImages[i], &memRequirements);
+    totalSize = (totalSize + memRequirements.alignment - 1) / memRequirements.alignment * memRequirements.alignment;
+    offsets[i] = totalSize;
+    totalSize += memRequirements.size;
+    memoryTypeBits &= memRequirements.memoryTypeBits;
+  }
+
+  // lazily allocated memory is only committed if the tiler actually has to spill, fall back to
+  // plain device local where it doesn't exist (most desktop parts)
+  uint32_t memoryType = UINT32_MAX;
+  for (uint32_t i = 0; i < 32; i++) {
+    VkMemoryPropertyFlags lazy = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT | VK_MEMORY_PROPERTY_LAZILY_ALLOCATED_BIT;
+    if ((memoryTypeBits & (1u << i)) && (device.getMemoryTypeFlags(i) & lazy) == lazy) {
+      memoryType = i;
+      break;
+    }
+  }
+  if (memoryType == UINT32_MAX) {
+    memoryType = device.findMemoryType(memoryTypeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+  }
+
+  VkMemoryAllocateInfo allocInfo{};
+  allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+  allocInfo.allocationSize = totalSize;
+  allocInfo.memoryTypeIndex = memoryType;
+  if (device.allocateMemory(allocInfo, depthMemory) != VK_SUCCESS) {
+    throw std::runtime_error("failed to allocate depth image memory!");
+  }
+
+  for (size_t i = 0; i < depthImages.size(); i++) {
+    if (vkBindImageMemory(device.device(), depthImages[i], depthMemory, offsets[i]) != VK_SUCCESS) {
+      throw std::runtime_error("failed to bind depth image memory!");
+    }
 
     VkImageViewCreateInfo viewInfo{};
     viewInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
@@ -375,7 +460,7 @@ void VSwapChain::createSyncObjects() {
 }
 
 VkSurfaceFormatKHR VSwapChain::chooseSwapSurfaceFormat(
-    const std::vector<VkSurfaceFormatKHR> &availableFormats) {
+    const std::pmr::vector<VkSurfaceFormatKHR> &availableFormats) {
   for (const auto &availableFormat : availableFormats) {
     if (availableFormat.format == VK_FORMAT_B8G8R8A8_SRGB &&
         availableFormat.colorSpace == VK_COLOR_SPACE_SRGB_NONLINEAR_KHR) {
@@ -387,7 +472,15 @@ VkSurfaceFormatKHR VSwapChain::chooseSwapSurfaceFormat(
 }
 
 VkPresentModeKHR VSwapChain::chooseSwapPresentMode(
-    const std::vector<VkPresentModeKHR> &availablePresentModes) {
+    const std::pmr::vector<VkPresentModeKHR> &availablePresentModes) {
+  if (uncapped) {
+    for (const auto &availablePresentMode : availablePresentModes) {
+      if (availablePresentMode == VK_PRESENT_MODE_IMMEDIATE_KHR) {
+        std::cout << "Present mode: Immediate" << std::endl;
+        return availablePresentMode;
+      }
+    }
+  }
   for (const auto &availablePresentMode : availablePresentModes) {
     if (availablePresentMode == VK_PRESENT_MODE_MAILBOX_KHR) {
       std::cout << "Present mode: Mailbox" << std::endl;
@@ -17,21 +17,39 @@ namespace vwdw {
     public:
         static constexpr int MAX_FRAMES_IN_FLIGHT = 2;
 
-        VSwapChain(VDevice& deviceRef, VkExtent2D windowExtent);
+        // with dynamicRendering no VkRenderPass or VkFramebuffers are made, callers begin rendering on
+        // the image views themselves and own the layout transitions. uncapped prefers IMMEDIATE present
+        // over MAILBOX so nothing waits on vblank, for timing runs
+        VSwapChain(VDevice& deviceRef, VkExtent2D windowExtent, bool dynamicRendering = false, bool uncapped = false);
+        // keeps the previous swapchain's rendering and present mode
         VSwapChain(VDevice& deviceRef, VkExtent2D windowExtent, std::shared_ptr<VSwapChain> previous);
         ~VSwapChain();
 
         VSwapChain(const VSwapChain&) = delete;
         VSwapChain& operator=(const VSwapChain&) = delete;
 
-        VkFramebuffer getFrameBuffer(int index) { return swapChainFramebuffers[index]; }
+        // depth is per frame in flight, so there is a framebuffer for every (frame slot, image) pair
+        VkFramebuffer getFrameBuffer(int index) { return swapChainFramebuffers[currentFrame * imageCount() + index]; }
         VkRenderPass getRenderPass() { return renderPass; }
         VkImageView getImageView(int index) { return swapChainImageViews[index]; }
+        VkImage getImage(int index) { return swapChainImages[index]; }
+        // the current frame slot's depth attachment, getDepthExtent() big. only the top left
+        // getSwapChainExtent() of it is rendered to
+        VkImage getDepthImage() { return depthImages[currentFrame]; }
+        VkImageView getDepthImageView() { return depthImageViews[currentFrame]; }
+        VkExtent2D getDepthExtent() { return depthExtent; }
+        // depth memory allocations over this chain of swapchains, the rest reused the previous one's
+        uint32_t getDepthAllocationCount() const { return depthAllocations; }
+        bool usesDynamicRendering() const { return dynamicRendering; }
+        // the images can be a transfer source, a finished frame can be copied out of them
+        bool supportsReadback() const { return readbackSupported; }
         size_t imageCount() { return swapChainImages.size(); }
         VkFormat getSwapChainImageFormat() { return swapChainImageFormat; }
         VkExtent2D getSwapChainExtent() { return swapChainExtent; }
         uint32_t width() { return swapChainExtent.width; }
         uint32_t height() { return swapChainExtent.height; }
+        // frame in flight slot the next acquire/submit pair uses, its fence has been waited on after acquire
+        uint32_t getCurrentFrame() { return static_cast<uint32_t>(currentFrame); }
 
         float extentAspectRatio() {
             return static_cast<float>(swapChainExtent.width) / static_cast<float>(swapChainExtent.height);
@@ -39,7 +57,12 @@ namespace vwdw {
         VkFormat findDepthFormat();
 
         VkResult acquireNextImage(uint32_t* imageIndex);
-        VkResult submitCommandBuffers(const VkCommandBuffer* buffers, uint32_t* imageIndex);
+        // the wait lists for the submit are built in scratch, a frame arena keeps them off the heap
+        VkResult submitCommandBuffers(const VkCommandBuffer* buffers, uint32_t* imageIndex,
+            std::pmr::memory_resource* scratch = std::pmr::get_default_resource());
+        // extra semaphore the next submitCommandBuffers waits on at stage (async compute results...),
+        // cleared after that submit
+        void addWaitSemaphore(VkSemaphore semaphore, VkPipelineStageFlags stage);
 
     private:
         void init();
@@ -51,25 +74,32 @@ namespace vwdw {
         void createSyncObjects();
 
         VkSurfaceFormatKHR chooseSwapSurfaceFormat(
-            const std::vector<VkSurfaceFormatKHR>& availableFormats);
+            const std::pmr::vector<VkSurfaceFormatKHR>& availableFormats);
         VkPresentModeKHR chooseSwapPresentMode(
-            const std::vector<VkPresentModeKHR>& availablePresentModes);
+            const std::pmr::vector<VkPresentModeKHR>& availablePresentModes);
         VkExtent2D chooseSwapExtent(const VkSurfaceCapabilitiesKHR& capabilities);
 
         VkFormat swapChainImageFormat;
         VkExtent2D swapChainExtent;
 
         std::vector<VkFramebuffer> swapChainFramebuffers;
-        VkRenderPass renderPass;
+        VkRenderPass renderPass = VK_NULL_HANDLE;
 
+        // one per frame in flight, all bound to depthMemory. the images are depthExtent big, which
+        // is at least swapChainExtent and handed on to the next swapchain while it still fits
         std::vector<VkImage> depthImages;
-        std::vector<VkDeviceMemory> depthImageMemorys;
         std::vector<VkImageView> depthImageViews;
+        VkDeviceMemory depthMemory = VK_NULL_HANDLE;
+        VkExtent2D depthExtent{};
+        uint32_t depthAllocations = 0;
         std::vector<VkImage> swapChainImages;
         std::vector<VkImageView> swapChainImageViews;
 
         VDevice& device;
         VkExtent2D windowExtent;
+        bool dynamicRendering = false;
+        bool uncapped = false;
+        bool readbackSupported = false;
 
         VkSwapchainKHR swapChain;
         std::shared_ptr<VSwapChain> oldSwapChain;
@@ -78,6 +108,8 @@ namespace vwdw {
         std::vector<VkSemaphore> renderFinishedSemaphores;
         std::vector<VkFence> inFlightFences;
         std::vector<VkFence> imagesInFlight;
+        std::vector<VkSemaphore> extraWaitSemaphores;
+        std::vector<VkPipelineStageFlags> extraWaitStages;
         size_t currentFrame = 0;
     };
 }
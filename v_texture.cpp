@@ -0,0 +1,619 @@
+#include "v_texture.hpp"
+#include "v_asset_formats.hpp"
+#include "v_buffer.hpp"
+#include "v_image.hpp"
+
+#include <cassert>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <limits>
+#include <stdexcept>
+
+namespace vwdw {
+
+VTexture::VTexture(VDevice& device, VkImage image, VkDeviceMemory memory, VkFormat format, uint32_t width, uint32_t height, uint32_t mipLevels)
+	: vDevice{ device }, image{ image }, memory{ memory }, format{ format }, width{ width }, height{ height }, mipLevels{ mipLevels }
+{
+	createImageView();
+	createSampler();
+}
+
+VTexture::~VTexture()
+{
+	if (bindless != nullptr)
+	{
+		bindless->releaseSampledImage(bindlessHandle);
+	}
+	vkDestroySampler(vDevice.device(), sampler, nullptr);
+	vkDestroyImageView(vDevice.device(), imageView, nullptr);
+	vkDestroyImage(vDevice.device(), image, nullptr);
+	vDevice.freeMemory(memory);
+}
+
+void VTexture::registerBindless(VBindlessTable& table)
+{
+	if (bindless != nullptr)
+	{
+		bindless->releaseSampledImage(bindlessHandle);
+	}
+	bindless = &table;
+	bindlessHandle = table.addSampledImage(imageView, sampler);
+}
+
+void VTexture::createImageView()
+{
+	VkImageViewCreateInfo viewInfo{};
+	viewInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+	viewInfo.image = image;
+	viewInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
+	viewInfo.format = format;
+	viewInfo.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+	viewInfo.subresourceRange.baseMipLevel = 0;
+	viewInfo.subresourceRange.levelCount = mipLevels;
+	viewInfo.subresourceRange.baseArrayLayer = 0;
+	viewInfo.subresourceRange.layerCount = 1;
+
+	if (vkCreateImageView(vDevice.device(), &viewInfo, nullptr, &imageView) != VK_SUCCESS)
+	{
+		throw std::runtime_error("failed to create texture image view");
+	}
+}
+
+void VTexture::createSampler()
+{
+	VkSamplerCreateInfo samplerInfo{};
+	samplerInfo.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
+	samplerInfo.magFilter = VK_FILTER_LINEAR;
+	samplerInfo.minFilter = VK_FILTER_LINEAR;
+	samplerInfo.mipmapMode = VK_SAMPLER_MIPMAP_MODE_LINEAR;
+	samplerInfo.addressModeU = VK_SAMPLER_ADDRESS_MODE_REPEAT;
+	samplerInfo.addressModeV = VK_SAMPLER_ADDRESS_MODE_REPEAT;
+	samplerInfo.addressModeW = VK_SAMPLER_ADDRESS_MODE_REPEAT;
+	samplerInfo.anisotropyEnable = VK_TRUE;
+	samplerInfo.maxAnisotropy = vDevice.properties.limits.maxSamplerAnisotropy;
+	samplerInfo.compareEnable = VK_FALSE;
+	samplerInfo.compareOp = VK_COMPARE_OP_ALWAYS;
+	samplerInfo.minLod = 0.0f;
+	samplerInfo.maxLod = static_cast<float>(mipLevels);
+	samplerInfo.mipLodBias = 0.0f;
+	samplerInfo.borderColor = VK_BORDER_COLOR_INT_OPAQUE_BLACK;
+	samplerInfo.unnormalizedCoordinates = VK_FALSE;
+
+	if (vkCreateSampler(vDevice.device(), &samplerInfo, nullptr, &sampler) != VK_SUCCESS)
+	{
+		throw std::runtime_error("failed to create texture sampler");
+	}
+}
+
+VTextureLoader::VTextureLoader(VDevice& device, VBindlessTable* bindless, VJobSystem* jobSystem)
+	: vDevice{ device }, bindless{ bindless }, jobs{ jobSystem }
+{
+}
+
+VTextureLoader::~VTextureLoader()
+{
+	// a stream still in flight: its reads can't be cancelled, its images were never handed out
+	if (streamState == StreamState::Reading && jobs != nullptr)
+	{
+		jobs->wait(streamReads);
+	}
+	if (streamState == StreamState::Uploading)
+	{
+		vkWaitForFences(vDevice.device(), 1, &uploadFence, VK_TRUE, std::numeric_limits<uint64_t>::max());
+		for (size_t i = 0; i < cookedCount; i++)
+		{
+			vkDestroyImage(vDevice.device(), cookedFiles[i].image, nullptr);
+			vDevice.freeMemory(cookedFiles[i].memory);
+		}
+	}
+	if (uploadCommandBuffer != VK_NULL_HANDLE)
+	{
+		vkFreeCommandBuffers(vDevice.device(), vDevice.getCommandPool(), 1, &uploadCommandBuffer);
+		vkDestroyFence(vDevice.device(), uploadFence, nullptr);
+	}
+}
+
+uint32_t VTextureLoader::mipLevelsFor(uint32_t width, uint32_t height)
+{
+	uint32_t size = width > height ? width : height;
+	uint32_t levels = 1;
+	while (size > 1)
+	{
+		size >>= 1;
+		levels++;
+	}
+	return levels;
+}
+
+template <typename F>
+void VTextureLoader::parallelFor(size_t count, F&& fn)
+{
+	if (jobs == nullptr)
+	{
+		for (size_t i = 0; i < count; i++)
+		{
+			fn(i);
+		}
+		return;
+	}
+	// batches of files get stolen by idle workers, so a few huge textures don't hold the rest up
+	jobs->parallelFor(static_cast<uint32_t>(count), 1, [&](uint32_t begin, uint32_t end)
+		{
+			for (uint32_t i = begin; i < end; i++)
+			{
+				fn(i);
+			}
+		});
+}
+
+static VkImageMemoryBarrier mipBarrier(VkImage image, uint32_t baseLevel, uint32_t levelCount, VkImageLayout oldLayout, VkImageLayout newLayout, VkAccessFlags srcAccess, VkAccessFlags dstAccess)
+{
+	VkImageMemoryBarrier barrier{};
+	barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+	barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	barrier.image = image;
+	barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+	barrier.subresourceRange.baseMipLevel = baseLevel;
+	barrier.subresourceRange.levelCount = levelCount;
+	barrier.subresourceRange.baseArrayLayer = 0;
+	barrier.subresourceRange.layerCount = 1;
+	barrier.oldLayout = oldLayout;
+	barrier.newLayout = newLayout;
+	barrier.srcAccessMask = srcAccess;
+	barrier.dstAccessMask = dstAccess;
+	return barrier;
+}
+
+std::vector<VImageHandle> VTextureLoader::loadBatch(const std::vector<std::string>& paths, VHandlePool<VTexture>& pool)
+{
+	assert(!streaming() && "the stream shares the upload command buffer");
+	std::vector<VImageHandle> textures;
+	if (paths.empty())
+	{
+		return textures;
+	}
+
+	// decode everything in parallel
+	size_t count = paths.size();
+	std::vector<VImageData> images(count);
+	std::vector<std::string> errors(count);
+	parallelFor(count, [&](size_t i)
+		{
+			if (!loadImageFile(paths[i], images[i], errors[i]) && errors[i].empty())
+			{
+				errors[i] = "failed to decode " + paths[i];
+			}
+		});
+	for (const auto& error : errors)
+	{
+		if (!error.empty())
+		{
+			throw std::runtime_error("failed to load texture: " + error);
+		}
+	}
+
+	// one staging buffer for the whole batch, only level 0 is uploaded
+	std::vector<VkDeviceSize> offsets(count);
+	VkDeviceSize stagingSize = 0;
+	for (size_t i = 0; i < count; i++)
+	{
+		offsets[i] = stagingSize;
+		stagingSize += images[i].pixels.size();
+	}
+	VBuffer staging{ vDevice, stagingSize, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT };
+	for (size_t i = 0; i < count; i++)
+	{
+		std::memcpy(static_cast<char*>(staging.getMappedMemory()) + offsets[i], images[i].pixels.data(), images[i].pixels.size());
+	}
+	staging.flush();
+
+	// the blit chain needs linear filtering on both ends
+	VkFormat format = vDevice.findSupportedFormat(
+		{ VK_FORMAT_R8G8B8A8_SRGB },
+		VK_IMAGE_TILING_OPTIMAL,
+		VK_FORMAT_FEATURE_SAMPLED_IMAGE_BIT | VK_FORMAT_FEATURE_SAMPLED_IMAGE_FILTER_LINEAR_BIT | VK_FORMAT_FEATURE_BLIT_SRC_BIT | VK_FORMAT_FEATURE_BLIT_DST_BIT);
+
+	std::vector<VkImage> vkImages(count);
+	std::vector<VkDeviceMemory> memories(count);
+	std::vector<uint32_t> mipLevels(count);
+	uint32_t maxLevels = 1;
+	for (size_t i = 0; i < count; i++)
+	{
+		mipLevels[i] = mipLevelsFor(images[i].width, images[i].height);
+		maxLevels = mipLevels[i] > maxLevels ? mipLevels[i] : maxLevels;
+
+		VkImageCreateInfo imageInfo{};
+		imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+		imageInfo.imageType = VK_IMAGE_TYPE_2D;
+		imageInfo.extent = { images[i].width, images[i].height, 1 };
+		imageInfo.mipLevels = mipLevels[i];
+		imageInfo.arrayLayers = 1;
+		imageInfo.format = format;
+		imageInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+		imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+		imageInfo.usage = VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT;
+		imageInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+		imageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+		vDevice.createImageWithInfo(imageInfo, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, vkImages[i], memories[i]);
+	}
+
+	VkCommandBuffer commandBuffer = beginUpload();
+
+	// barriers for every texture go out together, one vkCmdPipelineBarrier per step of the chain
+	barriers.clear();
+	for (size_t i = 0; i < count; i++)
+	{
+		barriers.push_back(mipBarrier(vkImages[i], 0, mipLevels[i], VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 0, VK_ACCESS_TRANSFER_WRITE_BIT));
+	}
+	vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 0, nullptr, static_cast<uint32_t>(barriers.size()), barriers.data());
+
+	for (size_t i = 0; i < count; i++)
+	{
+		VkBufferImageCopy region{};
+		region.bufferOffset = offsets[i];
+		region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+		region.imageSubresource.mipLevel = 0;
+		region.imageSubresource.baseArrayLayer = 0;
+		region.imageSubresource.layerCount = 1;
+		region.imageExtent = { images[i].width, images[i].height, 1 };
+		vkCmdCopyBufferToImage(commandBuffer, staging.getBuffer(), vkImages[i], VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &region);
+	}
+
+	// level n-1 becomes a blit source for level n across every texture that still has levels left
+	for (uint32_t level = 1; level < maxLevels; level++)
+	{
+		barriers.clear();
+		for (size_t i = 0; i < count; i++)
+		{
+			if (level < mipLevels[i])
+			{
+				barriers.push_back(mipBarrier(vkImages[i], level - 1, 1, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, VK_ACCESS_TRANSFER_WRITE_BIT, VK_ACCESS_TRANSFER_READ_BIT));
+			}
+		}
+		vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 0, nullptr, static_cast<uint32_t>(barriers.size()), barriers.data());
+
+		for (size_t i = 0; i < count; i++)
+		{
+			if (level >= mipLevels[i])
+			{
+				continue;
+			}
+			int32_t srcWidth = static_cast<int32_t>(images[i].width >> (level - 1));
+			int32_t srcHeight = static_cast<int32_t>(images[i].height >> (level - 1));
+			srcWidth = srcWidth > 0 ? srcWidth : 1;
+			srcHeight = srcHeight > 0 ? srcHeight : 1;
+
+			VkImageBlit blit{};
+			blit.srcOffsets[0] = { 0, 0, 0 };
+			blit.srcOffsets[1] = { srcWidth, srcHeight, 1 };
+			blit.srcSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+			blit.srcSubresource.mipLevel = level - 1;
+			blit.srcSubresource.baseArrayLayer = 0;
+			blit.srcSubresource.layerCount = 1;
+			blit.dstOffsets[0] = { 0, 0, 0 };
+			blit.dstOffsets[1] = { srcWidth > 1 ? srcWidth / 2 : 1, srcHeight > 1 ? srcHeight / 2 : 1, 1 };
+			blit.dstSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+			blit.dstSubresource.mipLevel = level;
+			blit.dstSubresource.baseArrayLayer = 0;
+			blit.dstSubresource.layerCount = 1;
+			vkCmdBlitImage(commandBuffer, vkImages[i], VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, vkImages[i], VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &blit, VK_FILTER_LINEAR);
+		}
+	}
+
+	// every level but the last ended as a blit source, the last is still a transfer destination
+	barriers.clear();
+	for (size_t i = 0; i < count; i++)
+	{
+		if (mipLevels[i] > 1)
+		{
+			barriers.push_back(mipBarrier(vkImages[i], 0, mipLevels[i] - 1, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_ACCESS_TRANSFER_READ_BIT, VK_ACCESS_SHADER_READ_BIT));
+		}
+		barriers.push_back(mipBarrier(vkImages[i], mipLevels[i] - 1, 1, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_ACCESS_TRANSFER_WRITE_BIT, VK_ACCESS_SHADER_READ_BIT));
+	}
+	vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_VERTEX_SHADER_BIT | VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, 0, 0, nullptr, 0, nullptr, static_cast<uint32_t>(barriers.size()), barriers.data());
+
+	submitAndWait(commandBuffer);
+
+	textures.reserve(count);
+	for (size_t i = 0; i < count; i++)
+	{
+		textures.push_back(pool.emplace(vDevice, vkImages[i], memories[i], format, images[i].width, images[i].height, mipLevels[i]));
+		if (bindless != nullptr)
+		{
+			pool[textures.back()].registerBindless(*bindless);
+		}
+	}
+	return textures;
+}
+
+std::vector<VImageHandle> VTextureLoader::loadCookedBatch(const std::vector<std::string>& paths, VHandlePool<VTexture>& pool)
+{
+	std::vector<VImageHandle> textures;
+	loadCookedBatch(paths, pool, textures);
+	return textures;
+}
+
+void VTextureLoader::loadCookedBatch(const std::vector<std::string>& paths, VHandlePool<VTexture>& pool, std::vector<VImageHandle>& textures)
+{
+	assert(!streaming() && "the stream shares the upload command buffer and file storage");
+	textures.clear();
+	if (paths.empty())
+	{
+		return;
+	}
+
+	readCookedFiles(paths);
+	throwCookedErrors();
+
+	VkCommandBuffer commandBuffer = beginUpload();
+	recordCookedUpload(commandBuffer);
+	submitAndWait(commandBuffer);
+	emplaceCooked(pool, textures);
+}
+
+bool VTextureLoader::startCookedStream(const std::vector<std::string>& paths)
+{
+	if (streaming() || paths.empty())
+	{
+		return false;
+	}
+	streamPaths = &paths;
+	streamState = StreamState::Reading;
+	if (jobs != nullptr)
+	{
+		// parallelFor inside is fine on a worker, it runs batches itself while it waits
+		jobs->run([this]() { readCookedFiles(*streamPaths); }, &streamReads);
+	}
+	else
+	{
+		readCookedFiles(paths);
+	}
+	return true;
+}
+
+bool VTextureLoader::pollCookedStream(VHandlePool<VTexture>& pool, std::vector<VImageHandle>& textures)
+{
+	if (streamState == StreamState::Reading)
+	{
+		if (!streamReads.done())
+		{
+			return false;
+		}
+		streamState = StreamState::Idle;
+		throwCookedErrors();
+
+		// images and memory are made here, on the thread that owns the memory budget
+		VkCommandBuffer commandBuffer = beginUpload();
+		recordCookedUpload(commandBuffer);
+		submit(commandBuffer);
+		streamState = StreamState::Uploading;
+		return false;
+	}
+	if (streamState != StreamState::Uploading || vkGetFenceStatus(vDevice.device(), uploadFence) != VK_SUCCESS)
+	{
+		return false;
+	}
+	textures.clear();
+	emplaceCooked(pool, textures);
+	streamState = StreamState::Idle;
+	streamPaths = nullptr;
+	return true;
+}
+
+void VTextureLoader::throwCookedErrors() const
+{
+	for (size_t i = 0; i < cookedCount; i++)
+	{
+		if (!cookedFiles[i].error.empty())
+		{
+			throw std::runtime_error("failed to load texture: " + cookedFiles[i].error);
+		}
+	}
+}
+
+void VTextureLoader::readCookedFiles(const std::vector<std::string>& paths)
+{
+	// file reads overlap, the data is already gpu ready
+	cookedCount = paths.size();
+	if (cookedFiles.size() < cookedCount)
+	{
+		cookedFiles.resize(cookedCount);
+	}
+	parallelFor(cookedCount, [&](size_t i)
+		{
+			CookedFile& cooked = cookedFiles[i];
+			cooked.error.clear();
+			cooked.levels.clear();
+			std::ifstream file{ paths[i], std::ios::binary };
+			if (!file.is_open())
+			{
+				cooked.error = "failed to open file: " + paths[i];
+				return;
+			}
+			file.read(reinterpret_cast<char*>(&cooked.header), sizeof(CookedTextureHeader));
+			if (!file || cooked.header.magic != COOKED_TEXTURE_MAGIC || cooked.header.version != COOKED_TEXTURE_VERSION || cooked.header.mipLevels == 0)
+			{
+				cooked.error = "not a cooked texture: " + paths[i];
+				return;
+			}
+			cooked.bytes.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+
+			// level sizes are prefixed in the file, strip them here so the upload only copies
+			size_t pos = 0;
+			for (uint32_t level = 0; level < cooked.header.mipLevels; level++)
+			{
+				uint32_t size;
+				if (pos + sizeof(size) > cooked.bytes.size())
+				{
+					cooked.error = "truncated cooked texture: " + paths[i];
+					return;
+				}
+				std::memcpy(&size, cooked.bytes.data() + pos, sizeof(size));
+				pos += sizeof(size);
+				if (size > cooked.bytes.size() - pos)
+				{
+					cooked.error = "truncated cooked texture: " + paths[i];
+					return;
+				}
+				cooked.levels.push_back({ cooked.bytes.data() + pos, size });
+				pos += size;
+			}
+		});
+}
+
+void VTextureLoader::recordCookedUpload(VkCommandBuffer commandBuffer)
+{
+	// block formats need 4 byte aligned copy offsets, and blocks are a multiple of that already
+	VkDeviceSize stagingSize = 0;
+	for (size_t i = 0; i < cookedCount; i++)
+	{
+		for (const CookedLevel& level : cookedFiles[i].levels)
+		{
+			stagingSize += (level.size + 15) & ~15u;
+		}
+	}
+	VBuffer& buffer = stagingBuffer(stagingSize);
+
+	VkDeviceSize offset = 0;
+	for (size_t i = 0; i < cookedCount; i++)
+	{
+		CookedFile& cooked = cookedFiles[i];
+		const CookedTextureHeader& header = cooked.header;
+		VkFormat format = static_cast<VkFormat>(header.format);
+		vDevice.findSupportedFormat({ format }, VK_IMAGE_TILING_OPTIMAL, VK_FORMAT_FEATURE_SAMPLED_IMAGE_BIT | VK_FORMAT_FEATURE_SAMPLED_IMAGE_FILTER_LINEAR_BIT);
+
+		cooked.regions.clear();
+		for (uint32_t level = 0; level < header.mipLevels; level++)
+		{
+			std::memcpy(static_cast<char*>(buffer.getMappedMemory()) + offset, cooked.levels[level].data, cooked.levels[level].size);
+
+			uint32_t width = header.width >> level;
+			uint32_t height = header.height >> level;
+			VkBufferImageCopy region{};
+			region.bufferOffset = offset;
+			region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+			region.imageSubresource.mipLevel = level;
+			region.imageSubresource.baseArrayLayer = 0;
+			region.imageSubresource.layerCount = 1;
+			region.imageExtent = { width > 0 ? width : 1, height > 0 ? height : 1, 1 };
+			cooked.regions.push_back(region);
+			offset += (cooked.levels[level].size + 15) & ~15u;
+		}
+
+		VkImageCreateInfo imageInfo{};
+		imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+		imageInfo.imageType = VK_IMAGE_TYPE_2D;
+		imageInfo.extent = { header.width, header.height, 1 };
+		imageInfo.mipLevels = header.mipLevels;
+		imageInfo.arrayLayers = 1;
+		imageInfo.format = format;
+		imageInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+		imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+		imageInfo.usage = VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT;
+		imageInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+		imageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+		vDevice.createImageWithInfo(imageInfo, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, cooked.image, cooked.memory);
+	}
+	buffer.flush();
+
+	barriers.clear();
+	for (size_t i = 0; i < cookedCount; i++)
+	{
+		barriers.push_back(mipBarrier(cookedFiles[i].image, 0, cookedFiles[i].header.mipLevels, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 0, VK_ACCESS_TRANSFER_WRITE_BIT));
+	}
+	vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 0, nullptr, static_cast<uint32_t>(barriers.size()), barriers.data());
+
+	for (size_t i = 0; i < cookedCount; i++)
+	{
+		vkCmdCopyBufferToImage(commandBuffer, buffer.getBuffer(), cookedFiles[i].image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, static_cast<uint32_t>(cookedFiles[i].regions.size()), cookedFiles[i].regions.data());
+	}
+
+	barriers.clear();
+	for (size_t i = 0; i < cookedCount; i++)
+	{
+		barriers.push_back(mipBarrier(cookedFiles[i].image, 0, cookedFiles[i].header.mipLevels, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_ACCESS_TRANSFER_WRITE_BIT, VK_ACCESS_SHADER_READ_BIT));
+	}
+	vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_VERTEX_SHADER_BIT | VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, 0, 0, nullptr, 0, nullptr, static_cast<uint32_t>(barriers.size()), barriers.data());
+}
+
+void VTextureLoader::emplaceCooked(VHandlePool<VTexture>& pool, std::vector<VImageHandle>& textures)
+{
+	for (size_t i = 0; i < cookedCount; i++)
+	{
+		CookedFile& cooked = cookedFiles[i];
+		textures.push_back(pool.emplace(vDevice, cooked.image, cooked.memory, static_cast<VkFormat>(cooked.header.format), cooked.header.width, cooked.header.height, cooked.header.mipLevels));
+		if (bindless != nullptr)
+		{
+			pool[textures.back()].registerBindless(*bindless);
+		}
+		cooked.image = VK_NULL_HANDLE;
+		cooked.memory = VK_NULL_HANDLE;
+	}
+}
+
+VBuffer& VTextureLoader::stagingBuffer(VkDeviceSize size)
+{
+	if (!staging || staging->getSize() < size)
+	{
+		staging.reset();
+		staging = std::make_unique<VBuffer>(vDevice, size, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT);
+	}
+	return *staging;
+}
+
+VkCommandBuffer VTextureLoader::beginUpload()
+{
+	if (uploadCommandBuffer == VK_NULL_HANDLE)
+	{
+		VkCommandBufferAllocateInfo allocInfo{};
+		allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+		allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+		allocInfo.commandPool = vDevice.getCommandPool();
+		allocInfo.commandBufferCount = 1;
+		if (vkAllocateCommandBuffers(vDevice.device(), &allocInfo, &uploadCommandBuffer) != VK_SUCCESS)
+		{
+			throw std::runtime_error("failed to allocate texture upload command buffer");
+		}
+
+		VkFenceCreateInfo fenceInfo{};
+		fenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+		if (vkCreateFence(vDevice.device(), &fenceInfo, nullptr, &uploadFence) != VK_SUCCESS)
+		{
+			throw std::runtime_error("failed to create texture upload fence");
+		}
+	}
+
+	// the pool resets command buffers individually, beginning again implicitly resets this one
+	VkCommandBufferBeginInfo beginInfo{};
+	beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+	beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+	vkBeginCommandBuffer(uploadCommandBuffer, &beginInfo);
+	return uploadCommandBuffer;
+}
+
+void VTextureLoader::submit(VkCommandBuffer commandBuffer)
+{
+	vkEndCommandBuffer(commandBuffer);
+
+	VkSubmitInfo submitInfo{};
+	submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+	submitInfo.commandBufferCount = 1;
+	submitInfo.pCommandBuffers = &commandBuffer;
+
+	vkResetFences(vDevice.device(), 1, &uploadFence);
+	if (vkQueueSubmit(vDevice.graphicsQueue(), 1, &submitInfo, uploadFence) != VK_SUCCESS)
+	{
+		throw std::runtime_error("failed to submit texture upload");
+	}
+}
+
+void VTextureLoader::submitAndWait(VkCommandBuffer commandBuffer)
+{
+	// only this submit is waited on, frames already in flight keep going
+	submit(commandBuffer);
+	vkWaitForFences(vDevice.device(), 1, &uploadFence, VK_TRUE, std::numeric_limits<uint64_t>::max());
+}
+
+}
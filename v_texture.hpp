@@ -0,0 +1,144 @@
+#pragma once
+
+#include "VDevice.hpp"
+#include "v_asset_formats.hpp"
+#include "v_bindless.hpp"
+#include "v_buffer.hpp"
+#include "v_jobs.hpp"
+#include "v_handle_pool.hpp"
+
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace vwdw {
+
+	// a sampled, fully mipped 2d image. created by VTextureLoader
+	class VTexture {
+	public:
+		VTexture(VDevice& device, VkImage image, VkDeviceMemory memory, VkFormat format, uint32_t width, uint32_t height, uint32_t mipLevels);
+		~VTexture();
+
+		VTexture(const VTexture&) = delete;
+		VTexture& operator=(const VTexture&) = delete;
+
+		// the handle is released again when the texture is destroyed, so the table must outlive it
+		void registerBindless(VBindlessTable& table);
+
+		VkImage getImage() const { return image; }
+		VkDeviceMemory getMemory() const { return memory; }
+		VkImageView getImageView() const { return imageView; }
+		VkSampler getSampler() const { return sampler; }
+		VkFormat getFormat() const { return format; }
+		uint32_t getWidth() const { return width; }
+		uint32_t getHeight() const { return height; }
+		uint32_t getMipLevels() const { return mipLevels; }
+		VBindlessTable::Handle getBindlessHandle() const { return bindlessHandle; }
+
+	private:
+		void createImageView();
+		void createSampler();
+
+		VDevice& vDevice;
+		VkImage image;
+		VkDeviceMemory memory;
+		VkImageView imageView = VK_NULL_HANDLE;
+		VkSampler sampler = VK_NULL_HANDLE;
+		VkFormat format;
+		uint32_t width;
+		uint32_t height;
+		uint32_t mipLevels;
+
+		VBindlessTable* bindless = nullptr;
+		VBindlessTable::Handle bindlessHandle = VBindlessTable::INVALID_HANDLE;
+	};
+
+	// loads textures in batches: files are decoded on worker threads, then every texture's level 0
+	// upload and mip chain generation (vkCmdBlitImage) is recorded into one command buffer and
+	// submitted once, waiting on a fence instead of idling the queue. the command buffer, fence and
+	// per file storage are kept, so a long lived loader doesn't allocate them again for every batch
+	class VTextureLoader {
+	public:
+		// files are decoded as jobs on jobSystem, or one after another on the calling thread without one
+		VTextureLoader(VDevice& device, VBindlessTable* bindless = nullptr, VJobSystem* jobSystem = nullptr);
+		~VTextureLoader();
+
+		VTextureLoader(const VTextureLoader&) = delete;
+		VTextureLoader& operator=(const VTextureLoader&) = delete;
+
+		// the textures are created in pool, the handles come back in the order of paths.
+		// throws if any file fails to decode, nothing is uploaded in that case
+		std::vector<VImageHandle> loadBatch(const std::vector<std::string>& paths, VHandlePool<VTexture>& pool);
+		// .vtex files from the asset cooker, every mip level is already in the file so there's nothing to blit
+		std::vector<VImageHandle> loadCookedBatch(const std::vector<std::string>& paths, VHandlePool<VTexture>& pool);
+		// the same into textures, which is cleared first. with a reused vector (and loader) nothing but the
+		// textures themselves and the file reads allocate
+		void loadCookedBatch(const std::vector<std::string>& paths, VHandlePool<VTexture>& pool, std::vector<VImageHandle>& textures);
+
+		// streaming, one batch in flight and nothing waited on. startCookedStream() queues the file reads
+		// as a job and returns at once, false while the last batch is still going. pollCookedStream()
+		// records and submits the upload once the reads are done, and is true once its fence signalled,
+		// with the textures in the order of paths. paths has to stay as it is until then. the batch loads
+		// above can't be used while a stream is in flight
+		bool startCookedStream(const std::vector<std::string>& paths);
+		bool pollCookedStream(VHandlePool<VTexture>& pool, std::vector<VImageHandle>& textures);
+		bool streaming() const { return streamState != StreamState::Idle; }
+
+		// frees the staging buffer, it's as big as the biggest batch so far. for after the load time batch
+		void releaseStaging() { staging.reset(); }
+
+		static uint32_t mipLevelsFor(uint32_t width, uint32_t height);
+
+	private:
+		enum class StreamState { Idle, Reading, Uploading };
+
+		struct CookedLevel {
+			const uint8_t* data;
+			uint32_t size;
+		};
+
+		// one file of a cooked batch. only the first cookedCount are in use, the rest keep their storage
+		struct CookedFile {
+			CookedTextureHeader header{};
+			std::vector<uint8_t> bytes;
+			// points into bytes, the size prefixes already stripped
+			std::vector<CookedLevel> levels;
+			std::vector<VkBufferImageCopy> regions;
+			std::string error;
+			VkImage image = VK_NULL_HANDLE;
+			VkDeviceMemory memory = VK_NULL_HANDLE;
+		};
+
+		template <typename F>
+		void parallelFor(size_t count, F&& fn);
+		// reads and splits every file in parallel, failures are left in the files' error
+		void readCookedFiles(const std::vector<std::string>& paths);
+		// creates the images, fills staging and records the copies with their layout transitions
+		void recordCookedUpload(VkCommandBuffer commandBuffer);
+		void emplaceCooked(VHandlePool<VTexture>& pool, std::vector<VImageHandle>& textures);
+		// staging at least size bytes, the old buffer is only replaced when it's too small
+		VBuffer& stagingBuffer(VkDeviceSize size);
+		VkCommandBuffer beginUpload();
+		// submits with the upload fence, without waiting on it
+		void submit(VkCommandBuffer commandBuffer);
+		void submitAndWait(VkCommandBuffer commandBuffer);
+		// the first error of the last read, throws it
+		void throwCookedErrors() const;
+
+		VDevice& vDevice;
+		VBindlessTable* bindless;
+		VJobSystem* jobs;
+
+		VkCommandBuffer uploadCommandBuffer = VK_NULL_HANDLE;
+		VkFence uploadFence = VK_NULL_HANDLE;
+		std::unique_ptr<VBuffer> staging;
+		std::vector<CookedFile> cookedFiles;
+		size_t cookedCount = 0;
+		std::vector<VkImageMemoryBarrier> barriers;
+
+		StreamState streamState = StreamState::Idle;
+		const std::vector<std::string>* streamPaths = nullptr;
+		VJobSystem::Counter streamReads;
+	};
+
+}
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+
+namespace vwdw {
+
+	// single producer, single consumer mailbox that always hands the reader the newest value.
+	// the writer fills its private slot and swaps it with the shared one, the reader swaps the shared
+	// one for its own when a fresh value is waiting. neither side ever blocks or waits on the other,
+	// values the reader never picked up are simply overwritten
+	template<typename T>
+	class VTripleBuffer {
+	public:
+		VTripleBuffer() = default;
+
+		VTripleBuffer(const VTripleBuffer&) = delete;
+		VTripleBuffer& operator=(const VTripleBuffer&) = delete;
+
+		// writer side. the slot still holds whatever was published into it two swaps ago
+		T& writeSlot() { return slots[writeIndex]; }
+		void publish()
+		{
+			uint8_t previous = shared.exchange(static_cast<uint8_t>(writeIndex | FRESH), std::memory_order_acq_rel);
+			writeIndex = previous & INDEX_MASK;
+		}
+
+		// reader side. true when a newer value was swapped in since the last call
+		bool acquire()
+		{
+			if ((shared.load(std::memory_order_relaxed) & FRESH) == 0)
+			{
+				return false;
+			}
+			uint8_t previous = shared.exchange(readIndex, std::memory_order_acq_rel);
+			readIndex = previous & INDEX_MASK;
+			return true;
+		}
+		const T& readSlot() const { return slots[readIndex]; }
+
+	private:
+		static constexpr uint8_t INDEX_MASK = 0x3;
+		static constexpr uint8_t FRESH = 0x4;
+
+		std::array<T, 3> slots{};
+		// the two private indices sit on their own lines so the threads don't share one
+		alignas(64) uint8_t writeIndex = 0;
+		alignas(64) std::atomic<uint8_t> shared{ 1 };
+		alignas(64) uint8_t readIndex = 2;
+	};
+
+}
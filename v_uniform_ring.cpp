@@ -0,0 +1,134 @@
+#include "v_uniform_ring.hpp"
+
+#include <cassert>
+#include <stdexcept>
+
+namespace vwdw {
+
+static VkDeviceSize alignUp(VkDeviceSize value, VkDeviceSize alignment)
+{
+	return (value + alignment - 1) & ~(alignment - 1);
+}
+
+VUniformRing::VUniformRing(VDevice& device, VkDeviceSize bytesPerFrame, const std::vector<VkDeviceSize>& bindingRanges, VkShaderStageFlags stages)
+	: vDevice{ device }, ranges{ bindingRanges }
+{
+	alignment = vDevice.properties.limits.minUniformBufferOffsetAlignment;
+	if (alignment == 0)
+	{
+		alignment = 1;
+	}
+	frameSize = alignUp(bytesPerFrame, alignment);
+
+	createBuffer();
+	createDescriptors(stages);
+}
+
+VUniformRing::~VUniformRing()
+{
+	vkDestroyDescriptorPool(vDevice.device(), descriptorPool, nullptr);
+	vkDestroyDescriptorSetLayout(vDevice.device(), setLayout, nullptr);
+}
+
+void VUniformRing::createBuffer()
+{
+	// coherent isn't required, flush() covers the frame's range when the memory type needs it
+	buffer = std::make_unique<VBuffer>(vDevice, frameSize * VSwapChain::MAX_FRAMES_IN_FLIGHT, VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT);
+	mapped = static_cast<char*>(buffer->getMappedMemory());
+}
+
+void VUniformRing::createDescriptors(VkShaderStageFlags stages)
+{
+	std::vector<VkDescriptorSetLayoutBinding> bindings(ranges.size());
+	for (uint32_t i = 0; i < bindings.size(); i++)
+	{
+		bindings[i].binding = i;
+		bindings[i].descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
+		bindings[i].descriptorCount = 1;
+		bindings[i].stageFlags = stages;
+		bindings[i].pImmutableSamplers = nullptr;
+	}
+
+	VkDescriptorSetLayoutCreateInfo layoutInfo{};
+	layoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+	layoutInfo.bindingCount = static_cast<uint32_t>(bindings.size());
+	layoutInfo.pBindings = bindings.data();
+
+	if (vkCreateDescriptorSetLayout(vDevice.device(), &layoutInfo, nullptr, &setLayout) != VK_SUCCESS)
+	{
+		throw std::runtime_error("failed to create uniform ring descriptor set layout");
+	}
+
+	VkDescriptorPoolSize poolSize{};
+	poolSize.type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
+	poolSize.descriptorCount = static_cast<uint32_t>(bindings.size());
+
+	VkDescriptorPoolCreateInfo poolInfo{};
+	poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+	poolInfo.maxSets = 1;
+	poolInfo.poolSizeCount = 1;
+	poolInfo.pPoolSizes = &poolSize;
+
+	if (vkCreateDescriptorPool(vDevice.device(), &poolInfo, nullptr, &descriptorPool) != VK_SUCCESS)
+	{
+		throw std::runtime_error("failed to create uniform ring descriptor pool");
+	}
+
+	VkDescriptorSetAllocateInfo allocInfo{};
+	allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+	allocInfo.descriptorPool = descriptorPool;
+	allocInfo.descriptorSetCount = 1;
+	allocInfo.pSetLayouts = &setLayout;
+
+	if (vkAllocateDescriptorSets(vDevice.device(), &allocInfo, &descriptorSet) != VK_SUCCESS)
+	{
+		throw std::runtime_error("failed to allocate uniform ring descriptor set");
+	}
+
+	// a single set covers every frame, the frame and the draw are picked by the dynamic offset
+	std::vector<VkDescriptorBufferInfo> bufferInfos(ranges.size());
+	std::vector<VkWriteDescriptorSet> writes(ranges.size());
+	for (uint32_t i = 0; i < ranges.size(); i++)
+	{
+		bufferInfos[i].buffer = buffer->getBuffer();
+		bufferInfos[i].offset = 0;
+		bufferInfos[i].range = ranges[i];
+
+		writes[i] = {};
+		writes[i].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+		writes[i].dstSet = descriptorSet;
+		writes[i].dstBinding = i;
+		writes[i].descriptorCount = 1;
+		writes[i].descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
+		writes[i].pBufferInfo = &bufferInfos[i];
+	}
+	vkUpdateDescriptorSets(vDevice.device(), static_cast<uint32_t>(writes.size()), writes.data(), 0, nullptr);
+}
+
+void VUniformRing::beginFrame(uint32_t frameIndex)
+{
+	assert(frameIndex < VSwapChain::MAX_FRAMES_IN_FLIGHT && "frame index out of range");
+	frameStart = frameSize * frameIndex;
+	head = frameStart;
+}
+
+VUniformRing::Allocation VUniformRing::allocate(VkDeviceSize size)
+{
+	VkDeviceSize offset = alignUp(head, alignment);
+	if (offset + size > frameStart + frameSize)
+	{
+		throw std::runtime_error("uniform ring is out of space for this frame");
+	}
+	head = offset + size;
+	return { mapped + offset, static_cast<uint32_t>(offset) };
+}
+
+void VUniformRing::flush()
+{
+	if (head > frameStart)
+	{
+		buffer->flush(head - frameStart, frameStart);
+	}
+}
+
+}
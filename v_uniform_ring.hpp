@@ -0,0 +1,68 @@
+#pragma once
+
+#include "VDevice.hpp"
+#include "v_buffer.hpp"
+#include "v_swap_chain.hpp"
+
+#include <cstring>
+#include <memory>
+#include <vector>
+
+namespace vwdw {
+
+	// one persistently mapped uniform buffer split into a region per frame in flight.
+	// per draw data is bump allocated out of the current frame's region and bound with a
+	// dynamic offset, so updating an object never maps memory or creates a buffer
+	class VUniformRing {
+	public:
+		struct Allocation {
+			void* data;
+			uint32_t offset; // dynamic offset to bind with
+		};
+
+		// one dynamic uniform buffer binding is made per entry in bindingRanges, all pointing at this ring
+		VUniformRing(VDevice& device, VkDeviceSize bytesPerFrame, const std::vector<VkDeviceSize>& bindingRanges, VkShaderStageFlags stages = VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT);
+		~VUniformRing();
+
+		VUniformRing(const VUniformRing&) = delete;
+		VUniformRing& operator=(const VUniformRing&) = delete;
+
+		// rewinds to the start of frameIndex's region, the caller must already have waited on that frame's fence
+		void beginFrame(uint32_t frameIndex);
+		Allocation allocate(VkDeviceSize size);
+		// makes this frame's writes visible to the device, call before submitting
+		void flush();
+
+		template <typename T>
+		uint32_t push(const T& value)
+		{
+			Allocation alloc = allocate(sizeof(T));
+			std::memcpy(alloc.data, &value, sizeof(T));
+			return alloc.offset;
+		}
+
+		VkDescriptorSetLayout getDescriptorSetLayout() { return setLayout; }
+		VkDescriptorSet getDescriptorSet() { return descriptorSet; }
+		uint32_t bindingCount() const { return static_cast<uint32_t>(ranges.size()); }
+		VkDeviceSize bytesUsed() const { return head - frameStart; }
+
+	private:
+		void createBuffer();
+		void createDescriptors(VkShaderStageFlags stages);
+
+		VDevice& vDevice;
+		std::unique_ptr<VBuffer> buffer;
+		char* mapped = nullptr;
+
+		VkDeviceSize frameSize;
+		VkDeviceSize alignment;
+		VkDeviceSize frameStart = 0;
+		VkDeviceSize head = 0;
+		std::vector<VkDeviceSize> ranges;
+
+		VkDescriptorSetLayout setLayout = VK_NULL_HANDLE;
+		VkDescriptorPool descriptorPool = VK_NULL_HANDLE;
+		VkDescriptorSet descriptorSet = VK_NULL_HANDLE;
+	};
+
+}
@@ -3,11 +3,15 @@
 #include "vwdw_pipeline.hpp"
 
 #include "model.hpp"
+#include "v_frame_arena.hpp"
+#include "v_shader_compiler.hpp"
 
 #include<fstream>
 #include<stdexcept>
 #include<iostream>
 #include <cassert>
+#include <cstring>
+#include <string>
 
 
 namespace vwdw {
@@ -18,10 +22,17 @@ VwdwPipeline::VwdwPipeline(VDevice& device, const PipelineConfigInfo config, con
 }
 
 VwdwPipeline::~VwdwPipeline()
+{
+	destroyShaderModules();
+	vkDestroyPipeline(vdevice.device(), graphicsPipeline, nullptr);
+}
+
+void VwdwPipeline::destroyShaderModules()
 {
 	vkDestroyShaderModule(vdevice.device(), vertShaderMod, nullptr);
 	vkDestroyShaderModule(vdevice.device(), fragShaderMod, nullptr);
-	vkDestroyPipeline(vdevice.device(), graphicsPipeline, nullptr);
+	vertShaderMod = VK_NULL_HANDLE;
+	fragShaderMod = VK_NULL_HANDLE;
 }
 
 std::vector<char> VwdwPipeline::readFile(const std::string& path)
@@ -45,6 +56,36 @@ std::vector<char> VwdwPipeline::readFile(const std::string& path)
 	return buffer;
 }
 
+// OpDecorate <id> SpecId <constantId> anywhere in the module
+static bool declaresSpecConstant(const std::vector<char>& code, uint32_t constantId)
+{
+	std::vector<uint32_t> words(code.size() / 4);
+	std::memcpy(words.data(), code.data(), words.size() * 4);
+	for (size_t pos = 5; pos < words.size();)
+	{
+		uint32_t instructionWords = words[pos] >> 16;
+		if (instructionWords == 0 || pos + instructionWords > words.size())
+		{
+			return false;
+		}
+		if ((words[pos] & 0xFFFF) == 71 && instructionWords >= 4 && words[pos + 2] == 1 && words[pos + 3] == constantId)
+		{
+			return true;
+		}
+		pos += instructionWords;
+	}
+	return false;
+}
+
+std::vector<char> VwdwPipeline::loadShader(VDevice& device, const std::string& path)
+{
+	if (VShaderCompiler* compiler = device.getShaderCompiler())
+	{
+		return compiler->load(path);
+	}
+	return readFile(path);
+}
+
 void VwdwPipeline::createGraphicsPipeline(const PipelineConfigInfo &configInfo, const std::string& vertPath, const std::string& fragPath)
 {
 
@@ -52,14 +93,23 @@ void VwdwPipeline::createGraphicsPipeline(const PipelineConfigInfo &configInfo,
 		configInfo.pipelineLayout != VK_NULL_HANDLE &&
 		"Cannot create graphics pipeline: no pipelineLayout provided in configInfo");
 	assert(
-		configInfo.renderPass != VK_NULL_HANDLE &&
-		"Cannot create graphics pipeline: no renderPass provided in configInfo");
+		(configInfo.renderPass != VK_NULL_HANDLE || configInfo.colorFormat != VK_FORMAT_UNDEFINED) &&
+		"Cannot create graphics pipeline: no renderPass or attachment formats provided in configInfo");
 
-	auto vertCode = readFile(vertPath);
-	auto fragCode = readFile(fragPath);
+	auto vertCode = loadShader(vdevice, vertPath);
 
-	auto bindingdesc = VModel::Vertex::getBindingDescriptions();
-	auto attrdesc = VModel::Vertex::getAttributeDescriptions();
+	VScratchArena<512> scratch;
+	auto bindingdesc = VModel::Vertex::getBindingDescriptions(&scratch);
+	auto attrdesc = VModel::Vertex::getAttributeDescriptions(&scratch);
+	if (configInfo.positionOnly)
+	{
+		attrdesc.resize(1);
+	}
+	if (configInfo.vertexPulling)
+	{
+		bindingdesc.clear();
+		attrdesc.clear();
+	}
 	VkPipelineVertexInputStateCreateInfo vertexInputInfo{};
 	vertexInputInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
 	vertexInputInfo.vertexAttributeDescriptionCount = static_cast<uint32_t>(attrdesc.size());
@@ -67,12 +117,43 @@ void VwdwPipeline::createGraphicsPipeline(const PipelineConfigInfo &configInfo,
 	vertexInputInfo.pVertexAttributeDescriptions = attrdesc.data(); //binding location offset format are the 4 pieces of info needed
 	vertexInputInfo.pVertexBindingDescriptions = bindingdesc.data();
 
-	createShaderMod(vertCode, &vertShaderMod);
-	createShaderMod(fragCode, &fragShaderMod);
+	std::vector<char> fragCode;
+	if (!fragPath.empty())
+	{
+		fragCode = loadShader(vdevice, fragPath);
+	}
+	// a constant neither stage declares is silently ignored by the driver, and the variant it was
+	// meant to make would be the same pipeline as the default one. usually a stale module
+	for (uint32_t i = 0; i < configInfo.specializationInfo.mapEntryCount; i++)
+	{
+		uint32_t constantId = configInfo.specializationInfo.pMapEntries[i].constantID;
+		if (!declaresSpecConstant(vertCode, constantId) && !declaresSpecConstant(fragCode, constantId))
+		{
+			throw std::runtime_error("specialization constant " + std::to_string(constantId) + " isn't declared by " + vertPath
+				+ (fragPath.empty() ? "" : " or " + fragPath));
+		}
+	}
+
+	createShaderMod(vdevice, vertCode, &vertShaderMod);
+	uint32_t stageCount = 1;
+	if (!fragPath.empty())
+	{
+		try
+		{
+			createShaderMod(vdevice, fragCode, &fragShaderMod);
+		}
+		catch (...)
+		{
+			destroyShaderModules();
+			throw;
+		}
+		stageCount = 2;
+	}
 
 
 
 
+	const VkSpecializationInfo* specializationInfo = configInfo.specializationInfo.mapEntryCount > 0 ? &configInfo.specializationInfo : nullptr;
 	VkPipelineShaderStageCreateInfo shaderStages[2];
 	shaderStages[0].stage = VK_SHADER_STAGE_VERTEX_BIT;
 	shaderStages[0].sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
@@ -80,19 +161,19 @@ void VwdwPipeline::createGraphicsPipeline(const PipelineConfigInfo &configInfo,
 	shaderStages[0].module = vertShaderMod;
 	shaderStages[0].flags = 0;
 	shaderStages[0].pName = "main";
-	shaderStages[0].pSpecializationInfo = nullptr;
+	shaderStages[0].pSpecializationInfo = specializationInfo;
 	shaderStages[1].module = fragShaderMod;
 	shaderStages[1].sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
 	shaderStages[1].stage = VK_SHADER_STAGE_FRAGMENT_BIT;
 	shaderStages[1].pNext = nullptr;
 	shaderStages[1].flags = 0;
-	shaderStages[1].pSpecializationInfo = nullptr;
+	shaderStages[1].pSpecializationInfo = specializationInfo;
 	shaderStages[1].pName = "main";
 
 
 	VkGraphicsPipelineCreateInfo pipelineInfo{};
 	pipelineInfo.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
-	pipelineInfo.stageCount = 2;
+	pipelineInfo.stageCount = stageCount;
 	pipelineInfo.pStages = shaderStages;
 	pipelineInfo.pVertexInputState = &vertexInputInfo;
 	pipelineInfo.pDynamicState = &configInfo.dynamicStateInfo;
@@ -107,29 +188,41 @@ void VwdwPipeline::createGraphicsPipeline(const PipelineConfigInfo &configInfo,
 	pipelineInfo.renderPass = configInfo.renderPass;
 	pipelineInfo.subpass = configInfo.subpass;
 
+	// without a render pass the pipeline is only tied to formats, so it survives swapchain recreation
+	VkPipelineRenderingCreateInfoKHR renderingInfo{};
+	if (configInfo.renderPass == VK_NULL_HANDLE)
+	{
+		renderingInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_RENDERING_CREATE_INFO_KHR;
+		renderingInfo.colorAttachmentCount = 1;
+		renderingInfo.pColorAttachmentFormats = &configInfo.colorFormat;
+		renderingInfo.depthAttachmentFormat = configInfo.depthFormat;
+		pipelineInfo.pNext = &renderingInfo;
+	}
+
 	pipelineInfo.basePipelineIndex = -1;
 	pipelineInfo.basePipelineHandle = VK_NULL_HANDLE;
 
 	if (vkCreateGraphicsPipelines(
 		vdevice.device(),
-		VK_NULL_HANDLE,
+		vdevice.getPipelineCache(),
 		1,
 		&pipelineInfo,
 		nullptr,
 		&graphicsPipeline) != VK_SUCCESS) {
+		destroyShaderModules();
 		throw std::runtime_error("failed to create graphics pipeline");
 	}
 
 }
 
-void VwdwPipeline::createShaderMod(const std::vector<char>& code, VkShaderModule* shaderMod)
+void VwdwPipeline::createShaderMod(VDevice& device, const std::vector<char>& code, VkShaderModule* shaderMod)
 {
 	VkShaderModuleCreateInfo createInfo{};
 	createInfo.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
 	createInfo.codeSize = code.size();
 	createInfo.pCode = reinterpret_cast<const uint32_t*>(code.data()); // only works for Vectors, will be invalid cast with C arrays
 
-	if (vkCreateShaderModule(vdevice.device(), &createInfo, nullptr, shaderMod) != VK_SUCCESS)
+	if (vkCreateShaderModule(device.device(), &createInfo, nullptr, shaderMod) != VK_SUCCESS)
 	{
 		throw std::runtime_error("Failed to create Shader Module");
 	}
@@ -210,7 +303,7 @@ void VwdwPipeline::defaultConfig(PipelineConfigInfo &configInfo)
 	configInfo.depthStencilInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_DEPTH_STENCIL_STATE_CREATE_INFO;
 	configInfo.depthStencilInfo.depthCompareOp = VK_COMPARE_OP_LESS;
 	configInfo.depthStencilInfo.depthBoundsTestEnable = VK_FALSE;
-	configInfo.depthStencilInfo.depthWriteEnable = VK_FALSE;
+	configInfo.depthStencilInfo.depthWriteEnable = VK_TRUE;
 	configInfo.depthStencilInfo.maxDepthBounds = 1.0f;
 	configInfo.depthStencilInfo.minDepthBounds = 0.0f;
 	configInfo.depthStencilInfo.front = {};
@@ -224,6 +317,23 @@ void VwdwPipeline::defaultConfig(PipelineConfigInfo &configInfo)
 
 }
 
+void VwdwPipeline::depthPrepassConfig(PipelineConfigInfo &configInfo)
+{
+	defaultConfig(configInfo);
+	configInfo.positionOnly = true;
+	configInfo.colorBlendAttachment.colorWriteMask = 0;
+	configInfo.depthStencilInfo.depthWriteEnable = VK_TRUE;
+	configInfo.depthStencilInfo.depthCompareOp = VK_COMPARE_OP_LESS;
+}
+
+void VwdwPipeline::depthEqualConfig(PipelineConfigInfo &configInfo)
+{
+	defaultConfig(configInfo);
+	// depth is already final, writing it again would only cost bandwidth
+	configInfo.depthStencilInfo.depthWriteEnable = VK_FALSE;
+	configInfo.depthStencilInfo.depthCompareOp = VK_COMPARE_OP_EQUAL;
+}
+
 void VwdwPipeline::bind(VkCommandBuffer commandbuffer)
 {
 	vkCmdBindPipeline(commandbuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, graphicsPipeline);
@@ -24,11 +24,21 @@ namespace vwdw {
 		VkPipelineLayout pipelineLayout = nullptr;
 		VkRenderPass renderPass = nullptr;
 		uint32_t subpass = 0;
+		// dynamic rendering: leave renderPass null and give the attachment formats instead
+		VkFormat colorFormat = VK_FORMAT_UNDEFINED;
+		VkFormat depthFormat = VK_FORMAT_UNDEFINED;
+		// only the position attribute is fed to the vertex shader
+		bool positionOnly = false;
+		// no vertex buffers, the vertex shader fetches from storage buffers by gl_VertexIndex / gl_InstanceIndex
+		bool vertexPulling = false;
+		// shared by both stages, each stage only picks up the constant ids it declares. empty by default
+		VkSpecializationInfo specializationInfo{};
 
 	};
 
 	class VwdwPipeline {
 	public:
+		// an empty fragPath builds a vertex only pipeline
 		VwdwPipeline(VDevice& device, const PipelineConfigInfo config, const std::string& vertPath, const std::string& fragPath);
 		~VwdwPipeline();
 
@@ -37,21 +47,30 @@ namespace vwdw {
 		VwdwPipeline() = default;
 
 		static void defaultConfig(PipelineConfigInfo &config);
+		// depth pre-pass: writes depth, no color, no fragment shader needed
+		static void depthPrepassConfig(PipelineConfigInfo &config);
+		// main pass after a pre-pass: only the front most fragment passes the EQUAL test, so each pixel is shaded once
+		static void depthEqualConfig(PipelineConfigInfo &config);
 
 		void bind(VkCommandBuffer commandbuffer);
 
-	private:
+		// shared with the compute pipelines
 		static std::vector<char> readFile(const std::string& path);
+		// spir-v for a stage: .spv files as they are, glsl through the device's shader compiler
+		static std::vector<char> loadShader(VDevice& device, const std::string& path);
+		static void createShaderMod(VDevice& device, const std::vector<char>& code, VkShaderModule* shaderMod);
 
+	private:
 		void createGraphicsPipeline(const PipelineConfigInfo &config, const std::string& vertPath, const std::string& fragPath);
-
-		void createShaderMod(const std::vector<char>& code, VkShaderModule* shaderMod);
+		// the destructor doesn't run when the constructor throws, so a failed create cleans up with this
+		void destroyShaderModules();
 
 		VDevice& vdevice;
 
 		VkPipeline graphicsPipeline;
-		VkShaderModule vertShaderMod;
-		VkShaderModule fragShaderMod;
+		VkShaderModule vertShaderMod = VK_NULL_HANDLE;
+		// null for vertex only pipelines
+		VkShaderModule fragShaderMod = VK_NULL_HANDLE;
 
 };
 